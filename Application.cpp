@@ -8,21 +8,75 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <iostream>
 #include <string>
+#include <vector>
+
+namespace
+{
+    struct HdrFormatInfo
+    {
+        const char* name;
+        GLenum internalFormat;
+        int bytesPerPixel;
+        double minNormal;
+    };
+
+    // Indexed by Application::HdrFormat
+    const HdrFormatInfo kHdrFormats[] =
+    {
+        {"RGBA32F", GL_RGBA32F, 16, FLT_MIN},
+        {"RGBA16F", GL_RGBA16F, 8, 6.103515625e-5}, // 2^-14
+        {"R11F_G11F_B10F", GL_R11F_G11F_B10F, 4, 6.103515625e-5}, // Same exponent as half floats, with 6 or 5 bit mantissas and no sign
+    };
+
+    // One tile of the night noise, in x and y, and a full turn of the rotation of its gradients, in z
+    constexpr int kNoiseVolumeSize = 256;
+    constexpr int kNoiseVolumeLayers = 64;
+    constexpr float kNoiseVolumePeriod = 4.0f; // In noise units, 8 texels per period of the finest octave
+
+    double Luminance(const float* rgb)
+    {
+        return 0.2126 * rgb[0] + 0.7152 * rgb[1] + 0.0722 * rgb[2];
+    }
+}
 
 Application::Application(int width, int height, Window* window)
-    : m_camera()
+    : m_profiler()
+    , m_camera()
     , m_previousCursorPosition()
-    , m_physicalSky()
+    , m_physicalSky(window->GetSharedContextWindow(), window->IsHeadless() ? "" : "./cache/atmosphere") // Benchmarks always precompute the atmosphere
     , m_window(window)
+    , m_hdrFramebuffer(GL_NONE)
+    , m_hdrTexture(GL_NONE)
+    , m_depthRenderbuffer(GL_NONE)
+    , m_hdrFormat(HdrFormat::RGBA32F) // The night sky can be below the normal range of the smaller formats, see the Precision Report
+    , m_hdrWidth(0)
+    , m_hdrHeight(0)
+    , m_hdrPrecisionReportRequested(false)
+    , m_hdrMinLuminance(0.0)
+    , m_hdrMaxLuminance(0.0)
+    , m_hdrPrecisionResults()
     , m_exposure(-2.0f)
     , m_max_white(1e6f)
+    , m_autoExposure()
+    , m_autoExposureEnable(false)
+    , m_keyValue(0.18f)
+    , m_exposureCompensation(0.0f)
+    , m_adaptationTime(0.5f)
+    , m_previousTime(window->GetTime())
+    , m_deltaTime(0.0f)
     , m_displayMode(DisplayMode::DAY)
     , m_blueTint(0.1f, 0.1f, 0.5f)
     , m_noiseScale(50.0f)
     , m_noiseStrength(0.005f)
     , m_noiseSpeed(10.0f)
+    , m_noiseVolumeEnable(false)
+    , m_noiseVolume(GL_NONE)
+    , m_noiseBakeShader()
     , m_mesopicRangeStart(0.0f)
     , m_mesopicRangeEnd(0.01f)
 {
@@ -40,15 +94,12 @@ Application::Application(int width, int height, Window* window)
     glBlendEquation(GL_FUNC_ADD);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    OnFramebufferSize(width, height);
-
-    // FRAMEBUFFER STUFF
+    // FRAMEBUFFER STUFF (allocated by OnFramebufferSize)
     glGenFramebuffers(1, &m_hdrFramebuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, m_hdrFramebuffer);
 
     glGenTextures(1, &m_hdrTexture);
     glBindTexture(GL_TEXTURE_2D, m_hdrTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 1920, 1080, 0, GL_RGBA, GL_FLOAT, nullptr); // TODO: Correct width and height parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -57,8 +108,10 @@ Application::Application(int width, int height, Window* window)
 
     glGenRenderbuffers(1, &m_depthRenderbuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, 1920, 1080);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER , m_depthRenderbuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+
+    OnFramebufferSize(width, height);
 
     // POSTPROCESS STUFF
     ShaderStage vertexShader = ShaderStage();
@@ -74,6 +127,15 @@ Application::Application(int width, int height, Window* window)
     m_postprocessShader.AttachShader(fragmentShader.m_id);
     m_postprocessShader.Build();
 
+    ShaderStage noiseBakeFragmentShader = ShaderStage();
+    noiseBakeFragmentShader.Create(ShaderType::FRAGMENT);
+    noiseBakeFragmentShader.Compile("./resources/shaders/noise_bake.frag", "./resources/shaders");
+
+    m_noiseBakeShader.Create();
+    m_noiseBakeShader.AttachShader(vertexShader.m_id);
+    m_noiseBakeShader.AttachShader(noiseBakeFragmentShader.m_id);
+    m_noiseBakeShader.Build();
+
     // BUFFERS STUFF
     glGenVertexArrays(1, &m_fullScreenQuadVao);
     glBindVertexArray(m_fullScreenQuadVao);
@@ -98,9 +160,64 @@ Application::~Application()
 {
     // glDeleteFramebuffers(1, &m_hdrFramebuffer);
     // glDeleteTextures();
+    glDeleteTextures(1, &m_noiseVolume);
     std::cout << "Destroying Application" << std::endl;
 }
 
+// Maps the adapted luminance to the key value, until the first statistics are read back
+float Application::ComputeExposure() const
+{
+    if (!m_autoExposureEnable || !m_autoExposure.HasStatistics()) return glm::pow(10.0f, m_exposure);
+    double k = std::pow(10.0, m_exposureCompensation) * m_keyValue / std::max(m_autoExposure.GetAdaptedLuminance(), 1e-12);
+    return static_cast<float>(k);
+}
+
+// The adapted maximum luminance of the frame is mapped to white
+float Application::ComputeWhitePoint() const
+{
+    if (!m_autoExposureEnable || !m_autoExposure.HasStatistics()) return m_max_white;
+    return std::max(ComputeExposure() * static_cast<float>(m_autoExposure.GetAdaptedMaxLuminance()), 1.0f);
+}
+
+// The noise does not depend on its scale and speed, which are applied when sampling it
+void Application::BakeNoiseVolume()
+{
+    glDeleteTextures(1, &m_noiseVolume); // When baked again
+    glGenTextures(1, &m_noiseVolume);
+    glBindTexture(GL_TEXTURE_3D, m_noiseVolume);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R16F, kNoiseVolumeSize, kNoiseVolumeSize, kNoiseVolumeLayers, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    GLint viewportData[4];
+    glGetIntegerv(GL_VIEWPORT, viewportData);
+    GLint drawFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+    glDisable(GL_BLEND);
+
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, kNoiseVolumeSize, kNoiseVolumeSize);
+    glBindVertexArray(m_fullScreenQuadVao);
+    m_noiseBakeShader.Use();
+    m_noiseBakeShader.SetFloat("Period", kNoiseVolumePeriod);
+    for (int layer = 0; layer < kNoiseVolumeLayers; ++layer)
+    {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_noiseVolume, 0, layer);
+        m_noiseBakeShader.SetFloat("Alpha", 2.0f * glm::pi<float>() * layer / kNoiseVolumeLayers);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    glViewport(viewportData[0], viewportData[1], viewportData[2], viewportData[3]);
+    glEnable(GL_BLEND);
+}
+
 void Application::OnCursorPos(double xpos, double ypos)
 {
     glm::vec2 currentCursorPosition = glm::vec2(xpos, ypos);
@@ -121,27 +238,174 @@ void Application::OnFramebufferSize(int width, int height)
     m_resolution = glm::vec3(width, height, 0.0);
     glViewport(0, 0, width, height);
     m_camera.SetAspectRatio(static_cast<float>(width) / static_cast<float>(height));
+
+    // Minimized windows have an empty framebuffer, the previous one is kept
+    if (width > 0 && height > 0)
+    {
+        m_hdrWidth = width;
+        m_hdrHeight = height;
+        AllocateHdrFramebuffer();
+    }
+
     GLenum errorCode = glGetError();
     if (errorCode != GL_NO_ERROR) std::cerr << "GL error after resize" << std::endl;
 }
 
+// Sized to the default framebuffer, in the selected format
+void Application::AllocateHdrFramebuffer()
+{
+    const HdrFormatInfo& format = kHdrFormats[static_cast<int>(m_hdrFormat)];
+
+    glBindTexture(GL_TEXTURE_2D, m_hdrTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format.internalFormat, m_hdrWidth, m_hdrHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_hdrWidth, m_hdrHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_hdrFramebuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) std::cerr << "[OpenGL] E: HDR framebuffer is not complete." << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+}
+
+// Renders the frame into a RGBA32F target and converts it to the smaller formats (on the GPU, as when rendering into
+// them), to check whether the dimmest luminances of the night sky survive them. Blending in the smaller formats is ignored.
+void Application::ComputeHdrPrecisionReport()
+{
+    int width = m_hdrWidth;
+    int height = m_hdrHeight;
+    std::size_t numPixels = static_cast<std::size_t>(width) * height;
+
+    auto createTarget = [width, height](GLenum internalFormat, GLuint& texture, GLuint& framebuffer)
+    {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    };
+
+    GLuint referenceTexture;
+    GLuint referenceFramebuffer;
+    createTarget(GL_RGBA32F, referenceTexture, referenceFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    Profiler unmeasured; // Disabled, so that this additional frame is not profiled
+    m_physicalSky.Render(m_camera, unmeasured);
+
+    std::vector<float> reference(numPixels * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, reference.data());
+
+    m_hdrMinLuminance = DBL_MAX;
+    m_hdrMaxLuminance = 0.0;
+    for (std::size_t i = 0; i < numPixels; ++i)
+    {
+        double luminance = Luminance(&reference[4 * i]);
+        if (luminance > 0.0) m_hdrMinLuminance = std::min(m_hdrMinLuminance, luminance);
+        m_hdrMaxLuminance = std::max(m_hdrMaxLuminance, luminance);
+    }
+    if (m_hdrMinLuminance == DBL_MAX) m_hdrMinLuminance = 0.0;
+
+    m_hdrPrecisionResults.clear();
+    std::vector<float> converted(numPixels * 4);
+    for (HdrFormat hdrFormat : {HdrFormat::RGBA16F, HdrFormat::R11F_G11F_B10F})
+    {
+        const HdrFormatInfo& format = kHdrFormats[static_cast<int>(hdrFormat)];
+        GLuint texture;
+        GLuint framebuffer;
+        createTarget(format.internalFormat, texture, framebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, referenceFramebuffer);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, converted.data());
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &texture);
+
+        HdrPrecisionResult result = {format.name, 0.0, 0.0, 0.0, 0.0};
+        double squaredError = 0.0;
+        double squaredReference = 0.0;
+        std::size_t numNonZero = 0;
+        for (std::size_t i = 0; i < numPixels; ++i)
+        {
+            double referenceLuminance = Luminance(&reference[4 * i]);
+            double luminance = Luminance(&converted[4 * i]);
+            squaredError += (luminance - referenceLuminance) * (luminance - referenceLuminance);
+            squaredReference += referenceLuminance * referenceLuminance;
+            if (referenceLuminance <= 0.0) continue;
+
+            ++numNonZero;
+            result.maxRelativeError = std::max(result.maxRelativeError, std::abs(luminance - referenceLuminance) / referenceLuminance);
+            if (luminance <= 0.0) result.lostFraction += 1.0;
+            if (referenceLuminance < format.minNormal) result.subnormalFraction += 1.0;
+        }
+        result.relativeRmsError = squaredReference > 0.0 ? std::sqrt(squaredError / squaredReference) : 0.0;
+        if (numNonZero > 0)
+        {
+            result.lostFraction /= numNonZero;
+            result.subnormalFraction /= numNonZero;
+        }
+        m_hdrPrecisionResults.push_back(result);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+    glDeleteFramebuffers(1, &referenceFramebuffer);
+    glDeleteTextures(1, &referenceTexture);
+}
+
 void Application::OnScroll(double xoffset, double yoffset)
 {
     m_camera.OnScroll(static_cast<int>(yoffset));
 }
 
+Profiler& Application::GetProfiler()
+{
+    return m_profiler;
+}
+
+Camera& Application::GetCamera()
+{
+    return m_camera;
+}
+
+PhysicalSky& Application::GetPhysicalSky()
+{
+    return m_physicalSky;
+}
+
 void Application::OnUpdate()
 {
     ImGui::ShowDemoWindow();
     ImGui::ShowMetricsWindow();
+    m_profiler.ShowWindow();
+
+    float time = m_window->GetTime();
+    m_deltaTime = std::max(time - m_previousTime, 0.0f);
+    m_previousTime = time;
 
     m_camera.OnUpdate();
-    m_physicalSky.Update();
+    m_physicalSky.Update(m_deltaTime);
 
     if (ImGui::Begin("Postprocess"))
     {
-        ImGui::SliderFloat("Exposure", &m_exposure, -5.0f, 5.0f);
-        ImGui::SliderFloat("White Point", &m_max_white, 0.0f, 1e6f, "%.3f", ImGuiSliderFlags_Logarithmic);
+        ImGui::Checkbox("Auto Exposure", &m_autoExposureEnable);
+        if (m_autoExposureEnable)
+        {
+            ImGui::SliderFloat("Key Value", &m_keyValue, 0.01f, 1.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
+            ImGui::SliderFloat("Exposure Compensation", &m_exposureCompensation, -2.0f, 2.0f);
+            ImGui::SliderFloat("Adaptation Time", &m_adaptationTime, 0.0f, 10.0f);
+            ImGui::Text("k: %.3e, White Point: %.3e", ComputeExposure(), ComputeWhitePoint());
+        }
+        else
+        {
+            ImGui::SliderFloat("Exposure", &m_exposure, -5.0f, 5.0f);
+            ImGui::SliderFloat("White Point", &m_max_white, 0.0f, 1e6f, "%.3f", ImGuiSliderFlags_Logarithmic);
+        }
+        if (m_autoExposure.HasStatistics())
+        {
+            const AutoExposure::Statistics& statistics = m_autoExposure.GetStatistics();
+            ImGui::Text("Photopic | Min: %.3e, Max: %.3e, Avg: %.3e", statistics.minPhotopic, statistics.maxPhotopic, statistics.averagePhotopic);
+            ImGui::Text("Scotopic | Min: %.3e, Max: %.3e, Avg: %.3e", statistics.minScotopic, statistics.maxScotopic, statistics.averageScotopic);
+        }
         ImGui::RadioButton("Day", reinterpret_cast<int*>(&m_displayMode), static_cast<int>(DisplayMode::DAY)); ImGui::SameLine();
         ImGui::RadioButton("Night", reinterpret_cast<int*>(&m_displayMode), static_cast<int>(DisplayMode::NIGHT)); ImGui::SameLine();
         ImGui::RadioButton("Photopic Luminance", reinterpret_cast<int*>(&m_displayMode), static_cast<int>(DisplayMode::PHOTOPIC_LUMINANCE)); ImGui::SameLine();
@@ -152,10 +416,31 @@ void Application::OnUpdate()
             ImGui::SliderFloat("Noise Scale", &m_noiseScale, 0.0f, 200.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
             ImGui::SliderFloat("Noise Strength", &m_noiseStrength, 0.0f, 1.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
             ImGui::SliderFloat("Noise Speed", &m_noiseSpeed, 0.0f, 20.0f);
+            ImGui::Checkbox("Baked Noise", &m_noiseVolumeEnable);
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("One fetch of a tiling 3D texture instead of four octaves of analytic noise");
             ImGui::SliderFloat("Mesopic Range Start", &m_mesopicRangeStart, 0.0f, 1.0f);
             ImGui::SliderFloat("Mesopic Range End", &m_mesopicRangeEnd, 0.0f, 1.0f);
             if (m_mesopicRangeStart > m_mesopicRangeEnd) m_mesopicRangeStart = m_mesopicRangeEnd;
         }
+
+        ImGui::Separator();
+        ImGui::Text("HDR Format"); ImGui::SameLine();
+        bool hdrFormatChanged = false;
+        for (int format = 0; format < 3; ++format)
+        {
+            if (format > 0) ImGui::SameLine();
+            hdrFormatChanged |= ImGui::RadioButton(kHdrFormats[format].name, reinterpret_cast<int*>(&m_hdrFormat), format);
+        }
+        if (hdrFormatChanged) AllocateHdrFramebuffer();
+        const HdrFormatInfo& hdrFormat = kHdrFormats[static_cast<int>(m_hdrFormat)];
+        ImGui::Text("HDR Target: %dx%d, %.1f MB", m_hdrWidth, m_hdrHeight, static_cast<double>(m_hdrWidth) * m_hdrHeight * hdrFormat.bytesPerPixel / (1024.0 * 1024.0));
+        if (ImGui::Button("Precision Report")) m_hdrPrecisionReportRequested = true;
+        if (!m_hdrPrecisionResults.empty())
+        {
+            ImGui::Text("Luminance | Min: %.3e, Max: %.3e", m_hdrMinLuminance, m_hdrMaxLuminance);
+            for (const HdrPrecisionResult& result : m_hdrPrecisionResults)
+                ImGui::Text("%s | RMS Rel: %.3e, Max Rel: %.3e, Lost: %.2f%%, Subnormal: %.2f%%", result.format, result.relativeRmsError, result.maxRelativeError, 100.0 * result.lostFraction, 100.0 * result.subnormalFraction);
+        }
     }
     ImGui::End();
 
@@ -173,20 +458,33 @@ void Application::OnUpdate()
 
 void Application::OnRender()
 {
+    if (m_hdrPrecisionReportRequested)
+    {
+        ComputeHdrPrecisionReport();
+        m_hdrPrecisionReportRequested = false;
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, m_hdrFramebuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    m_physicalSky.Render(m_camera);
+    m_physicalSky.Render(m_camera, m_profiler);
+
+    {
+        Profiler::Scope autoExposureScope(m_profiler, "Auto Exposure");
+        m_autoExposure.Reduce(m_hdrTexture, m_fullScreenQuadVao);
+    }
+    m_autoExposure.Update(m_deltaTime, m_adaptationTime);
 
     glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    Profiler::Scope postprocessScope(m_profiler, "Postprocess");
     m_postprocessShader.Use();
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, m_hdrTexture);
     m_postprocessShader.SetInt("hdrTexture", 0);
-    m_postprocessShader.SetFloat("k", glm::pow(10.0f, m_exposure));
-    m_postprocessShader.SetFloat("L_white", m_max_white);
+    m_postprocessShader.SetFloat("k", ComputeExposure());
+    m_postprocessShader.SetFloat("L_white", ComputeWhitePoint());
 
     m_postprocessShader.SetFloat("AspectRatio", m_resolution.x / m_resolution.y);
     m_postprocessShader.SetFloat("Time", m_window->GetTime());
@@ -195,6 +493,18 @@ void Application::OnRender()
     m_postprocessShader.SetFloat("NoiseScale", m_noiseScale);
     m_postprocessShader.SetFloat("NoiseStrength", m_noiseStrength);
     m_postprocessShader.SetFloat("NoiseSpeed", m_noiseSpeed);
+    bool useNoiseVolume = m_noiseVolumeEnable && m_displayMode == DisplayMode::NIGHT;
+    if (useNoiseVolume)
+    {
+        if (m_noiseVolume == GL_NONE) BakeNoiseVolume();
+        m_postprocessShader.Use();
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_3D, m_noiseVolume);
+        glActiveTexture(GL_TEXTURE0);
+        m_postprocessShader.SetInt("NoiseVolume", 1);
+        m_postprocessShader.SetFloat("NoiseVolumePeriod", kNoiseVolumePeriod);
+    }
+    m_postprocessShader.SetBool("UseNoiseVolume", useNoiseVolume);
     m_postprocessShader.SetVec3("MesopicRange", glm::vec3(m_mesopicRangeStart, m_mesopicRangeEnd, 0.0f));
 
     m_postprocessShader.SetInt("Mode", static_cast<int>(m_displayMode));
@@ -1,13 +1,16 @@
 #pragma once
 
+#include "AutoExposure.h"
 #include "Camera.h"
 #include "PhysicalSky.h"
+#include "Profiler.h"
 class Window;
 #include "ShaderProgram.h"
 
 #include <glm/glm.hpp>
 
 #include <memory>
+#include <vector>
 
 class Application
 {
@@ -20,9 +23,30 @@ public:
     void OnMouseButton(int button, int action, int mods);
     void OnScroll(double xoffset, double yoffset);
     void OnFramebufferSize(int width, int height);
+    Profiler& GetProfiler();
+    Camera& GetCamera();
+    PhysicalSky& GetPhysicalSky();
 private:
     enum class DisplayMode {DAY, NIGHT, PHOTOPIC_LUMINANCE, SCOTOPIC_LUMINANCE};
+    enum class HdrFormat {RGBA32F, RGBA16F, R11F_G11F_B10F};
+
+    // Of the photopic luminance of a frame stored in a smaller HDR format, with respect to RGBA32F
+    struct HdrPrecisionResult
+    {
+        const char* format;
+        double relativeRmsError;
+        double maxRelativeError; // Of the pixels with a non-zero luminance
+        double lostFraction; // Pixels with a non-zero luminance stored as zero
+        double subnormalFraction; // Pixels with a luminance below the smallest normal value of the format
+    };
+private:
+    void AllocateHdrFramebuffer();
+    void ComputeHdrPrecisionReport();
+    float ComputeExposure() const;
+    float ComputeWhitePoint() const;
+    void BakeNoiseVolume();
 private:
+    Profiler m_profiler;
     Camera m_camera;
     glm::vec2 m_previousCursorPosition;
     PhysicalSky m_physicalSky;
@@ -32,6 +56,13 @@ private:
     GLuint m_hdrFramebuffer;
     GLuint m_hdrTexture;
     GLuint m_depthRenderbuffer;
+    HdrFormat m_hdrFormat;
+    int m_hdrWidth;
+    int m_hdrHeight;
+    bool m_hdrPrecisionReportRequested;
+    double m_hdrMinLuminance; // Smallest non-zero luminance of the frame of the precision report
+    double m_hdrMaxLuminance;
+    std::vector<HdrPrecisionResult> m_hdrPrecisionResults;
     ShaderProgram m_postprocessShader;
     GLuint m_fullScreenQuadVao;
     GLuint m_fullScreenQuadVbo;
@@ -42,11 +73,23 @@ private:
     float m_exposure;
     float m_max_white;
 
+    // Auto Exposure
+    AutoExposure m_autoExposure;
+    bool m_autoExposureEnable;
+    float m_keyValue; // Middle gray the adapted luminance is mapped to
+    float m_exposureCompensation; // In decades
+    float m_adaptationTime; // Seconds
+    float m_previousTime;
+    float m_deltaTime; // Seconds, of the last update
+
     // Night Tonemapper
     glm::vec3 m_blueTint;
     float m_noiseScale;
     float m_noiseStrength;
     float m_noiseSpeed;
+    bool m_noiseVolumeEnable;
+    GLuint m_noiseVolume; // Baked the first time it is enabled
+    ShaderProgram m_noiseBakeShader;
     float m_mesopicRangeStart;
     float m_mesopicRangeEnd;
 };
\ No newline at end of file
@@ -1,9 +1,23 @@
 #include "AstronomicalPositioning.h"
+#include "EphemerisMath.h"
 
 #include <imgui.h>
 
 #include <glm/gtc/type_ptr.hpp>
 
+namespace
+{
+    glm::dvec3 ToGlm(const EphemerisMath::Vector3<double>& v)
+    {
+        return glm::dvec3(v.x, v.y, v.z);
+    }
+
+    EphemerisMath::Vector3<double> FromGlm(const glm::dvec3& v)
+    {
+        return {v.x, v.y, v.z};
+    }
+}
+
 AstronomicalPositioning::AstronomicalPositioning()
     : m_M(10)
     , m_D(10)
@@ -14,28 +28,66 @@ AstronomicalPositioning::AstronomicalPositioning()
     , m_JD(2459862.750382)
     , m_lonDeg(2.1686)
     , m_latDeg(41.3874)
+    , m_ephemeris()
+    , m_ephemerisTable()
+    , m_clockRunning(false)
+    , m_timeScale(60.0f)
+    , m_interpolated(false)
     , m_lon(0.0378)
     , m_lat(0.7223)
 {
+    m_JD = ComputeJulianDate(m_M, m_D, m_Y, m_h, m_m, m_s, 0.0);
     Compute();
 }
 
-void AstronomicalPositioning::Update()
+// Only computes the positions again when the time, the observer or the tier change
+void AstronomicalPositioning::Update(float deltaTime)
 {
+    bool changed = false;
+    if (m_clockRunning && deltaTime > 0.0f)
+    {
+        m_JD += static_cast<double>(deltaTime) * m_timeScale / 86400.0;
+        ComputeDateTime();
+        changed = true;
+    }
+
     if (ImGui::Begin("Celestial Bodies Positioning"))
     {
-        ImGui::InputInt("Month", &m_M);
-        ImGui::InputInt("Day", &m_D);
-        ImGui::InputInt("Year", &m_Y);
-        ImGui::InputInt("Hour", &m_h);
-        ImGui::InputInt("Minute", &m_m);
-        ImGui::InputInt("Second", &m_s);
-        ImGui::InputDouble("Observer Longitude", &m_lonDeg);
-        ImGui::InputDouble("Observer Latitude", &m_latDeg);
-
-        Compute();
-
-        ImGui::Text("Julian Date (JD): %f", m_JD);
+        bool dateTimeChanged = false;
+        dateTimeChanged |= ImGui::InputInt("Month", &m_M);
+        dateTimeChanged |= ImGui::InputInt("Day", &m_D);
+        dateTimeChanged |= ImGui::InputInt("Year", &m_Y);
+        dateTimeChanged |= ImGui::InputInt("Hour", &m_h);
+        dateTimeChanged |= ImGui::InputInt("Minute", &m_m);
+        dateTimeChanged |= ImGui::InputInt("Second", &m_s);
+        if (dateTimeChanged)
+        {
+            m_JD = ComputeJulianDate(m_M, m_D, m_Y, m_h, m_m, m_s, 0.0);
+            ComputeDateTime();
+        }
+        ImGui::Checkbox("Run Clock", &m_clockRunning);
+        ImGui::SameLine();
+        ImGui::InputFloat("Time Scale", &m_timeScale, 60.0f, 3600.0f, "%.0f");
+        changed |= dateTimeChanged;
+        changed |= ImGui::InputDouble("Observer Longitude", &m_lonDeg);
+        changed |= ImGui::InputDouble("Observer Latitude", &m_latDeg);
+        ImGui::Text("Ephemeris");
+        int tier = static_cast<int>(m_ephemeris.GetTier());
+        for (Ephemeris::Tier option : {Ephemeris::Tier::LOW_PRECISION, Ephemeris::Tier::TRUNCATED_SERIES, Ephemeris::Tier::TABULATED})
+        {
+            ImGui::SameLine();
+            changed |= ImGui::RadioButton(Ephemeris::GetTierName(option), &tier, static_cast<int>(option));
+        }
+        m_ephemeris.SetTier(static_cast<Ephemeris::Tier>(tier));
+
+        // Before showing the positions
+        if (changed) Compute();
+        changed = false;
+
+        double hoursBehind, hoursAhead;
+        m_ephemerisTable.GetCoverage(m_Tp, hoursBehind, hoursAhead);
+        ImGui::Text("Ephemeris Table | -%.1f h, +%.1f h, %s", hoursBehind, hoursAhead, m_interpolated ? "Interpolated" : "Series");
+        ImGui::Text("Julian Date (JD): %f, Delta T: %.1f s", m_JD, (m_Tp - m_T) * 36525.0 * 86400.0);
         ImGui::Separator();
         glm::dvec3 sunEclipticCoordinatesDeg = glm::mod(glm::degrees(m_sunEclipticCoordinates), 360.0);
         ImGui::Text("Sun Ecliptic Coordinates | Longitude: %gd, Latitude: %gd", sunEclipticCoordinatesDeg.x, sunEclipticCoordinatesDeg.y);
@@ -56,51 +108,51 @@ void AstronomicalPositioning::Update()
         ImGui::Text("Phase Angles | Earth: %grad Moon: %grad", m_earthPhaseAngle, m_moonPhaseAngle);
     }
     ImGui::End();
+
+    // If the window is collapsed
+    if (changed) Compute();
+    if (m_clockRunning) m_ephemerisTable.Request(m_Tp, m_timeScale >= 0.0f, m_ephemeris.GetTier());
 }
 
-// See: Jensen 2001
-glm::dvec3 AstronomicalPositioning::SphericalToRectangular(glm::dvec3 spherical)
+// Seconds out of [0, 60) are valid, as the Julian date is linear on them
+void AstronomicalPositioning::SetDateTime(int Y, int M, int D, int h, int m, int s)
 {
-    double lon = spherical.x;
-    double lat = spherical.y;
-    double r = spherical.z;
+    m_Y = Y;
+    m_M = M;
+    m_D = D;
+    m_h = h;
+    m_m = m;
+    m_s = s;
+    m_JD = ComputeJulianDate(m_M, m_D, m_Y, m_h, m_m, m_s, 0.0);
+    ComputeDateTime();
+    Compute();
+}
 
-    glm::dvec3 rectangular;
-    rectangular.x = glm::cos(lat) * glm::cos(lon);
-    rectangular.y = glm::cos(lat) * glm::sin(lon);
-    rectangular.z = glm::sin(lat);
-    rectangular *= r;
-    return rectangular;
+void AstronomicalPositioning::SetEphemerisTier(Ephemeris::Tier tier)
+{
+    m_ephemeris.SetTier(tier);
+    Compute();
 }
 
-glm::dvec3 AstronomicalPositioning::RectangularToSpherical(glm::dvec3 rectangular)
+// The math is shared with EphemerisBatch, see EphemerisMath.h
+glm::dvec3 AstronomicalPositioning::SphericalToRectangular(glm::dvec3 spherical)
 {
-    double r = glm::length(rectangular);
-    double lon = glm::atan(rectangular.y, rectangular.x);
-    double lat = glm::asin(rectangular.z / r);
+    return ToGlm(EphemerisMath::SphericalToRectangular(FromGlm(spherical)));
+}
 
-    glm::dvec3 spherical;
-    spherical.x = lon;
-    spherical.y = lat;
-    spherical.z = r;
-    return spherical;
+glm::dvec3 AstronomicalPositioning::RectangularToSpherical(glm::dvec3 rectangular)
+{
+    return ToGlm(EphemerisMath::RectangularToSpherical(FromGlm(rectangular)));
 }
 
-// See: Jensen 2001
 glm::dvec3 AstronomicalPositioning::RectangularEclipticToRectangularEquatorial(glm::dvec3 rectangularEcliptic, double T)
 {
-    double eps = 0.409093 - 0.000227 * T;
-    glm::dvec3 rectangularEquatorial = Rx(eps) * rectangularEcliptic;
-    return rectangularEquatorial;
+    return ToGlm(EphemerisMath::RectangularEclipticToRectangularEquatorial(FromGlm(rectangularEcliptic), T));
 }
 
 glm::dvec3 AstronomicalPositioning::RectangularEquatorialToRectangularHorizon(glm::dvec3 rectangularEquatorial, double T, double T_, double lon, double lat)
 {
-    double LMST = 4.894961 + 230121.675315 * T_ + lon;
-    glm::dmat3 P = Rz(0.01118*T) * Ry(-0.00972*T) * Rz(0.01118*T);
-    glm::dmat3 M = Ry(lat - glm::half_pi<float>()) * Rz(-LMST) * P;
-    glm::dvec3 rectangularHorizon = M * rectangularEquatorial;
-    return rectangularHorizon;
+    return ToGlm(EphemerisMath::RectangularEquatorialToRectangularHorizon(FromGlm(rectangularEquatorial), T, T_, lon, lat));
 }
 
 
@@ -111,16 +163,21 @@ void AstronomicalPositioning::Compute()
     ComputeLonLat();
     ComputeCoordinates();
     ComputePhaseAngles();
+    ComputeTransforms();
 }
 
-// TODO: Check if something has to be added to the seconds (see: Jensen 2001 Appendix Time Conversion)
+// The fields of the date and time, from the clock (fractions of a second are kept in the Julian date only)
+void AstronomicalPositioning::ComputeDateTime()
+{
+    ComputeCalendarDate(m_JD, m_M, m_D, m_Y, m_h, m_m, m_s);
+}
+
+// The date and time are in Universal Time, which the rotation of the Earth follows, while the series and the
+// precession are in Terrestrial Time (see: Jensen 2001 Appendix Time Conversion)
 void AstronomicalPositioning::ComputeT()
 {
-    m_JD = ComputeJulianDate(m_M, m_D, m_Y, m_h, m_m, m_s, 0.0);
     m_T = ComputeJulianCenturies(m_JD);
-
-    double JDp = ComputeJulianDate(m_M, m_D, m_Y, m_h, m_m, m_s, 73.0);
-    m_Tp = ComputeJulianCenturies(JDp);
+    m_Tp = ComputeJulianCenturies(m_JD + EphemerisMath::DeltaT(m_JD) / 86400.0);
 }
 
 void AstronomicalPositioning::ComputeLonLat()
@@ -131,8 +188,8 @@ void AstronomicalPositioning::ComputeLonLat()
 
 void AstronomicalPositioning::ComputeCoordinates()
 {
-    m_sunEclipticCoordinates = ComputeSunEclipticCoordinates(m_T);
-    m_moonEclipticCoordinates = ComputeMoonEclipticCoordinates(m_T);
+    m_interpolated = m_ephemerisTable.Sample(m_Tp, m_ephemeris.GetTier(), m_sunEclipticCoordinates, m_moonEclipticCoordinates);
+    if (!m_interpolated) m_ephemeris.Compute(m_Tp, m_sunEclipticCoordinates, m_moonEclipticCoordinates);
     ComputeEquatorialAndHorizonCoordinates(m_sunEclipticCoordinates, m_sunEclipticRectangularCoordinates, m_sunEquatorialCoordinates, m_sunHorizonCoordinates);
     ComputeEquatorialAndHorizonCoordinates(m_moonEclipticCoordinates, m_moonEclipticRectangularCoordinates, m_moonEquatorialCoordinates, m_moonHorizonCoordinates);
 }
@@ -140,18 +197,31 @@ void AstronomicalPositioning::ComputeCoordinates()
 void AstronomicalPositioning::ComputeEquatorialAndHorizonCoordinates(glm::dvec3 eclipticCoordinates, glm::dvec3& eclipticRectangularCoordinates, glm::dvec3& equatorialCoordinates, glm::dvec3& horizonCoordinates)
 {
     eclipticRectangularCoordinates = SphericalToRectangular(eclipticCoordinates);
-    glm::dvec3 rectangularEquatorial = RectangularEclipticToRectangularEquatorial(eclipticRectangularCoordinates, m_T);
+    glm::dvec3 rectangularEquatorial = RectangularEclipticToRectangularEquatorial(eclipticRectangularCoordinates, m_Tp);
     equatorialCoordinates = RectangularToSpherical(rectangularEquatorial);
-    glm::dvec3 rectangularHorizon = RectangularEquatorialToRectangularHorizon(rectangularEquatorial, m_T, m_Tp, m_lon, m_lat);
+    glm::dvec3 rectangularHorizon = RectangularEquatorialToRectangularHorizon(rectangularEquatorial, m_Tp, m_T, m_lon, m_lat);
     horizonCoordinates = RectangularToSpherical(rectangularHorizon);
 }
 
 void AstronomicalPositioning::ComputePhaseAngles()
 {
-    m_earthPhaseAngle = glm::acos(glm::dot(m_sunEclipticRectangularCoordinates, m_moonEclipticRectangularCoordinates) / (glm::length(m_sunEclipticRectangularCoordinates) * glm::length(m_moonEclipticRectangularCoordinates)));
+    m_earthPhaseAngle = EphemerisMath::EarthPhaseAngle(FromGlm(m_sunEclipticRectangularCoordinates), FromGlm(m_moonEclipticRectangularCoordinates));
     m_moonPhaseAngle = glm::pi<float>() - m_earthPhaseAngle;
 }
 
+// The same rotations as RectangularEquatorialToRectangularHorizon
+void AstronomicalPositioning::ComputeTransforms()
+{
+    // The horizon coordinate system has z at the zenith, the world one has y up
+    m_transforms.worldFromHorizon = glm::dmat3(glm::dvec3(0.0, 0.0, 1.0), glm::dvec3(1.0, 0.0, 0.0), glm::dvec3(0.0, 1.0, 0.0));
+
+    double LMST = 4.894961 + 230121.675315 * m_T + m_lon;
+    glm::dmat3 precession = Rz(0.01118 * m_Tp) * Ry(-0.00972 * m_Tp) * Rz(0.01118 * m_Tp);
+    m_transforms.horizonFromEquatorial = Ry(m_lat - glm::half_pi<double>()) * Rz(-LMST) * precession;
+
+    m_transforms.worldFromEquatorial = m_transforms.worldFromHorizon * m_transforms.horizonFromEquatorial;
+}
+
 double AstronomicalPositioning::ComputeJulianDate(int M, int D, int Y, int h, int m, int s, double deltaT)
 {
     int Mp = M;
@@ -169,65 +239,31 @@ double AstronomicalPositioning::ComputeJulianDate(int M, int D, int Y, int h, in
     return JD;
 }
 
+// Inverse of ComputeJulianDate, Gregorian calendar (see: Meeus 1998, chapter 7)
+void AstronomicalPositioning::ComputeCalendarDate(double JD, int& M, int& D, int& Y, int& h, int& m, int& s)
+{
+    double Z = glm::floor(JD + 0.5);
+    double F = JD + 0.5 - Z;
+    double alpha = glm::floor((Z - 1867216.25) / 36524.25);
+    double A = Z + 1.0 + alpha - glm::floor(alpha / 4.0);
+    double B = A + 1524.0;
+    double C = glm::floor((B - 122.1) / 365.25);
+    double Dp = glm::floor(365.25 * C);
+    double E = glm::floor((B - Dp) / 30.6001);
+
+    D = static_cast<int>(B - Dp - glm::floor(30.6001 * E));
+    M = static_cast<int>(E < 14.0 ? E - 1.0 : E - 13.0);
+    Y = static_cast<int>(M > 2 ? C - 4716.0 : C - 4715.0);
+
+    int seconds = glm::min(static_cast<int>(glm::floor(F * 86400.0 + 1e-4)), 86399); // Whole seconds despite the rounding of JD
+    h = seconds / 3600;
+    m = seconds / 60 % 60;
+    s = seconds % 60;
+}
+
 double AstronomicalPositioning::ComputeJulianCenturies(double JD)
 {
-    double T = (JD - 2451545.0) / 36525.0;
-    return T;
-}
-
-glm::dvec3 AstronomicalPositioning::ComputeSunEclipticCoordinates(double T)
-{
-    double M = 6.24 + 628.302 * T;
-
-    double lambda = 4.895048 + 628.331951 * T + (0.033417 - 0.000084 * T) * glm::sin(M) + 0.000351 * glm::sin(2 * M);
-    double beta = 0.0;
-    double r = 1.000140 - (0.016708 - 0.000042 * T) * glm::cos(M) - 0.000141 * glm::cos(2 * M); // AU
-
-    return glm::dvec3(lambda, beta, r);
-}
-
-glm::dvec3 AstronomicalPositioning::ComputeMoonEclipticCoordinates(double T)
-{
-    double lp = 3.8104 + 8399.7091 * T;
-    double m = 6.2300 + 628.3019 * T;
-    double f = 1.6280 + 8433.4663 * T;
-    double mp = 2.3554 + 8328.6911 * T;
-    double d = 5.1985 + 7771.3772 * T;
-
-    double lambda = lp
-        + 0.1098 * glm::sin(mp)
-        + 0.0222 * glm::sin(2 * d - mp)
-        + 0.0115 * glm::sin(2 * d)
-        + 0.0037 * glm::sin(2 * mp)
-        - 0.0032 * glm::sin(m)
-        - 0.0020 * glm::sin(2 * f)
-        + 0.0010 * glm::sin(2 * d - 2 * mp)
-        + 0.0010 * glm::sin(2 * d - m - mp)
-        + 0.0009 * glm::sin(2 * d + mp)
-        + 0.0008 * glm::sin(2 * d - m)
-        + 0.0007 * glm::sin(mp - m)
-        - 0.0006 * glm::sin(d)
-        - 0.0005 * glm::sin(m + mp);
-    double beta =
-        +0.0895 * glm::sin(f)
-        + 0.0049 * glm::sin(mp + f)
-        + 0.0048 * glm::sin(mp - f)
-        + 0.0030 * glm::sin(2 * d - f)
-        + 0.0010 * glm::sin(2 * d + f - mp)
-        + 0.0008 * glm::sin(2 * d - f - mp)
-        + 0.0006 * glm::sin(2 * d + f);
-    double pip =
-        +0.016593
-        + 0.000904 * glm::cos(mp)
-        + 0.000166 * glm::cos(2 * d - mp)
-        + 0.000137 * glm::cos(2 * d)
-        + 0.000049 * glm::cos(2 * mp)
-        + 0.000015 * glm::cos(2 * d + mp)
-        + 0.000009 * glm::cos(2 * d - m);
-    constexpr double au_in_earth_radi = 23455.0; // 1 AU = 23455 earth radi
-    double r = (1.0 / pip) / au_in_earth_radi; // AU
-
-    return glm::dvec3(lambda, beta, r);
+    return EphemerisMath::JulianCenturies(JD);
 }
 
 glm::dmat3 AstronomicalPositioning::Rx(double a)
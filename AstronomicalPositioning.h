@@ -1,14 +1,31 @@
 #pragma once
 
+#include "Ephemeris.h"
+#include "EphemerisTable.h"
+
 #include <glm/glm.hpp>
 
-// TODO: Take into account deltaT
+// Positions of the Sun and the Moon for an observer, at the time of a simulated
+// clock that can run at any time scale (also backwards). While it runs, the
+// positions are interpolated from an EphemerisTable, and computed with the series
+// of the selected tier when the table does not cover the time yet.
 class AstronomicalPositioning
 {
+public:
+    // Rotations between the world, horizon and equatorial coordinate systems at the current time, computed in
+    // double precision once per change of the time or the observer (instead of per pixel), the inverse ones are their transposes
+    struct Transforms
+    {
+        glm::dmat3 worldFromHorizon;
+        glm::dmat3 horizonFromEquatorial;
+        glm::dmat3 worldFromEquatorial;
+    };
 public:
     AstronomicalPositioning();
     ~AstronomicalPositioning() = default;
-    void Update();
+    void Update(float deltaTime);
+    void SetDateTime(int Y, int M, int D, int h, int m, int s);
+    void SetEphemerisTier(Ephemeris::Tier tier);
     glm::dvec3 GetSunHorizonCoordinates() { return m_sunHorizonCoordinates; }
     glm::dvec3 GetMoonHorizonCoordinates() { return m_moonHorizonCoordinates; }
     double GetMoonPhaseAngle() { return m_moonPhaseAngle; }
@@ -16,18 +33,20 @@ public:
     double GetLon() { return m_lon; }
     double GetLat() { return m_lat; }
     double GetT() { return m_T; }
+    const Transforms& GetTransforms() const { return m_transforms; }
 private:
     void Compute();
+    void ComputeDateTime();
     void ComputeT();
     void ComputeLonLat();
     void ComputeCoordinates();
     void ComputePhaseAngles();
+    void ComputeTransforms();
     void ComputeEquatorialAndHorizonCoordinates(glm::dvec3 eclipticCoordinates, glm::dvec3& eclipticRectangularCoordinates, glm::dvec3& equatorialCoordinates, glm::dvec3& horizonCoordinates);
 private:
     static double ComputeJulianDate(int M, int D, int Y, int h, int m, int s, double deltaT); // JD
+    static void ComputeCalendarDate(double JD, int& M, int& D, int& Y, int& h, int& m, int& s);
     static double ComputeJulianCenturies(double JD); // T
-    static glm::dvec3 ComputeSunEclipticCoordinates(double T);
-    static glm::dvec3 ComputeMoonEclipticCoordinates(double T);
     static glm::dvec3 SphericalToRectangular(glm::dvec3 spherical);
     static glm::dvec3 RectangularToSpherical(glm::dvec3 rectangular);
     static glm::dvec3 RectangularEclipticToRectangularEquatorial(glm::dvec3 rectangularEcliptic, double T);
@@ -42,13 +61,18 @@ private:
     int m_h;
     int m_m;
     int m_s;
-    double m_T;
-    double m_Tp;
+    double m_T; // Universal Time
+    double m_Tp; // Terrestrial Time
     double m_JD;
     double m_lon;
     double m_lat;
     double m_lonDeg;
     double m_latDeg;
+    Ephemeris m_ephemeris;
+    EphemerisTable m_ephemerisTable;
+    bool m_clockRunning;
+    float m_timeScale; // Simulated seconds per second
+    bool m_interpolated; // Whether the last positions were interpolated from the table
     glm::dvec3 m_sunEclipticCoordinates;
     glm::dvec3 m_sunEclipticRectangularCoordinates;
     glm::dvec3 m_sunEquatorialCoordinates;
@@ -59,4 +83,5 @@ private:
     glm::dvec3 m_moonHorizonCoordinates;
     double m_earthPhaseAngle;
     double m_moonPhaseAngle;
+    Transforms m_transforms;
 };
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "AtmospherePrecomputer.h"
+
+#include <iostream>
+#include <utility>
+
+using namespace atmosphere;
+
+namespace
+{
+    bool InitModelTextures(Model& model, const ModelParameters& p, LutCache& lutCache, const Model::ProgressCallback& progress)
+    {
+        unsigned int numScatteringOrders = p.numScatteringOrders;
+        double convergenceTolerance = p.convergenceTolerance;
+        unsigned int adaptiveQuadraturePasses = p.adaptiveQuadraturePasses;
+        if (lutCache.Load(model, numScatteringOrders, convergenceTolerance, adaptiveQuadraturePasses)) return true;
+        if (!model.Init(numScatteringOrders, progress, p.precomputationBackend, convergenceTolerance, adaptiveQuadraturePasses)) return false;
+        lutCache.Store(model, numScatteringOrders, convergenceTolerance, adaptiveQuadraturePasses);
+        return true;
+    }
+}
+
+AtmospherePrecomputer::AtmospherePrecomputer(GLFWwindow* sharedContextWindow, LutCache& lutCache)
+    : m_sharedContextWindow(sharedContextWindow)
+    , m_lutCache(lutCache)
+    , m_quit(false)
+    , m_working(false)
+    , m_pendingRequest(false)
+    , m_generation(0)
+    , m_completedOrders(0)
+    , m_totalOrders(0)
+    , m_thread(&AtmospherePrecomputer::Run, this)
+{
+}
+
+AtmospherePrecomputer::~AtmospherePrecomputer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    ++m_generation; // Cancels the precomputation in progress, if any
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+void AtmospherePrecomputer::Request(const ModelParameters& parameters)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requestParameters = parameters;
+        m_pendingRequest = true;
+        ++m_generation; // Cancels the precomputation in progress, if any
+    }
+    m_condition.notify_one();
+}
+
+bool AtmospherePrecomputer::Poll(std::unique_ptr<Model>& solarModel, std::unique_ptr<Model>& lunarModel)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_readySolarModel) return false;
+
+    // The lunar model may use the textures of the solar one, so it must not outlive it
+    lunarModel = std::move(m_readyLunarModel);
+    solarModel = std::move(m_readySolarModel);
+    return true;
+}
+
+bool AtmospherePrecomputer::IsBusy()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_working || m_pendingRequest;
+}
+
+std::unique_ptr<Model> AtmospherePrecomputer::NewModel(const ModelParameters& p, int lightSource)
+{
+    return std::make_unique<Model>(p.sunIrradiance, p.sunAngularRadius, p.moonIrradiance, p.moonAngularRadius,
+        p.bottomRadius, p.topRadius, p.rayleighDensity, p.rayleighScattering,
+        p.mieDensity, p.mieScattering, p.mieExtinction, p.miePhaseFunctionG,
+        p.absorptionDensity, p.absorptionExtinction, p.groundAlbedo, p.maxSunZenithAngle,
+        p.lengthUnitInMeters, lightSource, p.textureResolution, p.combineScatteringTextures, p.scatteringTextureFormat);
+}
+
+std::uint64_t AtmospherePrecomputer::ComputePrecomputedTexturesKey(const ModelParameters& p, int lightSource)
+{
+    return Model::ComputePrecomputedTexturesKey(p.sunIrradiance, p.sunAngularRadius, p.moonIrradiance, p.moonAngularRadius,
+        p.bottomRadius, p.topRadius, p.rayleighDensity, p.rayleighScattering,
+        p.mieDensity, p.mieScattering, p.mieExtinction, p.miePhaseFunctionG,
+        p.absorptionDensity, p.absorptionExtinction, p.groundAlbedo, p.maxSunZenithAngle,
+        p.lengthUnitInMeters, lightSource, p.textureResolution, p.combineScatteringTextures, p.scatteringTextureFormat,
+        p.numScatteringOrders, p.convergenceTolerance, p.adaptiveQuadraturePasses);
+}
+
+bool AtmospherePrecomputer::Build(const ModelParameters& parameters, LutCache& lutCache, std::unique_ptr<Model>& solarModel, std::unique_ptr<Model>& lunarModel, const Model::ProgressCallback& progress)
+{
+    unsigned int numScatteringOrders = parameters.numScatteringOrders;
+
+    std::unique_ptr<Model> newSolarModel = NewModel(parameters, SOURCE_SUN);
+    if (!InitModelTextures(*newSolarModel, parameters, lutCache, progress)) return false;
+
+    std::unique_ptr<Model> newLunarModel = NewModel(parameters, SOURCE_MOON);
+    // Both models only differ in their light source, so the lunar one can reuse the solar textures scaled at runtime
+    if (parameters.sharedPrecomputation) newLunarModel->ShareTexturesFrom(*newSolarModel);
+    else
+    {
+        Model::ProgressCallback lunarProgress = [&progress, numScatteringOrders](unsigned int scatteringOrder)
+        {
+            return !progress || progress(numScatteringOrders + scatteringOrder);
+        };
+        if (!InitModelTextures(*newLunarModel, parameters, lutCache, lunarProgress)) return false;
+    }
+
+    lunarModel.reset();
+    solarModel = std::move(newSolarModel);
+    lunarModel = std::move(newLunarModel);
+    return true;
+}
+
+void AtmospherePrecomputer::Run()
+{
+    glfwMakeContextCurrent(m_sharedContextWindow);
+
+    while (true)
+    {
+        ModelParameters parameters;
+        unsigned int generation;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_working = false;
+            m_condition.wait(lock, [this]() { return m_quit || m_pendingRequest; });
+            if (m_quit) break;
+            parameters = m_requestParameters;
+            generation = m_generation;
+            m_pendingRequest = false;
+            m_working = true;
+        }
+
+        m_completedOrders = 0;
+        m_totalOrders = parameters.numScatteringOrders * (parameters.sharedPrecomputation ? 1 : 2);
+        Model::ProgressCallback progress = [this, generation](unsigned int completedOrders)
+        {
+            m_completedOrders = completedOrders;
+            return generation == m_generation;
+        };
+
+        std::unique_ptr<Model> solarModel;
+        std::unique_ptr<Model> lunarModel;
+        bool completed = Build(parameters, m_lutCache, solarModel, lunarModel, progress);
+        if (glGetError() != GL_NO_ERROR) std::cerr << "[AtmospherePrecomputer] E: Precomputing model." << std::endl;
+        if (!completed || generation != m_generation) continue;
+
+        // Make sure the textures are complete before the rendering context uses them
+        glFinish();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (generation != m_generation) continue;
+        std::swap(m_readyLunarModel, lunarModel);
+        std::swap(m_readySolarModel, solarModel);
+        // The models replaced here (if not polled yet) are destroyed at the end of this scope
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
\ No newline at end of file
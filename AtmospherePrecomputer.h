@@ -0,0 +1,83 @@
+#pragma once
+
+#include "LutCache.h"
+
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <atmosphere/model.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Constructor arguments shared by the solar and lunar atmosphere models
+struct ModelParameters
+{
+    glm::dvec3 sunIrradiance;
+    double sunAngularRadius;
+    glm::dvec3 moonIrradiance;
+    double moonAngularRadius;
+    double bottomRadius;
+    double topRadius;
+    std::vector<atmosphere::DensityProfileLayer> rayleighDensity;
+    glm::dvec3 rayleighScattering;
+    std::vector<atmosphere::DensityProfileLayer> mieDensity;
+    glm::dvec3 mieScattering;
+    glm::dvec3 mieExtinction;
+    double miePhaseFunctionG;
+    std::vector<atmosphere::DensityProfileLayer> absorptionDensity;
+    glm::dvec3 absorptionExtinction;
+    glm::dvec3 groundAlbedo;
+    double maxSunZenithAngle;
+    double lengthUnitInMeters;
+    atmosphere::TextureResolution textureResolution;
+    bool combineScatteringTextures; // Single Mie scattering in the alpha channel of the scattering texture
+    atmosphere::ScatteringTextureFormat scatteringTextureFormat;
+    unsigned int numScatteringOrders; // Maximum number of orders if convergenceTolerance > 0
+    double convergenceTolerance; // Stop once an order adds less than this fraction of the total energy, 0 to disable
+    unsigned int adaptiveQuadraturePasses; // atmosphere::AdaptiveQuadraturePass flags
+    bool sharedPrecomputation;
+    atmosphere::PrecomputationBackend precomputationBackend;
+};
+
+// Precomputes the solar and lunar atmosphere models on a worker thread that
+// owns an OpenGL context shared with the rendering one. A new request cancels
+// the one in progress, and the last completed pair of models is handed over
+// to the rendering thread by Poll.
+class AtmospherePrecomputer
+{
+public:
+    AtmospherePrecomputer(GLFWwindow* sharedContextWindow, LutCache& lutCache);
+    ~AtmospherePrecomputer();
+    void Request(const ModelParameters& parameters);
+    bool Poll(std::unique_ptr<atmosphere::Model>& solarModel, std::unique_ptr<atmosphere::Model>& lunarModel);
+    bool IsBusy();
+    unsigned int GetCompletedOrders() const { return m_completedOrders; }
+    unsigned int GetTotalOrders() const { return m_totalOrders; }
+    static std::unique_ptr<atmosphere::Model> NewModel(const ModelParameters& parameters, int lightSource);
+    static std::uint64_t ComputePrecomputedTexturesKey(const ModelParameters& parameters, int lightSource); // Of the model of NewModel, without an OpenGL context
+    static bool Build(const ModelParameters& parameters, LutCache& lutCache, std::unique_ptr<atmosphere::Model>& solarModel, std::unique_ptr<atmosphere::Model>& lunarModel, const atmosphere::Model::ProgressCallback& progress);
+private:
+    void Run();
+private:
+    GLFWwindow* m_sharedContextWindow;
+    LutCache& m_lutCache;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_quit;
+    bool m_working;
+    bool m_pendingRequest;
+    ModelParameters m_requestParameters;
+    std::unique_ptr<atmosphere::Model> m_readySolarModel;
+    std::unique_ptr<atmosphere::Model> m_readyLunarModel;
+    std::atomic<unsigned int> m_generation;
+    std::atomic<unsigned int> m_completedOrders;
+    std::atomic<unsigned int> m_totalOrders;
+    std::thread m_thread;
+};
\ No newline at end of file
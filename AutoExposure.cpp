@@ -0,0 +1,211 @@
+#include "AutoExposure.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    constexpr int kBaseSize = 256;
+    constexpr int kReductionFactor = 4;
+}
+
+AutoExposure::AutoExposure()
+    : m_luminanceShader()
+    , m_reduceShader()
+    , m_levels()
+    , m_readbackBuffers()
+    , m_fences()
+    , m_fenceFrames()
+    , m_frame(0)
+    , m_statisticsFrame(0)
+    , m_statistics()
+    , m_hasStatistics(false)
+    , m_adapted(false)
+    , m_adaptedLogLuminance(0.0)
+    , m_adaptedLogMaxLuminance(0.0)
+{
+    ShaderStage vertexShader = ShaderStage();
+    vertexShader.Create(ShaderType::VERTEX);
+    vertexShader.Compile("./resources/shaders/postprocess.vert", "./resources/shaders");
+
+    ShaderStage luminanceFragmentShader = ShaderStage();
+    luminanceFragmentShader.Create(ShaderType::FRAGMENT);
+    luminanceFragmentShader.Compile("./resources/shaders/luminance.frag", "./resources/shaders");
+    m_luminanceShader.Create();
+    m_luminanceShader.AttachShader(vertexShader.m_id);
+    m_luminanceShader.AttachShader(luminanceFragmentShader.m_id);
+    m_luminanceShader.Build();
+
+    ShaderStage reduceFragmentShader = ShaderStage();
+    reduceFragmentShader.Create(ShaderType::FRAGMENT);
+    reduceFragmentShader.Compile("./resources/shaders/luminance_reduce.frag", "./resources/shaders");
+    m_reduceShader.Create();
+    m_reduceShader.AttachShader(vertexShader.m_id);
+    m_reduceShader.AttachShader(reduceFragmentShader.m_id);
+    m_reduceShader.Build();
+
+    int size = kBaseSize;
+    for (Level& level : m_levels)
+    {
+        level.size = size;
+        glGenTextures(2, level.textures);
+        for (GLuint texture : level.textures)
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, size, size, 0, GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+
+        glGenFramebuffers(1, &level.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, level.framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.textures[0], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, level.textures[1], 0);
+        GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, drawBuffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) std::cerr << "[AutoExposure] E: Reduction framebuffer is not complete." << std::endl;
+
+        size /= kReductionFactor;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+
+    // Two RGBA32F texels per reduction
+    glGenBuffers(kReadbackLatency, m_readbackBuffers);
+    for (GLuint buffer : m_readbackBuffers)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, 8 * sizeof(float), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+AutoExposure::~AutoExposure()
+{
+    for (GLsync fence : m_fences) if (fence) glDeleteSync(fence);
+    glDeleteBuffers(kReadbackLatency, m_readbackBuffers);
+    for (Level& level : m_levels)
+    {
+        glDeleteFramebuffers(1, &level.framebuffer);
+        glDeleteTextures(2, level.textures);
+    }
+}
+
+// Reduces the HDR texture to a single texel and starts copying it into the pixel buffer of this frame
+void AutoExposure::Reduce(GLuint hdrTexture, GLuint fullScreenQuadVao)
+{
+    GLint viewportData[4];
+    glGetIntegerv(GL_VIEWPORT, viewportData);
+    GLint drawFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+    glDisable(GL_BLEND); // The alpha channel holds the number of texels
+    glBindVertexArray(fullScreenQuadVao);
+    Profiler::CountGlCalls(4);
+
+    m_luminanceShader.Use();
+    m_luminanceShader.SetInt("hdrTexture", 0);
+    m_luminanceShader.SetInt("ReducedSize", kBaseSize);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, hdrTexture);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_levels[0].framebuffer);
+    glViewport(0, 0, m_levels[0].size, m_levels[0].size);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    Profiler::CountGlCalls(5);
+
+    m_reduceShader.Use();
+    m_reduceShader.SetInt("PhotopicTexture", 0);
+    m_reduceShader.SetInt("ScotopicTexture", 1);
+    for (int i = 1; i < kNumLevels; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_levels[i - 1].textures[0]);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_levels[i - 1].textures[1]);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_levels[i].framebuffer);
+        glViewport(0, 0, m_levels[i].size, m_levels[i].size);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        Profiler::CountGlCalls(7);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // A result still in flight in this slot (the GPU being kReadbackLatency frames behind) is dropped
+    int slot = static_cast<int>(m_frame % kReadbackLatency);
+    if (m_fences[slot]) glDeleteSync(m_fences[slot]);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbackBuffers[slot]);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_FLOAT, reinterpret_cast<void*>(0));
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_FLOAT, reinterpret_cast<void*>(4 * sizeof(float)));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_fenceFrames[slot] = m_frame;
+    ++m_frame;
+
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    glViewport(viewportData[0], viewportData[1], viewportData[2], viewportData[3]);
+    glEnable(GL_BLEND);
+    Profiler::CountGlCalls(12);
+}
+
+void AutoExposure::Update(double deltaTime, double adaptationTime)
+{
+    for (int slot = 0; slot < kReadbackLatency; ++slot)
+    {
+        if (!m_fences[slot]) continue;
+        GLenum status = glClientWaitSync(m_fences[slot], 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) ReadBack(slot);
+    }
+    if (!m_hasStatistics) return;
+
+    double logLuminance = std::log(m_statistics.averagePhotopic);
+    double logMaxLuminance = std::log(std::max(m_statistics.maxPhotopic, m_statistics.averagePhotopic));
+    if (!m_adapted)
+    {
+        m_adaptedLogLuminance = logLuminance;
+        m_adaptedLogMaxLuminance = logMaxLuminance;
+        m_adapted = true;
+        return;
+    }
+
+    // Exponential adaptation in log space, independent of the frame rate
+    double alpha = adaptationTime > 0.0 ? 1.0 - std::exp(-deltaTime / adaptationTime) : 1.0;
+    m_adaptedLogLuminance += (logLuminance - m_adaptedLogLuminance) * alpha;
+    m_adaptedLogMaxLuminance += (logMaxLuminance - m_adaptedLogMaxLuminance) * alpha;
+}
+
+double AutoExposure::GetAdaptedLuminance() const
+{
+    return std::exp(m_adaptedLogLuminance);
+}
+
+double AutoExposure::GetAdaptedMaxLuminance() const
+{
+    return std::exp(m_adaptedLogMaxLuminance);
+}
+
+void AutoExposure::ReadBack(int slot)
+{
+    glDeleteSync(m_fences[slot]);
+    m_fences[slot] = nullptr;
+
+    // Slots may complete out of order with respect to the last reduction read
+    bool newest = !m_hasStatistics || m_fenceFrames[slot] > m_statisticsFrame;
+    if (!newest) return;
+
+    float data[8]; // Sum of log luminances, minimum, maximum and number of texels, photopic and scotopic
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbackBuffers[slot]);
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(data), data);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (data[3] <= 0.0f) return;
+
+    m_statistics.averagePhotopic = std::exp(static_cast<double>(data[0]) / data[3]);
+    m_statistics.minPhotopic = data[1];
+    m_statistics.maxPhotopic = data[2];
+    m_statistics.averageScotopic = std::exp(static_cast<double>(data[4]) / data[7]);
+    m_statistics.minScotopic = data[5];
+    m_statistics.maxScotopic = data[6];
+    m_statisticsFrame = m_fenceFrames[slot];
+    m_hasStatistics = true;
+}
\ No newline at end of file
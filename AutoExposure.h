@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+// Photopic and scotopic luminance statistics of the HDR frame, and luminance
+// adaptation for automatic exposure. The frame is reduced on the GPU by a chain
+// of small render targets (each pass reducing blocks of texels to their sum of
+// log luminances, minimum, maximum and number of texels), whose final 1x1 result
+// is copied into a pixel buffer and only read kReadbackLatency frames later (when
+// its fence is signaled), so that the CPU never waits for the GPU.
+class AutoExposure
+{
+public:
+    struct Statistics
+    {
+        double averagePhotopic; // Log-average (geometric mean)
+        double minPhotopic;
+        double maxPhotopic;
+        double averageScotopic;
+        double minScotopic;
+        double maxScotopic;
+    };
+public:
+    AutoExposure();
+    ~AutoExposure();
+    void Reduce(GLuint hdrTexture, GLuint fullScreenQuadVao);
+    void Update(double deltaTime, double adaptationTime); // Reads back the finished reductions and adapts to the newest one
+    bool HasStatistics() const { return m_hasStatistics; }
+    const Statistics& GetStatistics() const { return m_statistics; }
+    double GetAdaptedLuminance() const; // Temporally smoothed log-average photopic luminance
+    double GetAdaptedMaxLuminance() const;
+private:
+    static constexpr int kNumLevels = 5; // 256x256, 64x64, 16x16, 4x4 and 1x1
+    static constexpr int kReadbackLatency = 3;
+
+    struct Level
+    {
+        int size;
+        GLuint textures[2]; // Photopic, scotopic
+        GLuint framebuffer;
+    };
+private:
+    void ReadBack(int slot);
+private:
+    ShaderProgram m_luminanceShader;
+    ShaderProgram m_reduceShader;
+    Level m_levels[kNumLevels];
+    GLuint m_readbackBuffers[kReadbackLatency];
+    GLsync m_fences[kReadbackLatency];
+    std::uint64_t m_fenceFrames[kReadbackLatency];
+    std::uint64_t m_frame;
+    std::uint64_t m_statisticsFrame;
+    Statistics m_statistics;
+    bool m_hasStatistics;
+    bool m_adapted;
+    double m_adaptedLogLuminance;
+    double m_adaptedLogMaxLuminance;
+};
\ No newline at end of file
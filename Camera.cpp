@@ -92,6 +92,13 @@ void Camera::SetAspectRatio(float aspectRatio)
     m_aspectRatio = aspectRatio;
 }
 
+void Camera::SetView(float azimuth, float zenith, float verticalFov)
+{
+    m_azimuth = azimuth;
+    m_zenith = zenith;
+    m_verticalFov = verticalFov;
+}
+
 glm::mat4 Camera::GetViewMatrix() const
 {
     return glm::lookAt(m_position, m_center, m_up);
@@ -17,6 +17,7 @@ public:
     float GetVerticalFov() const { return m_verticalFov; }
     float GetAspectRatio() const { return m_aspectRatio; }
     void SetAspectRatio(float aspectRatio);
+    void SetView(float azimuth, float zenith, float verticalFov);
     glm::mat4 GetViewMatrix() const;
     glm::mat4 GetProjectionMatrix() const;
     glm::mat4 GetViewFromClipMatrix() const;
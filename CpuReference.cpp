@@ -0,0 +1,196 @@
+#include "CpuReference.h"
+
+#include <atmosphere/cpu/model.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+using namespace atmosphere;
+
+namespace
+{
+    // Same unit conversions as the GLSL ATMOSPHERE constant of Model
+    cpu::DensityProfile ToDensityProfile(std::vector<DensityProfileLayer> layers, double lengthUnitInMeters)
+    {
+        constexpr std::size_t kLayerCount = 2;
+        while (layers.size() < kLayerCount) layers.insert(layers.begin(), DensityProfileLayer());
+
+        cpu::DensityProfile profile;
+        for (std::size_t i = 0; i < kLayerCount; ++i)
+        {
+            profile.layers[i].width = layers[i].width / lengthUnitInMeters;
+            profile.layers[i].exp_term = layers[i].exp_term;
+            profile.layers[i].exp_scale = layers[i].exp_scale * lengthUnitInMeters;
+            profile.layers[i].linear_term = layers[i].linear_term * lengthUnitInMeters;
+            profile.layers[i].constant_term = layers[i].constant_term;
+        }
+        return profile;
+    }
+
+    cpu::AtmosphereParameters ToAtmosphereParameters(const ModelParameters& p)
+    {
+        double unit = p.lengthUnitInMeters;
+
+        cpu::AtmosphereParameters parameters;
+        parameters.sun_irradiance = p.sunIrradiance;
+        parameters.sun_angular_radius = p.sunAngularRadius;
+        parameters.moon_irradiance = p.moonIrradiance;
+        parameters.moon_angular_radius = p.moonAngularRadius;
+        parameters.bottom_radius = p.bottomRadius / unit;
+        parameters.top_radius = p.topRadius / unit;
+        parameters.rayleigh_density = ToDensityProfile(p.rayleighDensity, unit);
+        parameters.rayleigh_scattering = p.rayleighScattering * unit;
+        parameters.mie_density = ToDensityProfile(p.mieDensity, unit);
+        parameters.mie_scattering = p.mieScattering * unit;
+        parameters.mie_extinction = p.mieExtinction * unit;
+        parameters.mie_phase_function_g = p.miePhaseFunctionG;
+        parameters.absorption_density = ToDensityProfile(p.absorptionDensity, unit);
+        parameters.absorption_extinction = p.absorptionExtinction * unit;
+        parameters.ground_albedo = p.groundAlbedo;
+        parameters.mu_s_min = std::cos(p.maxSunZenithAngle);
+        return parameters;
+    }
+
+    bool IsDefaultResolution(const TextureResolution& resolution)
+    {
+        const TextureResolution defaultResolution = GetTextureResolution(DEFAULT_RESOLUTION);
+        return resolution.transmittance_width == defaultResolution.transmittance_width
+            && resolution.transmittance_height == defaultResolution.transmittance_height
+            && resolution.scattering_r_size == defaultResolution.scattering_r_size
+            && resolution.scattering_mu_size == defaultResolution.scattering_mu_size
+            && resolution.scattering_mu_s_size == defaultResolution.scattering_mu_s_size
+            && resolution.scattering_nu_size == defaultResolution.scattering_nu_size
+            && resolution.irradiance_width == defaultResolution.irradiance_width
+            && resolution.irradiance_height == defaultResolution.irradiance_height;
+    }
+
+    // The relative errors are computed with respect to the CPU values, ignoring
+    // those which are negligible compared to the largest one of the texture
+    CpuReference::TextureDifference Compare(const char* name, const float* gpu, const float* cpu, std::size_t size)
+    {
+        float maxValue = 0.0f;
+        for (std::size_t i = 0; i < size; ++i) maxValue = std::max(maxValue, std::abs(cpu[i]));
+        float epsilon = 1e-6f * maxValue;
+
+        CpuReference::TextureDifference difference = {name, 0.0f, 0.0f, 0.0f};
+        double sumSquaredRelativeErrors = 0.0;
+        std::size_t numRelativeErrors = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            float absoluteError = std::abs(gpu[i] - cpu[i]);
+            difference.maxAbsoluteError = std::max(difference.maxAbsoluteError, absoluteError);
+            if (std::abs(cpu[i]) <= epsilon) continue;
+            float relativeError = absoluteError / std::abs(cpu[i]);
+            difference.maxRelativeError = std::max(difference.maxRelativeError, relativeError);
+            sumSquaredRelativeErrors += static_cast<double>(relativeError) * relativeError;
+            ++numRelativeErrors;
+        }
+        if (numRelativeErrors > 0) difference.rmsRelativeError = static_cast<float>(std::sqrt(sumSquaredRelativeErrors / numRelativeErrors));
+        return difference;
+    }
+}
+
+CpuReference::CpuReference()
+    : m_result()
+    , m_hasResult(false)
+{
+}
+
+bool CpuReference::IsSupported(const Model& gpuModel)
+{
+    return IsDefaultResolution(gpuModel.resolution()) && !gpuModel.combine_scattering_textures();
+}
+
+// The textures of the CPU implementation have all the scattering orders and fixed quadratures, so that they would not have
+// the content of the GPU textures with the key of a convergence tolerance or of adaptive quadratures
+bool CpuReference::IsSupported(const ModelParameters& parameters)
+{
+    return IsDefaultResolution(parameters.textureResolution) && !parameters.combineScatteringTextures
+        && parameters.convergenceTolerance <= 0.0 && parameters.adaptiveQuadraturePasses == 0;
+}
+
+bool CpuReference::Precompute(const ModelParameters& parameters, LutCache& lutCache)
+{
+    if (!IsSupported(parameters))
+    {
+        std::cerr << "[CpuReference] E: Only the default resolution, separate textures, all the scattering orders and fixed quadratures are supported." << std::endl;
+        return false;
+    }
+
+    // The lunar model only has textures of its own if they are not shared with the solar one
+    std::vector<int> lightSources = {SOURCE_SUN};
+    if (!parameters.sharedPrecomputation) lightSources.push_back(SOURCE_MOON);
+    for (int lightSource : lightSources)
+    {
+        cpu::Model model(ToAtmosphereParameters(parameters), lightSource);
+        model.Init(parameters.numScatteringOrders);
+
+        std::vector<float> textures(cpu::Model::GetPrecomputedTexturesSize());
+        model.GetPrecomputedTextures(textures.data());
+        lutCache.Store(AtmospherePrecomputer::ComputePrecomputedTexturesKey(parameters, lightSource), textures, parameters.numScatteringOrders);
+        std::cout << (lightSource == SOURCE_SUN ? "Solar" : "Lunar") << " textures: " << model.timings().total << " s, " << model.num_threads() << " threads" << std::endl;
+    }
+    return true;
+}
+
+void CpuReference::Start(const ModelParameters& parameters, const Model& gpuModel, int lightSource)
+{
+    if (IsRunning() || !IsSupported(gpuModel)) return;
+
+    std::vector<float> gpuTextures(gpuModel.GetPrecomputedTexturesSize());
+    gpuModel.GetPrecomputedTextures(gpuTextures.data());
+
+    // The GPU precomputation may have stopped before the maximum number of orders
+    ModelParameters cpuParameters = parameters;
+    cpuParameters.numScatteringOrders = gpuModel.num_precomputed_scattering_orders();
+
+    m_future = std::async(std::launch::async, &CpuReference::Run, cpuParameters, lightSource, std::move(gpuTextures));
+}
+
+bool CpuReference::Poll()
+{
+    if (!IsRunning() || m_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+    m_result = m_future.get();
+    m_hasResult = true;
+    return true;
+}
+
+CpuReference::Result CpuReference::Run(ModelParameters parameters, int lightSource, std::vector<float> gpuTextures)
+{
+    cpu::Model model(ToAtmosphereParameters(parameters), lightSource);
+    model.Init(parameters.numScatteringOrders);
+
+    std::vector<float> cpuTextures(cpu::Model::GetPrecomputedTexturesSize());
+    model.GetPrecomputedTextures(cpuTextures.data());
+
+    const cpu::Model::Timings& timings = model.timings();
+    Result result;
+    result.numThreads = model.num_threads();
+    result.transmittanceSeconds = timings.transmittance;
+    result.directIrradianceSeconds = timings.direct_irradiance;
+    result.singleScatteringSeconds = timings.single_scattering;
+    result.scatteringDensitySeconds = timings.scattering_density;
+    result.indirectIrradianceSeconds = timings.indirect_irradiance;
+    result.multipleScatteringSeconds = timings.multiple_scattering;
+    result.totalSeconds = timings.total;
+
+    constexpr std::size_t kTransmittanceSize = 3 * TRANSMITTANCE_TEXTURE_WIDTH * TRANSMITTANCE_TEXTURE_HEIGHT;
+    constexpr std::size_t kScatteringSize = 3 * SCATTERING_TEXTURE_WIDTH * SCATTERING_TEXTURE_HEIGHT * SCATTERING_TEXTURE_DEPTH;
+    constexpr std::size_t kIrradianceSize = 3 * IRRADIANCE_TEXTURE_WIDTH * IRRADIANCE_TEXTURE_HEIGHT;
+    const float* gpu = gpuTextures.data();
+    const float* cpu = cpuTextures.data();
+    result.differences[0] = Compare("Transmittance", gpu, cpu, kTransmittanceSize);
+    gpu += kTransmittanceSize;
+    cpu += kTransmittanceSize;
+    result.differences[1] = Compare("Scattering", gpu, cpu, kScatteringSize);
+    gpu += kScatteringSize;
+    cpu += kScatteringSize;
+    result.differences[2] = Compare("Single Mie Scattering", gpu, cpu, kScatteringSize);
+    gpu += kScatteringSize;
+    cpu += kScatteringSize;
+    result.differences[3] = Compare("Irradiance", gpu, cpu, kIrradianceSize);
+    return result;
+}
\ No newline at end of file
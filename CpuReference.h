@@ -0,0 +1,58 @@
+#pragma once
+
+#include "AtmospherePrecomputer.h"
+#include "LutCache.h"
+
+#include <atmosphere/model.h>
+
+#include <array>
+#include <future>
+#include <vector>
+
+// Precomputes the textures of a model with the multithreaded CPU implementation
+// of the atmosphere (atmosphere/cpu) on a background task, and compares them
+// with the textures precomputed on GPU. The GPU textures are read back by Start,
+// so it must be called from a thread with a current OpenGL context. Precompute
+// needs none, it stores the CPU textures in a LUT cache for the GPU models to
+// load (e.g. to fill the cache on a machine without a GPU).
+class CpuReference
+{
+public:
+    struct TextureDifference
+    {
+        const char* name;
+        float maxAbsoluteError;
+        float maxRelativeError;
+        float rmsRelativeError;
+    };
+    struct Result
+    {
+        unsigned int numThreads;
+        double transmittanceSeconds;
+        double directIrradianceSeconds;
+        double singleScatteringSeconds;
+        double scatteringDensitySeconds;
+        double indirectIrradianceSeconds;
+        double multipleScatteringSeconds;
+        double totalSeconds;
+        std::array<TextureDifference, 4> differences;
+    };
+public:
+    CpuReference();
+    ~CpuReference() = default;
+    // The CPU implementation only supports the default texture resolution
+    static bool IsSupported(const atmosphere::Model& gpuModel);
+    static bool IsSupported(const ModelParameters& parameters);
+    static bool Precompute(const ModelParameters& parameters, LutCache& lutCache);
+    void Start(const ModelParameters& parameters, const atmosphere::Model& gpuModel, int lightSource);
+    bool IsRunning() const { return m_future.valid(); }
+    bool Poll();
+    bool HasResult() const { return m_hasResult; }
+    const Result& GetResult() const { return m_result; }
+private:
+    static Result Run(ModelParameters parameters, int lightSource, std::vector<float> gpuTextures);
+private:
+    std::future<Result> m_future;
+    Result m_result;
+    bool m_hasResult;
+};
\ No newline at end of file
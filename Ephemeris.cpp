@@ -0,0 +1,460 @@
+#include "Ephemeris.h"
+#include "EphemerisMath.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    constexpr double kKilometersPerAu = 149597870.7;
+    constexpr double kArcsecondsPerRadian = 206264.80624709636;
+
+    // Term of the longitude and distance of the Moon, in 1e-6 degrees and 1e-3 km
+    struct MoonLongitudeDistanceTerm
+    {
+        int d;
+        int m;
+        int mp;
+        int f;
+        double longitude;
+        double distance;
+    };
+
+    // See: Meeus 1998, table 47.A
+    constexpr MoonLongitudeDistanceTerm kMoonLongitudeDistanceTerms[] =
+    {
+        {0, 0, 1, 0, 6288774, -20905355},
+        {2, 0, -1, 0, 1274027, -3699111},
+        {2, 0, 0, 0, 658314, -2955968},
+        {0, 0, 2, 0, 213618, -569925},
+        {0, 1, 0, 0, -185116, 48888},
+        {0, 0, 0, 2, -114332, -3149},
+        {2, 0, -2, 0, 58793, 246158},
+        {2, -1, -1, 0, 57066, -152138},
+        {2, 0, 1, 0, 53322, -170733},
+        {2, -1, 0, 0, 45758, -204586},
+        {0, 1, -1, 0, -40923, -129620},
+        {1, 0, 0, 0, -34720, 108743},
+        {0, 1, 1, 0, -30383, 104755},
+        {2, 0, 0, -2, 15327, 10321},
+        {0, 0, 1, 2, -12528, 0},
+        {0, 0, 1, -2, 10980, 79661},
+        {4, 0, -1, 0, 10675, -34782},
+        {0, 0, 3, 0, 10034, -23210},
+        {4, 0, -2, 0, 8548, -21636},
+        {2, 1, -1, 0, -7888, 24208},
+        {2, 1, 0, 0, -6766, 30824},
+        {1, 0, -1, 0, -5163, -8379},
+        {1, 1, 0, 0, 4987, -16675},
+        {2, -1, 1, 0, 4036, -12831},
+        {2, 0, 2, 0, 3994, -10445},
+        {4, 0, 0, 0, 3861, -11650},
+        {2, 0, -3, 0, 3665, 14403},
+        {0, 1, -2, 0, -2689, -7003},
+        {2, 0, -1, 2, -2602, 0},
+        {2, -1, -2, 0, 2390, 10056},
+        {1, 0, 1, 0, -2348, 6322},
+        {2, -2, 0, 0, 2236, -9884},
+        {0, 1, 2, 0, -2120, 5751},
+        {0, 2, 0, 0, -2069, 0},
+        {2, -2, -1, 0, 2048, -4950},
+        {2, 0, 1, -2, -1773, 4130},
+        {2, 0, 0, 2, -1595, 0},
+        {4, -1, -1, 0, 1215, -3958},
+        {0, 0, 2, 2, -1110, 0},
+        {3, 0, -1, 0, -892, 3258},
+        {2, 1, 1, 0, -810, 2616},
+        {4, -1, -2, 0, 759, -1897},
+        {0, 2, -1, 0, -713, -2117},
+        {2, 2, -1, 0, -700, 2354},
+        {2, 1, -2, 0, 691, 0},
+        {2, -1, 0, -2, 596, 0},
+        {4, 0, 1, 0, 549, -1423},
+        {0, 0, 4, 0, 537, -1117},
+        {4, -1, 0, 0, 520, -1571},
+        {1, 0, -2, 0, -487, -1739},
+        {2, 1, 0, -2, -399, 0},
+        {0, 0, 2, -2, -381, -4421},
+        {1, 1, 1, 0, 351, 0},
+        {3, 0, -2, 0, -340, 0},
+        {4, 0, -3, 0, 330, 0},
+        {2, -1, 2, 0, 327, 0},
+        {0, 2, 1, 0, -323, 1165},
+        {1, 1, -1, 0, 299, 0},
+        {2, 0, 3, 0, 294, 0},
+        {2, 0, -1, -2, 0, 8752},
+    };
+
+    // See: Meeus 1998, table 47.B, in 1e-6 degrees
+    constexpr EphemerisMath::LunarTerm kMoonLatitudeTerms[] =
+    {
+        {0, 0, 0, 1, 5128122},
+        {0, 0, 1, 1, 280602},
+        {0, 0, 1, -1, 277693},
+        {2, 0, 0, -1, 173237},
+        {2, 0, -1, 1, 55413},
+        {2, 0, -1, -1, 46271},
+        {2, 0, 0, 1, 32573},
+        {0, 0, 2, 1, 17198},
+        {2, 0, 1, -1, 9266},
+        {0, 0, 2, -1, 8822},
+        {2, -1, 0, -1, 8216},
+        {2, 0, -2, -1, 4324},
+        {2, 0, 1, 1, 4200},
+        {2, 1, 0, -1, -3359},
+        {2, -1, -1, 1, 2463},
+        {2, -1, 0, 1, 2211},
+        {2, -1, -1, -1, 2065},
+        {0, 1, -1, -1, -1870},
+        {4, 0, -1, -1, 1828},
+        {0, 1, 0, 1, -1794},
+        {0, 0, 0, 3, -1749},
+        {0, 1, -1, 1, -1565},
+        {1, 0, 0, 1, -1491},
+        {0, 1, 1, 1, -1475},
+        {0, 1, 1, -1, -1410},
+        {0, 1, 0, -1, -1344},
+        {1, 0, 0, -1, -1335},
+        {0, 0, 3, 1, 1107},
+        {4, 0, 0, -1, 1021},
+        {4, 0, -1, 1, 833},
+        {0, 0, 1, -3, 777},
+        {4, 0, -2, 1, 671},
+        {2, 0, 0, -3, 607},
+        {2, 0, 2, -1, 596},
+        {2, -1, 1, -1, 491},
+        {2, 0, -2, 1, -451},
+        {0, 0, 3, -1, 439},
+        {2, 0, 2, 1, 422},
+        {2, 0, -3, -1, 421},
+        {2, 1, -1, 1, -366},
+        {2, 1, 0, 1, -351},
+        {4, 0, 0, 1, 331},
+        {2, -1, 1, 1, 315},
+        {2, -2, 0, -1, 302},
+        {0, 0, 1, 3, -283},
+        {2, 1, 1, -1, -229},
+        {1, 1, 0, -1, 223},
+        {1, 1, 0, 1, 223},
+        {0, 1, -2, -1, -220},
+        {2, 1, -1, -1, -220},
+        {1, 0, 1, 1, -185},
+        {2, -1, -2, -1, 181},
+        {0, 1, 2, 1, -177},
+        {4, 0, -2, -1, 176},
+        {4, -1, -1, -1, 166},
+        {1, 0, 1, -1, -164},
+        {4, 0, 1, -1, 132},
+        {1, 0, -1, -1, -119},
+        {4, -1, 0, -1, 115},
+        {2, -2, 0, 1, 107},
+    };
+
+    // A * cos(B + C * tau), the frequencies of VSOP87 are not integer multiples of a few arguments
+    struct VsopTerm
+    {
+        double a;
+        double b;
+        double c;
+    };
+
+    // Heliocentric coordinates of the Earth, see: Meeus 1998, appendix III, in 1e-8 radians and AU
+    constexpr VsopTerm kEarthL0[] =
+    {
+        {175347046, 0, 0}, {3341656, 4.6692568, 6283.0758500}, {34894, 4.62610, 12566.15170}, {3497, 2.7441, 5753.3849},
+        {3418, 2.8289, 3.5231}, {3136, 3.6277, 77713.7715}, {2676, 4.4181, 7860.4194}, {2343, 6.1352, 3930.2097},
+        {1324, 0.7425, 11506.7698}, {1273, 2.0371, 529.6910}, {1199, 1.1096, 1577.3435}, {990, 5.233, 5884.927},
+        {902, 2.045, 26.298}, {857, 3.508, 398.149}, {780, 1.179, 5223.694}, {753, 2.533, 5507.553},
+        {505, 4.583, 18849.228}, {492, 4.205, 775.523}, {357, 2.920, 0.067}, {317, 5.849, 11790.629},
+        {284, 1.899, 796.298}, {271, 0.315, 10977.079}, {243, 0.345, 5486.778}, {206, 4.806, 2544.314},
+        {205, 1.869, 5573.143}, {202, 2.458, 6069.777}, {156, 0.833, 213.299}, {132, 3.411, 2942.463},
+        {126, 1.083, 20.775}, {115, 0.645, 0.980}, {103, 0.636, 4694.003}, {102, 0.976, 15720.839},
+        {102, 4.267, 7.114}, {99, 6.21, 2146.17}, {98, 0.68, 155.42}, {86, 5.98, 161000.69},
+        {85, 1.30, 6275.96}, {85, 3.67, 71430.70}, {80, 1.81, 17260.15}, {79, 3.04, 12036.46},
+        {75, 1.76, 5088.63}, {74, 3.50, 3154.69}, {74, 4.68, 801.82}, {70, 0.83, 9437.76},
+        {62, 3.98, 8827.39}, {61, 1.82, 7084.90}, {57, 2.78, 6286.60}, {56, 4.39, 14143.50},
+        {56, 3.47, 6279.55}, {52, 0.19, 12139.55}, {52, 1.33, 1748.02}, {51, 0.28, 5856.48},
+        {49, 0.49, 1194.45}, {41, 5.37, 8429.24}, {41, 2.40, 19651.05}, {39, 6.17, 10447.39},
+        {37, 6.04, 10213.29}, {37, 2.57, 1059.38}, {36, 1.71, 2352.87}, {36, 1.78, 6812.77},
+        {33, 0.59, 17789.85}, {30, 0.44, 83996.85}, {30, 2.74, 1349.87}, {25, 3.16, 4690.48},
+    };
+
+    constexpr VsopTerm kEarthL1[] =
+    {
+        {628331966747, 0, 0}, {206059, 2.678235, 6283.075850}, {4303, 2.6351, 12566.1517}, {425, 1.590, 3.523},
+        {119, 5.796, 26.298}, {109, 2.966, 1577.344}, {93, 2.59, 18849.23}, {72, 1.14, 529.69},
+        {68, 1.87, 398.15}, {67, 4.41, 5507.55}, {59, 2.89, 5223.69}, {56, 2.17, 155.42},
+        {45, 0.40, 796.30}, {36, 0.47, 775.52}, {29, 2.65, 7.11}, {21, 5.34, 0.98},
+        {19, 1.85, 5486.78}, {19, 4.97, 213.30}, {17, 2.99, 6275.96}, {16, 0.03, 2544.31},
+        {16, 1.43, 2146.17}, {15, 1.21, 10977.08}, {12, 2.83, 1748.02}, {12, 3.26, 5088.63},
+        {12, 5.27, 1194.45}, {12, 2.08, 4694.00}, {11, 0.77, 553.57}, {10, 1.30, 6286.60},
+        {10, 4.24, 1349.87}, {9, 2.70, 242.73}, {9, 5.64, 951.72}, {8, 5.30, 2352.87},
+        {6, 2.65, 9437.76}, {6, 4.67, 4690.48},
+    };
+
+    constexpr VsopTerm kEarthL2[] =
+    {
+        {52919, 0, 0}, {8720, 1.0721, 6283.0758}, {309, 0.867, 12566.152}, {27, 0.05, 3.52},
+        {16, 5.19, 26.30}, {16, 3.68, 155.42}, {10, 0.76, 18849.23}, {9, 2.06, 77713.77},
+        {7, 0.83, 775.52}, {5, 4.66, 1577.34}, {4, 1.03, 7.11}, {4, 3.44, 5573.14},
+        {3, 5.14, 796.30}, {3, 6.05, 5507.55}, {3, 1.19, 242.73}, {3, 6.12, 529.69},
+        {3, 0.31, 398.15}, {3, 2.28, 553.57}, {2, 4.38, 5223.69}, {2, 3.75, 0.98},
+    };
+
+    constexpr VsopTerm kEarthL3[] =
+    {
+        {289, 5.844, 6283.076}, {35, 0, 0}, {17, 5.49, 12566.15}, {3, 5.20, 155.42},
+        {1, 4.72, 3.52}, {1, 5.30, 18849.23}, {1, 5.97, 242.73},
+    };
+
+    constexpr VsopTerm kEarthL4[] = {{114, 3.142, 0}, {8, 4.13, 6283.08}, {1, 3.84, 12566.15}};
+    constexpr VsopTerm kEarthL5[] = {{1, 3.14, 0}};
+
+    constexpr VsopTerm kEarthB0[] = {{280, 3.199, 84334.662}, {102, 5.422, 5507.553}, {80, 3.88, 5223.69}, {44, 3.70, 2352.87}, {32, 4.00, 1577.34}};
+    constexpr VsopTerm kEarthB1[] = {{9, 3.90, 5507.55}, {6, 1.73, 5223.69}};
+
+    constexpr VsopTerm kEarthR0[] =
+    {
+        {100013989, 0, 0}, {1670700, 3.0984635, 6283.0758500}, {13956, 3.05525, 12566.15170}, {3084, 5.1985, 77713.7715},
+        {1628, 1.1739, 5753.3849}, {1576, 2.8469, 7860.4194}, {925, 5.453, 11506.770}, {542, 4.564, 3930.210},
+        {472, 3.661, 5884.927}, {346, 0.964, 5507.553}, {329, 5.900, 5223.694}, {307, 0.299, 5573.143},
+        {243, 4.273, 11790.629}, {212, 5.847, 1577.344}, {186, 5.022, 10977.079}, {175, 3.012, 18849.228},
+        {110, 5.055, 5486.778}, {98, 0.89, 6069.78}, {86, 5.69, 15720.84}, {86, 1.27, 161000.69},
+        {65, 0.27, 17260.15}, {63, 0.92, 529.69}, {57, 2.01, 83996.85}, {56, 5.24, 71430.70},
+        {49, 3.25, 2544.31}, {47, 2.58, 775.52}, {45, 5.54, 9437.76}, {43, 6.01, 6275.96},
+        {39, 5.36, 4694.00}, {38, 2.39, 8827.39}, {37, 0.83, 19651.05}, {37, 4.90, 12139.55},
+        {36, 1.67, 12036.46}, {35, 1.84, 2942.46}, {33, 0.24, 7084.90}, {32, 0.18, 5088.63},
+        {32, 1.78, 398.15}, {28, 1.21, 6286.60}, {28, 1.90, 6279.55}, {26, 4.59, 10447.39},
+    };
+
+    constexpr VsopTerm kEarthR1[] =
+    {
+        {103019, 1.107490, 6283.075850}, {1721, 1.0644, 12566.1517}, {702, 3.142, 0}, {32, 1.02, 18849.23},
+        {31, 2.84, 5507.55}, {25, 1.32, 5223.69}, {18, 1.42, 1577.34}, {10, 5.91, 10977.08},
+        {9, 1.42, 6275.96}, {9, 0.27, 5486.78},
+    };
+
+    constexpr VsopTerm kEarthR2[] = {{4359, 5.7846, 6283.0758}, {124, 5.579, 12566.152}, {12, 3.14, 0}, {9, 3.63, 77713.77}, {6, 1.87, 5573.14}, {3, 5.47, 18849.23}};
+    constexpr VsopTerm kEarthR3[] = {{145, 4.273, 6283.076}, {7, 3.92, 12566.15}};
+    constexpr VsopTerm kEarthR4[] = {{4, 2.56, 6283.08}};
+
+    template <std::size_t N>
+    double SumVsopTerms(const VsopTerm (&terms)[N], double tau)
+    {
+        double sum = 0.0;
+        for (const VsopTerm& term : terms) sum += term.a * std::cos(term.b + term.c * tau);
+        return sum;
+    }
+
+    double Radians(double degrees)
+    {
+        return degrees * (glm::pi<double>() / 180.0);
+    }
+
+    // Geometric coordinates, referred to the mean equinox of date and to the FK5 system
+    glm::dvec3 SunEclipticCoordinates(double T)
+    {
+        double tau = T / 10.0; // Julian millennia
+        double L = (SumVsopTerms(kEarthL0, tau) + tau * (SumVsopTerms(kEarthL1, tau) + tau * (SumVsopTerms(kEarthL2, tau)
+            + tau * (SumVsopTerms(kEarthL3, tau) + tau * (SumVsopTerms(kEarthL4, tau) + tau * SumVsopTerms(kEarthL5, tau)))))) * 1e-8;
+        double B = (SumVsopTerms(kEarthB0, tau) + tau * SumVsopTerms(kEarthB1, tau)) * 1e-8;
+        double R = (SumVsopTerms(kEarthR0, tau) + tau * (SumVsopTerms(kEarthR1, tau) + tau * (SumVsopTerms(kEarthR2, tau)
+            + tau * (SumVsopTerms(kEarthR3, tau) + tau * SumVsopTerms(kEarthR4, tau))))) * 1e-8;
+
+        double lambda = L + glm::pi<double>();
+        double beta = -B;
+        double lambdaP = lambda - Radians(1.397 * T + 0.00031 * T * T);
+        lambda -= 0.09033 / kArcsecondsPerRadian;
+        beta += 0.03916 * (std::cos(lambdaP) - std::sin(lambdaP)) / kArcsecondsPerRadian;
+        return glm::dvec3(lambda, beta, R);
+    }
+
+    glm::dvec3 MoonEclipticCoordinates(double T)
+    {
+        double T2 = T * T;
+        double T3 = T2 * T;
+        double T4 = T3 * T;
+        double Lp = Radians(218.3164477 + 481267.88123421 * T - 0.0015786 * T2 + T3 / 538841.0 - T4 / 65194000.0);
+        double D = Radians(297.8501921 + 445267.1114034 * T - 0.0018819 * T2 + T3 / 545868.0 - T4 / 113065000.0);
+        double M = Radians(357.5291092 + 35999.0502909 * T - 0.0001536 * T2 + T3 / 24490000.0);
+        double Mp = Radians(134.9633964 + 477198.8675055 * T + 0.0087414 * T2 + T3 / 69699.0 - T4 / 14712000.0);
+        double F = Radians(93.2720950 + 483202.0175233 * T - 0.0036539 * T2 - T3 / 3526000.0 + T4 / 863310000.0);
+        double A1 = Radians(119.75 + 131.849 * T);
+        double A2 = Radians(53.09 + 479264.290 * T);
+        double A3 = Radians(313.45 + 481266.484 * T);
+        double E = 1.0 - 0.002516 * T - 0.0000074 * T2; // Decreasing eccentricity of the orbit of the Earth
+        double eccentricityFactors[] = {1.0, E, E * E};
+
+        EphemerisMath::LunarArguments<double, 4> arguments =
+        {
+            EphemerisMath::AngleMultiples<double, 4>(D),
+            EphemerisMath::AngleMultiples<double, 4>(M),
+            EphemerisMath::AngleMultiples<double, 4>(Mp),
+            EphemerisMath::AngleMultiples<double, 4>(F),
+        };
+
+        double sumL = 0.0;
+        double sumR = 0.0;
+        for (const MoonLongitudeDistanceTerm& term : kMoonLongitudeDistanceTerms)
+        {
+            EphemerisMath::SinCosPair<double> argument = arguments.Get(term.d, term.m, term.mp, term.f);
+            double factor = eccentricityFactors[std::abs(term.m)];
+            sumL += factor * term.longitude * argument.s;
+            sumR += factor * term.distance * argument.c;
+        }
+
+        double sumB = 0.0;
+        for (const EphemerisMath::LunarTerm& term : kMoonLatitudeTerms)
+            sumB += eccentricityFactors[std::abs(term.m)] * term.coefficient * arguments.Get(term.d, term.m, term.mp, term.f).s;
+
+        // Action of Venus, Jupiter and the flattening of the Earth
+        sumL += 3958.0 * std::sin(A1) + 1962.0 * std::sin(Lp - F) + 318.0 * std::sin(A2);
+        sumB += -2235.0 * std::sin(Lp) + 382.0 * std::sin(A3) + 175.0 * std::sin(A1 - F) + 175.0 * std::sin(A1 + F) + 127.0 * std::sin(Lp - Mp) - 115.0 * std::sin(Lp + Mp);
+
+        double lambda = Lp + Radians(sumL * 1e-6);
+        double beta = Radians(sumB * 1e-6);
+        double r = (385000.56 + sumR * 1e-3) / kKilometersPerAu;
+        return glm::dvec3(lambda, beta, r);
+    }
+
+    struct Errors
+    {
+        double sunLongitude; // Arcseconds
+        double moonLongitude; // Arcseconds
+        double moonLatitude; // Arcseconds
+        double moonDistance; // Kilometers
+    };
+
+    Errors MaxErrors(const std::vector<glm::dvec3>& sun, const std::vector<glm::dvec3>& moon, const std::vector<glm::dvec3>& referenceSun, const std::vector<glm::dvec3>& referenceMoon)
+    {
+        Errors errors = {};
+        for (std::size_t i = 0; i < sun.size(); ++i)
+        {
+            errors.sunLongitude = std::max(errors.sunLongitude, std::abs(std::remainder(sun[i].x - referenceSun[i].x, 2.0 * glm::pi<double>())) * kArcsecondsPerRadian);
+            errors.moonLongitude = std::max(errors.moonLongitude, std::abs(std::remainder(moon[i].x - referenceMoon[i].x, 2.0 * glm::pi<double>())) * kArcsecondsPerRadian);
+            errors.moonLatitude = std::max(errors.moonLatitude, std::abs(moon[i].y - referenceMoon[i].y) * kArcsecondsPerRadian);
+            errors.moonDistance = std::max(errors.moonDistance, std::abs(moon[i].z - referenceMoon[i].z) * kKilometersPerAu);
+        }
+        return errors;
+    }
+}
+
+Ephemeris::Ephemeris()
+    : m_tier(Tier::LOW_PRECISION)
+    , m_tableFirstSample(0)
+    , m_sunTable()
+    , m_moonTable()
+{
+}
+
+void Ephemeris::Compute(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates)
+{
+    switch (m_tier)
+    {
+    case Tier::LOW_PRECISION:
+        ComputeLowPrecision(T, sunEclipticCoordinates, moonEclipticCoordinates);
+        break;
+    case Tier::TRUNCATED_SERIES:
+        ComputeTruncatedSeries(T, sunEclipticCoordinates, moonEclipticCoordinates);
+        break;
+    case Tier::TABULATED:
+        ComputeTabulated(T, sunEclipticCoordinates, moonEclipticCoordinates);
+        break;
+    default:
+        std::cerr << "[Ephemeris] E: Unknown Tier " << static_cast<int>(m_tier) << ", using the low precision one." << std::endl;
+        ComputeLowPrecision(T, sunEclipticCoordinates, moonEclipticCoordinates);
+        break;
+    }
+}
+
+void Ephemeris::ComputeLowPrecision(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates)
+{
+    EphemerisMath::Vector3<double> sun = EphemerisMath::SunEclipticCoordinates(T);
+    EphemerisMath::Vector3<double> moon = EphemerisMath::MoonEclipticCoordinates(T);
+    sunEclipticCoordinates = glm::dvec3(sun.x, sun.y, sun.z);
+    moonEclipticCoordinates = glm::dvec3(moon.x, moon.y, moon.z);
+}
+
+void Ephemeris::ComputeTruncatedSeries(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates)
+{
+    sunEclipticCoordinates = SunEclipticCoordinates(T);
+    moonEclipticCoordinates = MoonEclipticCoordinates(T);
+}
+
+const char* Ephemeris::GetTierName(Tier tier)
+{
+    switch (tier)
+    {
+    case Tier::LOW_PRECISION: return "Low Precision";
+    case Tier::TRUNCATED_SERIES: return "Truncated Series";
+    case Tier::TABULATED: return "Tabulated";
+    }
+    return "";
+}
+
+// The longitudes of the series are not reduced to [0, 2pi), so that they can be interpolated
+void Ephemeris::ComputeTabulated(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates)
+{
+    double x = T / kTableStep;
+    long long sample = static_cast<long long>(std::floor(x));
+    long long index = sample - m_tableFirstSample;
+    if (m_sunTable.empty() || index < 1 || index > kTableSize - 3)
+    {
+        FillTable(T);
+        index = sample - m_tableFirstSample;
+    }
+
+    double t = x - static_cast<double>(sample);
+    std::size_t i = static_cast<std::size_t>(index);
+    sunEclipticCoordinates = EphemerisMath::InterpolateHermite(m_sunTable[i - 1], m_sunTable[i], m_sunTable[i + 1], m_sunTable[i + 2], t);
+    moonEclipticCoordinates = EphemerisMath::InterpolateHermite(m_moonTable[i - 1], m_moonTable[i], m_moonTable[i + 1], m_moonTable[i + 2], t);
+}
+
+// Centered on T, with the samples at multiples of the step so that the results do not depend on when it is filled
+void Ephemeris::FillTable(double T)
+{
+    m_tableFirstSample = static_cast<long long>(std::floor(T / kTableStep)) - (kTableSize - 1) / 2;
+    m_sunTable.resize(kTableSize);
+    m_moonTable.resize(kTableSize);
+    for (int i = 0; i < kTableSize; ++i)
+        ComputeTruncatedSeries(static_cast<double>(m_tableFirstSample + i) * kTableStep, m_sunTable[i], m_moonTable[i]);
+}
+
+// A year at 1 minute steps, as consecutive frames of a fast time-lapse
+void Ephemeris::RunBenchmark(std::size_t count)
+{
+    // See: Meeus 1998, examples 47.a and 25.b
+    glm::dvec3 sun, moon;
+    ComputeTruncatedSeries(EphemerisMath::JulianCenturies(2448724.5), sun, moon);
+    std::cout << "Truncated series, Meeus example 47.a | Moon Longitude: " << std::remainder(glm::degrees(moon.x) - 133.162655, 360.0) * 3600.0
+        << "\", Moon Latitude: " << (glm::degrees(moon.y) + 3.229126) * 3600.0 << "\", Moon Distance: " << moon.z * kKilometersPerAu - 368409.7 << " km" << std::endl;
+    ComputeTruncatedSeries(EphemerisMath::JulianCenturies(2448908.5), sun, moon);
+    std::cout << "Truncated series, Meeus example 25.b | Sun Longitude: " << std::remainder(glm::degrees(sun.x) - 199.907347, 360.0) * 3600.0
+        << "\", Sun Latitude: " << (glm::degrees(sun.y) * 3600.0 - 0.62) << "\", Sun Distance: " << sun.z - 0.99760775 << " AU" << std::endl;
+
+    std::vector<double> T(count);
+    for (std::size_t i = 0; i < count; ++i) T[i] = EphemerisMath::JulianCenturies(2459862.5 + static_cast<double>(i % 525600) / 1440.0);
+
+    std::vector<glm::dvec3> referenceSun(count), referenceMoon(count);
+    for (std::size_t i = 0; i < count; ++i) ComputeTruncatedSeries(T[i], referenceSun[i], referenceMoon[i]);
+
+    std::cout << "Ephemeris tiers, " << count << " consecutive minutes, errors with respect to the truncated series" << std::endl;
+    for (Tier tier : {Tier::LOW_PRECISION, Tier::TRUNCATED_SERIES, Tier::TABULATED})
+    {
+        Ephemeris ephemeris;
+        ephemeris.SetTier(tier);
+        std::vector<glm::dvec3> sunCoordinates(count), moonCoordinates(count);
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < count; ++i) ephemeris.Compute(T[i], sunCoordinates[i], moonCoordinates[i]);
+        auto end = std::chrono::steady_clock::now();
+
+        double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(count);
+        Errors errors = MaxErrors(sunCoordinates, moonCoordinates, referenceSun, referenceMoon);
+        std::cout << GetTierName(tier) << ": " << nanoseconds << " ns/evaluation | Max error | Sun Longitude: " << errors.sunLongitude
+            << "\", Moon Longitude: " << errors.moonLongitude << "\", Moon Latitude: " << errors.moonLatitude << "\", Moon Distance: " << errors.moonDistance << " km" << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Geocentric ecliptic coordinates of the Sun and the Moon (longitude, latitude and
+// distance, in radians and AU, referred to the mean ecliptic and equinox of date)
+// with a selectable accuracy tier:
+//   LOW_PRECISION: Jensen 2001 series (see EphemerisMath.h), about 1' for the Sun
+//     and a few ' for the Moon, the cheapest.
+//   TRUNCATED_SERIES: ELP-2000/82 truncated to its 120 largest terms for the Moon
+//     (see: Meeus 1998, chapter 47), about 10" in longitude and 4" in latitude, and
+//     VSOP87 truncated for the Sun (see: Meeus 1998, appendix III), about 1".
+//   TABULATED: the truncated series sampled every hour over two days and
+//     interpolated with cubic Hermite splines. As precise as them within a few
+//     milliarcseconds, for about the cost of the low precision series, as long as
+//     consecutive evaluations are close in time (the table is refilled when they
+//     leave it).
+// Running miri-tfm --ephemeris-benchmark <instants> reports the cost and accuracy
+// of each tier with respect to the truncated series.
+class Ephemeris
+{
+public:
+    enum class Tier {LOW_PRECISION, TRUNCATED_SERIES, TABULATED};
+public:
+    Ephemeris();
+    void SetTier(Tier tier) { m_tier = tier; }
+    Tier GetTier() const { return m_tier; }
+    // T in Julian centuries of Terrestrial Time since J2000
+    void Compute(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates);
+    static void ComputeLowPrecision(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates);
+    static void ComputeTruncatedSeries(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates);
+    static const char* GetTierName(Tier tier);
+    static void RunBenchmark(std::size_t count);
+private:
+    void ComputeTabulated(double T, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates);
+    void FillTable(double T);
+private:
+    static constexpr double kTableStep = 1.0 / (24.0 * 36525.0); // 1 hour, in Julian centuries
+    static constexpr int kTableSize = 49;
+private:
+    Tier m_tier;
+    long long m_tableFirstSample; // Index of the first sample, at T = m_tableFirstSample * kTableStep
+    std::vector<glm::dvec3> m_sunTable;
+    std::vector<glm::dvec3> m_moonTable;
+};
\ No newline at end of file
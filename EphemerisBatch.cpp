@@ -0,0 +1,172 @@
+#include "EphemerisBatch.h"
+#include "EphemerisMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+using EphemerisMath::Lanes;
+
+namespace
+{
+    constexpr std::size_t kMinCountPerThread = 16384; // Below it, starting a thread costs more than it saves
+
+    // Of one instant (Real = double) or of a group of them (Real = Lanes)
+    template <typename Real>
+    struct Instant
+    {
+        EphemerisMath::Vector3<Real> sunHorizon;
+        EphemerisMath::Vector3<Real> moonHorizon;
+        Real moonPhaseAngle;
+    };
+
+    template <typename Real>
+    Instant<Real> ComputeInstant(const Real& JD, const Real& lon, const Real& lat)
+    {
+        using namespace EphemerisMath;
+        Real T = JulianCenturies(JD + DeltaT(JD) / 86400.0); // Terrestrial Time
+        Real T_ = JulianCenturies(JD); // Universal Time
+
+        Vector3<Real> sunRectangular = SphericalToRectangular(SunEclipticCoordinates(T));
+        Vector3<Real> moonRectangular = SphericalToRectangular(MoonEclipticCoordinates(T));
+
+        Instant<Real> instant;
+        instant.sunHorizon = RectangularToSpherical(RectangularEquatorialToRectangularHorizon(RectangularEclipticToRectangularEquatorial(sunRectangular, T), T, T_, lon, lat));
+        instant.moonHorizon = RectangularToSpherical(RectangularEquatorialToRectangularHorizon(RectangularEclipticToRectangularEquatorial(moonRectangular, T), T, T_, lon, lat));
+        instant.moonPhaseAngle = static_cast<double>(glm::pi<float>()) - EarthPhaseAngle(sunRectangular, moonRectangular);
+        return instant;
+    }
+
+    double AngleDifference(double a, double b)
+    {
+        return std::abs(std::remainder(a - b, 2.0 * glm::pi<double>()));
+    }
+
+    double MaxAngleDifference(const std::vector<double>& a, const std::vector<double>& b)
+    {
+        double result = 0.0;
+        for (std::size_t i = 0; i < a.size(); ++i) result = std::max(result, AngleDifference(a[i], b[i]));
+        return result;
+    }
+
+    double MaxRelativeDifference(const std::vector<double>& a, const std::vector<double>& b)
+    {
+        double result = 0.0;
+        for (std::size_t i = 0; i < a.size(); ++i) result = std::max(result, std::abs(a[i] - b[i]) / std::abs(b[i]));
+        return result;
+    }
+}
+
+void EphemerisBatch::Compute(const double* JD, const double* lon, const double* lat, std::size_t count, Positions& positions, unsigned int numThreads)
+{
+    Resize(positions, count);
+    if (numThreads == 0) numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    numThreads = static_cast<unsigned int>(std::min<std::size_t>(numThreads, std::max<std::size_t>(count / kMinCountPerThread, 1)));
+    if (numThreads == 1)
+    {
+        ComputeRange(JD, lon, lat, 0, count, positions);
+        return;
+    }
+
+    // Ranges of whole groups of lanes, the calling thread computes the last one
+    std::size_t countPerThread = (count / numThreads + Lanes::kWidth - 1) / Lanes::kWidth * Lanes::kWidth;
+    std::vector<std::thread> threads;
+    std::size_t begin = 0;
+    for (unsigned int i = 0; i + 1 < numThreads && begin < count; ++i)
+    {
+        std::size_t end = std::min(begin + countPerThread, count);
+        threads.emplace_back(&EphemerisBatch::ComputeRange, JD, lon, lat, begin, end, std::ref(positions));
+        begin = end;
+    }
+    ComputeRange(JD, lon, lat, begin, count, positions);
+    for (std::thread& thread : threads) thread.join();
+}
+
+void EphemerisBatch::ComputeScalar(const double* JD, const double* lon, const double* lat, std::size_t count, Positions& positions)
+{
+    Resize(positions, count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Instant<double> instant = ComputeInstant(JD[i], lon[i], lat[i]);
+        positions.sunAzimuth[i] = instant.sunHorizon.x;
+        positions.sunAltitude[i] = instant.sunHorizon.y;
+        positions.sunDistance[i] = instant.sunHorizon.z;
+        positions.moonAzimuth[i] = instant.moonHorizon.x;
+        positions.moonAltitude[i] = instant.moonHorizon.y;
+        positions.moonDistance[i] = instant.moonHorizon.z;
+        positions.moonPhaseAngle[i] = instant.moonPhaseAngle;
+    }
+}
+
+void EphemerisBatch::Resize(Positions& positions, std::size_t count)
+{
+    for (std::vector<double>* array : {&positions.sunAzimuth, &positions.sunAltitude, &positions.sunDistance, &positions.moonAzimuth, &positions.moonAltitude, &positions.moonDistance, &positions.moonPhaseAngle})
+        array->resize(count);
+}
+
+// The last group is padded with the last instant
+void EphemerisBatch::ComputeRange(const double* JD, const double* lon, const double* lat, std::size_t begin, std::size_t end, Positions& positions)
+{
+    for (std::size_t first = begin; first < end; first += Lanes::kWidth)
+    {
+        std::size_t width = std::min<std::size_t>(Lanes::kWidth, end - first);
+        Lanes lanesJD, lanesLon, lanesLat;
+        for (std::size_t i = 0; i < Lanes::kWidth; ++i)
+        {
+            std::size_t index = first + std::min(i, width - 1);
+            lanesJD.v[i] = JD[index];
+            lanesLon.v[i] = lon[index];
+            lanesLat.v[i] = lat[index];
+        }
+
+        Instant<Lanes> instant = ComputeInstant(lanesJD, lanesLon, lanesLat);
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            positions.sunAzimuth[first + i] = instant.sunHorizon.x.v[i];
+            positions.sunAltitude[first + i] = instant.sunHorizon.y.v[i];
+            positions.sunDistance[first + i] = instant.sunHorizon.z.v[i];
+            positions.moonAzimuth[first + i] = instant.moonHorizon.x.v[i];
+            positions.moonAltitude[first + i] = instant.moonHorizon.y.v[i];
+            positions.moonDistance[first + i] = instant.moonHorizon.z.v[i];
+            positions.moonPhaseAngle[first + i] = instant.moonPhaseAngle.v[i];
+        }
+    }
+}
+
+// A year at 1 minute steps, cycling through observers spread over the globe
+void EphemerisBatch::RunBenchmark(std::size_t count)
+{
+    std::vector<double> JD(count);
+    std::vector<double> lon(count);
+    std::vector<double> lat(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        JD[i] = 2459862.5 + static_cast<double>(i % 525600) / 1440.0;
+        lon[i] = glm::radians(-180.0 + 7.0 * static_cast<double>(i % 51));
+        lat[i] = glm::radians(-60.0 + 5.0 * static_cast<double>(i % 25));
+    }
+
+    auto measure = [&](const char* name, const auto& compute, Positions& positions)
+    {
+        auto start = std::chrono::steady_clock::now();
+        compute(positions);
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << name << ": " << seconds * 1000.0 << " ms, " << static_cast<double>(count) / seconds / 1e6 << " million positions/s" << std::endl;
+    };
+
+    Positions scalar, batch, batchThreaded;
+    std::cout << "Ephemeris benchmark, " << count << " instants, " << std::max(std::thread::hardware_concurrency(), 1u) << " hardware threads" << std::endl;
+    measure("Scalar", [&](Positions& p) { ComputeScalar(JD.data(), lon.data(), lat.data(), count, p); }, scalar);
+    measure("Batch (1 thread)", [&](Positions& p) { Compute(JD.data(), lon.data(), lat.data(), count, p, 1); }, batch);
+    measure("Batch", [&](Positions& p) { Compute(JD.data(), lon.data(), lat.data(), count, p); }, batchThreaded);
+
+    std::cout << "Max difference to scalar | Sun Az: " << MaxAngleDifference(batchThreaded.sunAzimuth, scalar.sunAzimuth)
+        << " rad, Sun Alt: " << MaxAngleDifference(batchThreaded.sunAltitude, scalar.sunAltitude)
+        << " rad, Moon Az: " << MaxAngleDifference(batchThreaded.moonAzimuth, scalar.moonAzimuth)
+        << " rad, Moon Alt: " << MaxAngleDifference(batchThreaded.moonAltitude, scalar.moonAltitude)
+        << " rad, Moon Distance: " << MaxRelativeDifference(batchThreaded.moonDistance, scalar.moonDistance)
+        << " (relative), Moon Phase: " << MaxAngleDifference(batchThreaded.moonPhaseAngle, scalar.moonPhaseAngle) << " rad" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Horizon coordinates of the Sun and the Moon for many instants and observers at
+// once (e.g. time-lapses or day-long illumination curves of several sites), with
+// the same math as the low precision tier of AstronomicalPositioning (see
+// EphemerisMath.h). The instants
+// are evaluated in groups of EphemerisMath::Lanes, with vectorized sine and
+// cosine, and large batches are split among several threads.
+class EphemerisBatch
+{
+public:
+    // Structure of arrays, in radians and AU
+    struct Positions
+    {
+        std::vector<double> sunAzimuth;
+        std::vector<double> sunAltitude;
+        std::vector<double> sunDistance;
+        std::vector<double> moonAzimuth;
+        std::vector<double> moonAltitude;
+        std::vector<double> moonDistance;
+        std::vector<double> moonPhaseAngle;
+    };
+public:
+    // Julian dates (UT) and observer longitudes and latitudes (radians) of each instant, 0 threads to use all the hardware ones
+    static void Compute(const double* JD, const double* lon, const double* lat, std::size_t count, Positions& positions, unsigned int numThreads = 0);
+    // One instant at a time with the trigonometric functions of the standard library, as AstronomicalPositioning
+    static void ComputeScalar(const double* JD, const double* lon, const double* lat, std::size_t count, Positions& positions);
+    // Throughput of both paths, and their largest difference
+    static void RunBenchmark(std::size_t count);
+private:
+    static void Resize(Positions& positions, std::size_t count);
+    static void ComputeRange(const double* JD, const double* lon, const double* lat, std::size_t begin, std::size_t end, Positions& positions);
+};
\ No newline at end of file
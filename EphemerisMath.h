@@ -0,0 +1,361 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <cstddef>
+
+// Series and coordinate transforms of AstronomicalPositioning (see: Jensen 2001),
+// templated on the real type so that they are shared by its scalar path (double)
+// and by EphemerisBatch (Lanes, several instants at once). The coefficients of the
+// series are tables of terms in integer multiples of a few arguments, whose sines
+// and cosines are obtained by angle-addition recurrences from a single evaluation
+// per argument. Angles in radians and distances in AU.
+namespace EphemerisMath
+{
+    // Fixed-size group of doubles, whose element-wise loops the compiler turns into SIMD instructions
+    struct Lanes
+    {
+        static constexpr int kWidth = 4;
+        double v[kWidth];
+    };
+
+    template <typename Real>
+    struct Vector3
+    {
+        Real x;
+        Real y;
+        Real z;
+    };
+
+#define EPHEMERIS_MATH_LANES_OPERATOR(op) \
+    inline Lanes operator op(const Lanes& a, const Lanes& b) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = a.v[i] op b.v[i]; return r; } \
+    inline Lanes operator op(double a, const Lanes& b) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = a op b.v[i]; return r; } \
+    inline Lanes operator op(const Lanes& a, double b) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = a.v[i] op b; return r; }
+    EPHEMERIS_MATH_LANES_OPERATOR(+)
+    EPHEMERIS_MATH_LANES_OPERATOR(-)
+    EPHEMERIS_MATH_LANES_OPERATOR(*)
+    EPHEMERIS_MATH_LANES_OPERATOR(/)
+#undef EPHEMERIS_MATH_LANES_OPERATOR
+
+    inline Lanes operator-(const Lanes& a) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = -a.v[i]; return r; }
+
+    inline double Sin(double x) { return glm::sin(x); }
+    inline double Cos(double x) { return glm::cos(x); }
+    inline void SinCos(double x, double& s, double& c) { s = glm::sin(x); c = glm::cos(x); }
+    inline double Sqrt(double x) { return glm::sqrt(x); }
+    inline double Atan2(double y, double x) { return glm::atan(y, x); }
+    inline double Asin(double x) { return glm::asin(x); }
+    inline double Acos(double x) { return glm::acos(x); }
+
+    // Branchless, so that it vectorizes: Cody-Waite reduction to [-pi/4, pi/4] (exact for |x| < 2^20*pi/2,
+    // far beyond the arguments of the series) and the minimax polynomials of fdlibm, within 2 ulp of libm
+    inline void SinCos(const Lanes& x, Lanes& s, Lanes& c)
+    {
+        constexpr double kTwoOverPi = 6.36619772367581382433e-01;
+        constexpr double kPiOver2Hi = 1.57079632673412561417e+00; // 33 bits, so that k * kPiOver2Hi is exact
+        constexpr double kPiOver2Mid = 6.07710050630396597660e-11;
+        constexpr double kPiOver2Lo = 2.02226624879595063154e-21;
+        constexpr double kRound = 6755399441055744.0; // 1.5 * 2^52, rounds to the nearest integer when added and subtracted
+        constexpr double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03, S3 = -1.98412698298579493134e-04;
+        constexpr double S4 = 2.75573137070700676789e-06, S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+        constexpr double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03, C3 = 2.48015872894767294178e-05;
+        constexpr double C4 = -2.75573143513906633035e-07, C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+        for (int i = 0; i < Lanes::kWidth; ++i)
+        {
+            double k = (x.v[i] * kTwoOverPi + kRound) - kRound;
+            double r = ((x.v[i] - k * kPiOver2Hi) - k * kPiOver2Mid) - k * kPiOver2Lo;
+            int quadrant = static_cast<int>(k) & 3;
+            double z = r * r;
+            double sr = r + r * z * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+            double cr = 1.0 - 0.5 * z + z * z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+            double sinValue = (quadrant & 1) ? cr : sr;
+            double cosValue = (quadrant & 1) ? sr : cr;
+            s.v[i] = (quadrant & 2) ? -sinValue : sinValue;
+            c.v[i] = ((quadrant + 1) & 2) ? -cosValue : cosValue;
+        }
+    }
+
+    inline Lanes Sin(const Lanes& x) { Lanes s, c; SinCos(x, s, c); return s; }
+    inline Lanes Cos(const Lanes& x) { Lanes s, c; SinCos(x, s, c); return c; }
+    inline Lanes Sqrt(const Lanes& x) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = std::sqrt(x.v[i]); return r; }
+    inline Lanes Atan2(const Lanes& y, const Lanes& x) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = std::atan2(y.v[i], x.v[i]); return r; }
+    inline Lanes Asin(const Lanes& x) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = std::asin(x.v[i]); return r; }
+    inline Lanes Acos(const Lanes& x) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = std::acos(x.v[i]); return r; }
+
+    template <typename Real>
+    Real JulianCenturies(const Real& JD)
+    {
+        return (JD - 2451545.0) / 36525.0;
+    }
+
+    // TT - UT in seconds (see: Espenak and Meeus 2006, polynomial expressions for delta T), JD in Universal Time
+    inline double DeltaT(double JD)
+    {
+        double y = 2000.0 + (JD - 2451545.0) / 365.25;
+        double u = (y - 1820.0) / 100.0;
+        if (y < 1900.0 || y >= 2150.0) return -20.0 + 32.0 * u * u;
+        if (y < 1920.0)
+        {
+            double t = y - 1900.0;
+            return -2.79 + t * (1.494119 + t * (-0.0598939 + t * (0.0061966 - 0.000197 * t)));
+        }
+        if (y < 1941.0)
+        {
+            double t = y - 1920.0;
+            return 21.20 + t * (0.84493 + t * (-0.076100 + 0.0020936 * t));
+        }
+        if (y < 1961.0)
+        {
+            double t = y - 1950.0;
+            return 29.07 + t * (0.407 + t * (-1.0 / 233.0 + t / 2547.0));
+        }
+        if (y < 1986.0)
+        {
+            double t = y - 1975.0;
+            return 45.45 + t * (1.067 + t * (-1.0 / 260.0 - t / 718.0));
+        }
+        if (y < 2005.0)
+        {
+            double t = y - 2000.0;
+            return 63.86 + t * (0.3345 + t * (-0.060374 + t * (0.0017275 + t * (0.000651814 + 0.00002373599 * t))));
+        }
+        if (y < 2050.0)
+        {
+            double t = y - 2000.0;
+            return 62.92 + t * (0.32217 + 0.005589 * t);
+        }
+        return -20.0 + 32.0 * u * u - 0.5628 * (2150.0 - y);
+    }
+
+    inline Lanes DeltaT(const Lanes& JD) { Lanes r; for (int i = 0; i < Lanes::kWidth; ++i) r.v[i] = DeltaT(JD.v[i]); return r; }
+
+    // Sine and cosine of an angle
+    template <typename Real>
+    struct SinCosPair
+    {
+        Real s;
+        Real c;
+    };
+
+    template <typename Real>
+    SinCosPair<Real> AngleSum(const SinCosPair<Real>& a, const SinCosPair<Real>& b)
+    {
+        return {a.s * b.c + a.c * b.s, a.c * b.c - a.s * b.s};
+    }
+
+    // Sines and cosines of the integer multiples -kMaxMultiple*x ... kMaxMultiple*x, from a single evaluation and the angle-addition recurrence
+    template <typename Real, int kMaxMultiple>
+    class AngleMultiples
+    {
+    public:
+        explicit AngleMultiples(const Real& x)
+        {
+            m_multiples[0] = {Real(), Real() + 1.0};
+            SinCos(x, m_multiples[1].s, m_multiples[1].c);
+            for (int k = 2; k <= kMaxMultiple; ++k) m_multiples[k] = AngleSum(m_multiples[k - 1], m_multiples[1]);
+        }
+
+        SinCosPair<Real> Get(int k) const
+        {
+            return k >= 0 ? m_multiples[k] : SinCosPair<Real>{-m_multiples[-k].s, m_multiples[-k].c};
+        }
+    private:
+        SinCosPair<Real> m_multiples[kMaxMultiple + 1];
+    };
+
+    // Periodic term in the lunar fundamental arguments: mean elongation of the Moon (D), mean anomaly of the Sun (M), mean anomaly of the Moon (M') and argument of latitude of the Moon (F)
+    struct LunarTerm
+    {
+        int d;
+        int m;
+        int mp;
+        int f;
+        double coefficient;
+    };
+
+    template <typename Real, int kMaxMultiple>
+    struct LunarArguments
+    {
+        AngleMultiples<Real, kMaxMultiple> d;
+        AngleMultiples<Real, kMaxMultiple> m;
+        AngleMultiples<Real, kMaxMultiple> mp;
+        AngleMultiples<Real, kMaxMultiple> f;
+
+        SinCosPair<Real> Get(int kd, int km, int kmp, int kf) const
+        {
+            return AngleSum(AngleSum(AngleSum(d.Get(kd), m.Get(km)), mp.Get(kmp)), f.Get(kf));
+        }
+    };
+
+    // Adds the terms in order to 'sum', their coefficients multiplying the sine (or the cosine) of their argument
+    template <typename Real, int kMaxMultiple, std::size_t N>
+    Real SumLunarTerms(Real sum, const LunarTerm (&terms)[N], const LunarArguments<Real, kMaxMultiple>& arguments, bool cosine)
+    {
+        for (const LunarTerm& term : terms)
+        {
+            SinCosPair<Real> argument = arguments.Get(term.d, term.m, term.mp, term.f);
+            sum = sum + term.coefficient * (cosine ? argument.c : argument.s);
+        }
+        return sum;
+    }
+
+    // See: Jensen 2001
+    inline constexpr LunarTerm kJensenMoonLongitudeTerms[] =
+    {
+        {0, 0, 1, 0, 0.1098},
+        {2, 0, -1, 0, 0.0222},
+        {2, 0, 0, 0, 0.0115},
+        {0, 0, 2, 0, 0.0037},
+        {0, 1, 0, 0, -0.0032},
+        {0, 0, 0, 2, -0.0020},
+        {2, 0, -2, 0, 0.0010},
+        {2, -1, -1, 0, 0.0010},
+        {2, 0, 1, 0, 0.0009},
+        {2, -1, 0, 0, 0.0008},
+        {0, -1, 1, 0, 0.0007},
+        {1, 0, 0, 0, -0.0006},
+        {0, 1, 1, 0, -0.0005},
+    };
+
+    inline constexpr LunarTerm kJensenMoonLatitudeTerms[] =
+    {
+        {0, 0, 0, 1, 0.0895},
+        {0, 0, 1, 1, 0.0049},
+        {0, 0, 1, -1, 0.0048},
+        {2, 0, 0, -1, 0.0030},
+        {2, 0, -1, 1, 0.0010},
+        {2, 0, -1, -1, 0.0008},
+        {2, 0, 0, 1, 0.0006},
+    };
+
+    inline constexpr LunarTerm kJensenMoonParallaxTerms[] =
+    {
+        {0, 0, 1, 0, 0.000904},
+        {2, 0, -1, 0, 0.000166},
+        {2, 0, 0, 0, 0.000137},
+        {0, 0, 2, 0, 0.000049},
+        {2, 0, 1, 0, 0.000015},
+        {2, -1, 0, 0, 0.000009},
+    };
+
+    template <typename Real>
+    Vector3<Real> SunEclipticCoordinates(const Real& T)
+    {
+        Real M = 6.24 + 628.302 * T;
+        AngleMultiples<Real, 2> multiplesM(M);
+
+        Real lambda = 4.895048 + 628.331951 * T + (0.033417 - 0.000084 * T) * multiplesM.Get(1).s + 0.000351 * multiplesM.Get(2).s;
+        Real beta = Real();
+        Real r = 1.000140 - (0.016708 - 0.000042 * T) * multiplesM.Get(1).c - 0.000141 * multiplesM.Get(2).c; // AU
+
+        return {lambda, beta, r};
+    }
+
+    template <typename Real>
+    Vector3<Real> MoonEclipticCoordinates(const Real& T)
+    {
+        Real lp = 3.8104 + 8399.7091 * T;
+        LunarArguments<Real, 2> arguments =
+        {
+            AngleMultiples<Real, 2>(5.1985 + 7771.3772 * T), // d
+            AngleMultiples<Real, 2>(6.2300 + 628.3019 * T), // m
+            AngleMultiples<Real, 2>(2.3554 + 8328.6911 * T), // mp
+            AngleMultiples<Real, 2>(1.6280 + 8433.4663 * T), // f
+        };
+
+        Real lambda = SumLunarTerms(lp, kJensenMoonLongitudeTerms, arguments, false);
+        Real beta = SumLunarTerms(Real(), kJensenMoonLatitudeTerms, arguments, false);
+        Real pip = SumLunarTerms(Real() + 0.016593, kJensenMoonParallaxTerms, arguments, true);
+        constexpr double au_in_earth_radi = 23455.0; // 1 AU = 23455 earth radi
+        Real r = (1.0 / pip) / au_in_earth_radi; // AU
+
+        return {lambda, beta, r};
+    }
+
+    template <typename Real>
+    Vector3<Real> SphericalToRectangular(const Vector3<Real>& spherical)
+    {
+        Real sinLon, cosLon, sinLat, cosLat;
+        SinCos(spherical.x, sinLon, cosLon);
+        SinCos(spherical.y, sinLat, cosLat);
+        return {cosLat * cosLon * spherical.z, cosLat * sinLon * spherical.z, sinLat * spherical.z};
+    }
+
+    template <typename Real>
+    Vector3<Real> RectangularToSpherical(const Vector3<Real>& rectangular)
+    {
+        Real r = Sqrt(rectangular.x * rectangular.x + rectangular.y * rectangular.y + rectangular.z * rectangular.z);
+        Real lon = Atan2(rectangular.y, rectangular.x);
+        Real lat = Asin(rectangular.z / r);
+        return {lon, lat, r};
+    }
+
+    // Rotations of the vector by the matrices of AstronomicalPositioning::Rx, Ry and Rz
+    template <typename Real>
+    Vector3<Real> RotateX(const Vector3<Real>& v, const Real& sa, const Real& ca)
+    {
+        return {v.x, ca * v.y - sa * v.z, sa * v.y + ca * v.z};
+    }
+
+    template <typename Real>
+    Vector3<Real> RotateY(const Vector3<Real>& v, const Real& sa, const Real& ca)
+    {
+        return {ca * v.x + sa * v.z, v.y, ca * v.z - sa * v.x};
+    }
+
+    template <typename Real>
+    Vector3<Real> RotateZ(const Vector3<Real>& v, const Real& sa, const Real& ca)
+    {
+        return {ca * v.x - sa * v.y, sa * v.x + ca * v.y, v.z};
+    }
+
+    template <typename Real>
+    Vector3<Real> RectangularEclipticToRectangularEquatorial(const Vector3<Real>& rectangularEcliptic, const Real& T)
+    {
+        Real eps = 0.409093 - 0.000227 * T;
+        Real sinEps, cosEps;
+        SinCos(eps, sinEps, cosEps);
+        return RotateX(rectangularEcliptic, sinEps, cosEps);
+    }
+
+    // Precession (Rz * Ry * Rz), rotation of the Earth and latitude of the observer, T in Terrestrial Time and T_ in Universal Time
+    template <typename Real>
+    Vector3<Real> RectangularEquatorialToRectangularHorizon(const Vector3<Real>& rectangularEquatorial, const Real& T, const Real& T_, const Real& lon, const Real& lat)
+    {
+        Real LMST = 4.894961 + 230121.675315 * T_ + lon;
+        Real sinZ, cosZ, sinY, cosY, sinLmst, cosLmst, sinLat, cosLat;
+        SinCos(0.01118 * T, sinZ, cosZ);
+        SinCos(-0.00972 * T, sinY, cosY);
+        SinCos(-LMST, sinLmst, cosLmst);
+        SinCos(lat - glm::half_pi<double>(), sinLat, cosLat);
+
+        Vector3<Real> v = RotateZ(rectangularEquatorial, sinZ, cosZ);
+        v = RotateY(v, sinY, cosY);
+        v = RotateZ(v, sinZ, cosZ);
+        v = RotateZ(v, sinLmst, cosLmst);
+        return RotateY(v, sinLat, cosLat);
+    }
+
+    // Cubic Hermite spline through p1 and p2 (t in [0, 1]), with the tangents estimated from their neighbours, of equally spaced samples
+    template <typename Vector>
+    Vector InterpolateHermite(const Vector& p0, const Vector& p1, const Vector& p2, const Vector& p3, double t)
+    {
+        Vector m1 = 0.5 * (p2 - p0);
+        Vector m2 = 0.5 * (p3 - p1);
+        double t2 = t * t;
+        double t3 = t2 * t;
+        return (2.0 * t3 - 3.0 * t2 + 1.0) * p1 + (t3 - 2.0 * t2 + t) * m1 + (-2.0 * t3 + 3.0 * t2) * p2 + (t3 - t2) * m2;
+    }
+
+    // Angle between the Sun and the Moon as seen from the Earth
+    template <typename Real>
+    Real EarthPhaseAngle(const Vector3<Real>& sunRectangular, const Vector3<Real>& moonRectangular)
+    {
+        Real dot = sunRectangular.x * moonRectangular.x + sunRectangular.y * moonRectangular.y + sunRectangular.z * moonRectangular.z;
+        Real sunLength = Sqrt(sunRectangular.x * sunRectangular.x + sunRectangular.y * sunRectangular.y + sunRectangular.z * sunRectangular.z);
+        Real moonLength = Sqrt(moonRectangular.x * moonRectangular.x + moonRectangular.y * moonRectangular.y + moonRectangular.z * moonRectangular.z);
+        return Acos(dot / (sunLength * moonLength));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "EphemerisTable.h"
+#include "EphemerisMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    std::size_t Slot(long long sample, long long size)
+    {
+        return static_cast<std::size_t>(((sample % size) + size) % size);
+    }
+}
+
+EphemerisTable::EphemerisTable()
+    : m_mutex()
+    , m_condition()
+    , m_quit(false)
+    , m_hasRequest(false)
+    , m_requestSample(0)
+    , m_requestForward(true)
+    , m_requestSource(Ephemeris::Tier::LOW_PRECISION)
+    , m_source(Ephemeris::Tier::LOW_PRECISION)
+    , m_first(0)
+    , m_end(0)
+    , m_sunSamples(kSize)
+    , m_moonSamples(kSize)
+    , m_thread(&EphemerisTable::Run, this)
+{
+}
+
+EphemerisTable::~EphemerisTable()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+void EphemerisTable::Request(double T, bool forward, Ephemeris::Tier tier)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hasRequest = true;
+        m_requestSample = static_cast<long long>(std::floor(T / kStep));
+        m_requestForward = forward;
+        m_requestSource = GetSource(tier);
+    }
+    m_condition.notify_one();
+}
+
+bool EphemerisTable::Sample(double T, Ephemeris::Tier tier, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates)
+{
+    double x = T / kStep;
+    long long sample = static_cast<long long>(std::floor(x));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_source != GetSource(tier) || sample - 1 < m_first || sample + 2 >= m_end) return false;
+
+    double t = x - static_cast<double>(sample);
+    std::size_t s0 = Slot(sample - 1, kSize), s1 = Slot(sample, kSize), s2 = Slot(sample + 1, kSize), s3 = Slot(sample + 2, kSize);
+    sunEclipticCoordinates = EphemerisMath::InterpolateHermite(m_sunSamples[s0], m_sunSamples[s1], m_sunSamples[s2], m_sunSamples[s3], t);
+    moonEclipticCoordinates = EphemerisMath::InterpolateHermite(m_moonSamples[s0], m_moonSamples[s1], m_moonSamples[s2], m_moonSamples[s3], t);
+    return true;
+}
+
+void EphemerisTable::GetCoverage(double T, double& hoursBehind, double& hoursAhead)
+{
+    double x = T / kStep;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    hoursBehind = std::max(x - static_cast<double>(m_first), 0.0) / 60.0;
+    hoursAhead = std::max(static_cast<double>(m_end - 1) - x, 0.0) / 60.0;
+}
+
+// The samples of the tabulated tier are of the truncated series
+Ephemeris::Tier EphemerisTable::GetSource(Ephemeris::Tier tier)
+{
+    return tier == Ephemeris::Tier::LOW_PRECISION ? Ephemeris::Tier::LOW_PRECISION : Ephemeris::Tier::TRUNCATED_SERIES;
+}
+
+// Drops the samples out of the window, then extends the range around the requested sample first (so that it is
+// covered as soon as possible), and then ahead of it before behind it
+bool EphemerisTable::NextChunk(long long& first, long long& end)
+{
+    if (!m_hasRequest) return false;
+
+    long long sample = m_requestSample;
+    long long windowFirst = m_requestForward ? sample + kSamplesAhead - kSize + 1 : sample - kSamplesAhead;
+    long long windowEnd = windowFirst + kSize;
+
+    if (m_requestSource != m_source)
+    {
+        m_source = m_requestSource;
+        m_end = m_first;
+    }
+    m_first = std::max(m_first, windowFirst);
+    m_end = std::min(m_end, windowEnd);
+    if (m_first >= m_end || sample + 2 < m_first - kChunkSize || sample - 1 > m_end + kChunkSize)
+    {
+        m_first = sample - 1;
+        m_end = sample - 1;
+    }
+
+    bool extendForward;
+    if (m_first > sample - 1) extendForward = false;
+    else if (m_end < sample + 3) extendForward = true;
+    else if (m_requestForward) extendForward = m_end < windowEnd;
+    else extendForward = m_first == windowFirst;
+
+    if (extendForward && m_end < windowEnd)
+    {
+        first = m_end;
+        end = std::min(m_end + kChunkSize, windowEnd);
+        return true;
+    }
+    if (!extendForward && m_first > windowFirst)
+    {
+        first = std::max(m_first - kChunkSize, windowFirst);
+        end = m_first;
+        return true;
+    }
+    return false;
+}
+
+void EphemerisTable::Run()
+{
+    std::vector<glm::dvec3> sunSamples(kChunkSize);
+    std::vector<glm::dvec3> moonSamples(kChunkSize);
+    while (true)
+    {
+        long long first, end;
+        Ephemeris::Tier source;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [&]() { return m_quit || NextChunk(first, end); });
+            if (m_quit) break;
+            source = m_source;
+        }
+
+        for (long long sample = first; sample < end; ++sample)
+        {
+            double T = static_cast<double>(sample) * kStep;
+            std::size_t i = static_cast<std::size_t>(sample - first);
+            if (source == Ephemeris::Tier::LOW_PRECISION) Ephemeris::ComputeLowPrecision(T, sunSamples[i], moonSamples[i]);
+            else Ephemeris::ComputeTruncatedSeries(T, sunSamples[i], moonSamples[i]);
+        }
+
+        // Only this thread changes the range and the source, so the chunk is still adjacent to the range
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (long long sample = first; sample < end; ++sample)
+        {
+            std::size_t i = static_cast<std::size_t>(sample - first);
+            m_sunSamples[Slot(sample, kSize)] = sunSamples[i];
+            m_moonSamples[Slot(sample, kSize)] = moonSamples[i];
+        }
+        if (first == m_end) m_end = end;
+        else m_first = first;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Ephemeris.h"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Geocentric ecliptic coordinates of the Sun and the Moon sampled every minute
+// over a 48 h window around the requested time, which a running clock only has to
+// interpolate (cubic Hermite splines) each frame. A worker thread fills the window
+// and follows the requested time incrementally: it only computes the samples that
+// enter the window, most of them (36 h) ahead in the direction time advances, in
+// chunks of an hour published as soon as they are ready. So even fast playback
+// costs a few series evaluations per simulated minute, none of them on the
+// rendering thread. A jump out of the window or a change of source refills it.
+class EphemerisTable
+{
+public:
+    EphemerisTable();
+    ~EphemerisTable();
+    // T in Julian centuries of Terrestrial Time since J2000, forward if time advances
+    void Request(double T, bool forward, Ephemeris::Tier tier);
+    // False if the table does not cover T yet, or its samples are not of the series of the tier
+    bool Sample(double T, Ephemeris::Tier tier, glm::dvec3& sunEclipticCoordinates, glm::dvec3& moonEclipticCoordinates);
+    void GetCoverage(double T, double& hoursBehind, double& hoursAhead);
+private:
+    void Run();
+    bool NextChunk(long long& first, long long& end); // With the lock held, false if the window is complete
+    static Ephemeris::Tier GetSource(Ephemeris::Tier tier);
+private:
+    static constexpr double kStep = 1.0 / (1440.0 * 36525.0); // 1 minute, in Julian centuries
+    static constexpr long long kSize = 2881; // 48 hours
+    static constexpr long long kSamplesAhead = 2160; // 36 hours
+    static constexpr long long kChunkSize = 60;
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_quit;
+    bool m_hasRequest;
+    long long m_requestSample;
+    bool m_requestForward;
+    Ephemeris::Tier m_requestSource;
+    Ephemeris::Tier m_source; // Of the samples in the table
+    long long m_first; // Range of samples in the table, [m_first, m_end), sample n at T = n * kStep
+    long long m_end;
+    std::vector<glm::dvec3> m_sunSamples; // Ring buffers, sample n in slot n mod kSize
+    std::vector<glm::dvec3> m_moonSamples;
+    std::thread m_thread;
+};
\ No newline at end of file
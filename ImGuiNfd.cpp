@@ -10,3 +10,14 @@ std::string ImGuiNfd::Load(const nfdu8filteritem_t* filterList, nfdfiltersize_t
     }
     else return "";
 }
+
+std::string ImGuiNfd::Save(const nfdu8filteritem_t* filterList, nfdfiltersize_t filterCount, const char* defaultName)
+{
+    NFD::UniquePath path;
+    NFD::SaveDialog(path, filterList, filterCount, nullptr, defaultName);
+    if (path)
+    {
+        return path.get();
+    }
+    else return "";
+}
\ No newline at end of file
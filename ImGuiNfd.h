@@ -8,4 +8,5 @@
 namespace ImGuiNfd
 {
     std::string Load(const nfdu8filteritem_t* filterList = nullptr, nfdfiltersize_t filterCount = 0);
+    std::string Save(const nfdu8filteritem_t* filterList = nullptr, nfdfiltersize_t filterCount = 0, const char* defaultName = nullptr);
 }
\ No newline at end of file
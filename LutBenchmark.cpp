@@ -0,0 +1,317 @@
+#include "LutBenchmark.h"
+
+#include "ShaderStage.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+
+using namespace atmosphere;
+
+namespace
+{
+    constexpr double kLengthUnitInMeters = 1000.0;
+
+    // Equirectangular sky images compared between tiers
+    constexpr int kImageWidth = 512;
+    constexpr int kImageHeight = 256;
+    constexpr double kSunElevations[] = {-12.0, -6.0, -2.0, 0.0, 2.0, 6.0, 15.0, 30.0, 60.0, 90.0}; // deg
+    constexpr double kCameraAltitude = 0.1; // km
+
+    // Frames rendered to measure the sky shading time
+    constexpr int kShadingWidth = 1920;
+    constexpr int kShadingHeight = 1080;
+    constexpr int kShadingFrames = 64;
+
+    struct Configuration
+    {
+        const char* name;
+        TextureResolutionTier tier;
+        unsigned int adaptiveQuadraturePasses;
+        bool combineScatteringTextures;
+        ScatteringTextureFormat scatteringTextureFormat;
+    };
+
+    // The reference tier goes first, its images are the ground truth of the other ones. The default
+    // tier goes second, its images are the baseline of the other configurations of this tier. Each
+    // configuration is precomputed with the fragment shader backend, and then with the compute shader
+    // one if it is supported (their images being compared with those of the fragment shader backend).
+    constexpr Configuration kConfigurations[] = {
+        {"Reference", REFERENCE_RESOLUTION, 0, false, FULL_PRECISION},
+        {"Default", DEFAULT_RESOLUTION, 0, false, FULL_PRECISION},
+        {"Adaptive", DEFAULT_RESOLUTION, ALL_ADAPTIVE_QUADRATURES, false, FULL_PRECISION},
+        {"Combined", DEFAULT_RESOLUTION, 0, true, FULL_PRECISION},
+        {"Half", DEFAULT_RESOLUTION, 0, false, HALF_PRECISION},
+        {"RGB9E5", DEFAULT_RESOLUTION, 0, false, SHARED_EXPONENT},
+        {"Low", LOW_RESOLUTION, 0, false, FULL_PRECISION},
+    };
+
+    // RMS error of the RGB values of 'images' with respect to 'referenceImages', absolute and relative to the RMS reference value
+    void ComputeRmsErrors(const std::vector<float>& images, const std::vector<float>& referenceImages, double& rmsError, double& relativeRmsError)
+    {
+        double sumSquaredErrors = 0.0;
+        double sumSquaredReferences = 0.0;
+        std::size_t numValues = 0;
+        for (std::size_t i = 0; i < images.size(); ++i)
+        {
+            if (i % 4 == 3) continue; // Alpha
+            double error = static_cast<double>(images[i]) - referenceImages[i];
+            sumSquaredErrors += error * error;
+            sumSquaredReferences += static_cast<double>(referenceImages[i]) * referenceImages[i];
+            ++numValues;
+        }
+        rmsError = std::sqrt(sumSquaredErrors / numValues);
+        relativeRmsError = sumSquaredReferences > 0.0 ? std::sqrt(sumSquaredErrors / sumSquaredReferences) : 0.0;
+    }
+
+    GLuint NewFloatTexture(int width, int height)
+    {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        return texture;
+    }
+
+    GLuint NewFramebuffer(GLuint texture)
+    {
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) std::cerr << "[LutBenchmark] E: Framebuffer is not complete." << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return framebuffer;
+    }
+}
+
+LutBenchmark::LutBenchmark(const ModelParameters& parameters)
+    : m_parameters(parameters)
+    , m_fullScreenQuadVao(0)
+    , m_fullScreenQuadVbo(0)
+    , m_shadingFramebuffer(0)
+    , m_shadingTexture(NewFloatTexture(kShadingWidth, kShadingHeight))
+    , m_imageFramebuffer(0)
+    , m_imageTexture(NewFloatTexture(kImageWidth, kImageHeight))
+    , m_timerQuery(0)
+{
+    m_skyVertexShader.Create(ShaderType::VERTEX);
+    m_skyVertexShader.Compile("./resources/shaders/postprocess.vert", "./resources/shaders/");
+    m_skyFragmentShader.Create(ShaderType::FRAGMENT);
+    m_skyFragmentShader.Compile("./resources/shaders/benchmark.frag", "./resources/shaders/");
+
+    m_shadingFramebuffer = NewFramebuffer(m_shadingTexture);
+    m_imageFramebuffer = NewFramebuffer(m_imageTexture);
+    glGenQueries(1, &m_timerQuery);
+
+    glGenVertexArrays(1, &m_fullScreenQuadVao);
+    glBindVertexArray(m_fullScreenQuadVao);
+
+    float vertices[] = {
+        -1.0, -1.0, 0.0,
+        +1.0, -1.0, 0.0,
+        -1.0, +1.0, 0.0,
+        +1.0, +1.0, 0.0
+    };
+
+    glGenBuffers(1, &m_fullScreenQuadVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_fullScreenQuadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+LutBenchmark::~LutBenchmark()
+{
+    glDeleteQueries(1, &m_timerQuery);
+    glDeleteFramebuffers(1, &m_imageFramebuffer);
+    glDeleteFramebuffers(1, &m_shadingFramebuffer);
+    glDeleteTextures(1, &m_imageTexture);
+    glDeleteTextures(1, &m_shadingTexture);
+    glDeleteBuffers(1, &m_fullScreenQuadVbo);
+    glDeleteVertexArrays(1, &m_fullScreenQuadVao);
+}
+
+// Same as the defaults of PhysicalSky, with the Sun and the Moon at their mean distances
+ModelParameters LutBenchmark::GetDefaultModelParameters()
+{
+    ModelParameters parameters;
+
+    parameters.sunIrradiance = glm::dvec3(1.0, 1.0, 1.0) * (1905.0 / 3.0);
+    parameters.sunAngularRadius = glm::atan(0.00465047 * 5.0);
+    parameters.moonIrradiance = glm::dvec3(0.0, 0.0, 0.0); // Unused by the solar model
+    parameters.moonAngularRadius = glm::atan(0.00001163 * 5.0 / 0.00257);
+
+    parameters.bottomRadius = 6360.0 * 1000.0;
+    parameters.topRadius = parameters.bottomRadius + 100.0 * 1000.0;
+
+    DensityProfileLayer rayleigh_layer(0.0, 1.0, -1.0 / (8.0 * 1000.0), 0.0, 0.0);
+    parameters.rayleighDensity = { rayleigh_layer };
+    parameters.rayleighScattering = glm::dvec3(0.175287, 0.409607, 1.0) * (0.033100 / 1000.0);
+
+    DensityProfileLayer mie_layer(0.0, 1.0, -1.0 / (1.2 * 1000.0), 0.0, 0.0);
+    parameters.mieDensity = { mie_layer };
+    parameters.mieScattering = glm::dvec3(1.0, 1.0, 1.0) * (0.003996 / 1000.0);
+    parameters.mieExtinction = parameters.mieScattering + glm::dvec3(1.0, 1.0, 1.0) * (0.000444 / 1000.0);
+    parameters.miePhaseFunctionG = 0.8;
+
+    parameters.absorptionDensity.push_back(DensityProfileLayer(25000.0, 0.0, 0.0, 1.0 / 15000.0, -2.0 / 3.0));
+    parameters.absorptionDensity.push_back(DensityProfileLayer(0.0, 0.0, 0.0, -1.0 / 15000.0, 8.0 / 3.0));
+    parameters.absorptionExtinction = (glm::dvec3(0.345561, 1.0, 0.045189) * 0.001881) / 1000.0;
+
+    parameters.groundAlbedo = glm::dvec3(0.3, 0.3, 0.3);
+    parameters.maxSunZenithAngle = 120.0 / 180.0 * glm::pi<double>();
+    parameters.lengthUnitInMeters = kLengthUnitInMeters;
+    parameters.combineScatteringTextures = false;
+    parameters.scatteringTextureFormat = FULL_PRECISION;
+
+    parameters.numScatteringOrders = 4;
+    parameters.convergenceTolerance = 0.0;
+    parameters.adaptiveQuadraturePasses = 0;
+    parameters.sharedPrecomputation = true;
+    parameters.precomputationBackend = FRAGMENT_SHADER;
+
+    return parameters;
+}
+
+std::vector<LutBenchmark::TierResult> LutBenchmark::Run()
+{
+    std::vector<TierResult> results;
+    std::vector<float> referenceImages;
+    std::vector<float> defaultImages;
+
+    std::vector<PrecomputationBackend> backends = {FRAGMENT_SHADER};
+    if (Model::IsComputeShaderBackendSupported()) backends.push_back(COMPUTE_SHADER);
+
+    for (const Configuration& configuration : kConfigurations)
+    {
+        for (PrecomputationBackend backend : backends)
+        {
+            ModelParameters parameters = m_parameters;
+            parameters.textureResolution = GetTextureResolution(configuration.tier);
+            parameters.adaptiveQuadraturePasses = configuration.adaptiveQuadraturePasses;
+            parameters.combineScatteringTextures = configuration.combineScatteringTextures;
+            parameters.scatteringTextureFormat = configuration.scatteringTextureFormat;
+            parameters.precomputationBackend = backend;
+            std::unique_ptr<Model> model = AtmospherePrecomputer::NewModel(parameters, SOURCE_SUN);
+
+            TierResult result = {};
+            result.name = configuration.name;
+
+            auto start = std::chrono::steady_clock::now();
+            model->Init(parameters.numScatteringOrders, Model::ProgressCallback(), parameters.precomputationBackend, parameters.convergenceTolerance, parameters.adaptiveQuadraturePasses);
+            glFinish();
+            result.wallClockMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            result.precomputationMilliseconds = model->precomputation_time() * 1000.0;
+            result.backend = model->precomputation_backend() == COMPUTE_SHADER ? "Compute" : "Fragment";
+            result.memoryBytes = model->GetPrecomputedTexturesMemorySize();
+
+            BuildShader(*model);
+            result.skyShadingMilliseconds = MeasureSkyShading(*model);
+
+            std::vector<float> images = RenderSkyImages(*model);
+            if (referenceImages.empty()) referenceImages = images;
+            else if (defaultImages.empty() && configuration.tier == DEFAULT_RESOLUTION) defaultImages = images;
+            ComputeRmsErrors(images, referenceImages, result.rmsError, result.relativeRmsError);
+
+            result.relativeRmsErrorToDefault = -1.0;
+            if (configuration.tier == DEFAULT_RESOLUTION)
+            {
+                double rmsErrorToDefault;
+                ComputeRmsErrors(images, defaultImages, rmsErrorToDefault, result.relativeRmsErrorToDefault);
+            }
+
+            if (glGetError() != GL_NO_ERROR) std::cerr << "[LutBenchmark] E: Benchmarking " << result.name << " tier (" << result.backend << ")." << std::endl;
+            results.push_back(result);
+        }
+    }
+
+    return results;
+}
+
+void LutBenchmark::Print(const std::vector<TierResult>& results)
+{
+    std::printf("%-10s %-9s %16s %16s %12s %14s %12s %12s %18s\n", "Tier", "Backend", "Precompute (ms)", "Wall clock (ms)", "Memory (MB)", "Shading (ms)", "RMS error", "Rel. RMS", "Rel. RMS (Default)");
+    for (const TierResult& result : results)
+    {
+        std::printf("%-10s %-9s %16.1f %16.1f %12.1f %14.3f %12.4e %12.4e", result.name, result.backend,
+            result.precomputationMilliseconds, result.wallClockMilliseconds, result.memoryBytes / (1024.0 * 1024.0),
+            result.skyShadingMilliseconds, result.rmsError, result.relativeRmsError);
+        if (result.relativeRmsErrorToDefault >= 0.0) std::printf(" %18.4e\n", result.relativeRmsErrorToDefault);
+        else std::printf(" %18s\n", "-");
+    }
+}
+
+// The atmosphere shader is the only stage that changes between models, Create deletes the program of the previous one
+void LutBenchmark::BuildShader(const Model& model)
+{
+    m_skyShader.Create();
+    m_skyShader.AttachShader(m_skyVertexShader.m_id);
+    m_skyShader.AttachShader(m_skyFragmentShader.m_id);
+    m_skyShader.AttachShader(model.shader());
+    m_skyShader.Build();
+}
+
+double LutBenchmark::MeasureSkyShading(const Model& model)
+{
+    // Warm up, so that shader compilation and texture uploads are not measured
+    RenderSky(model, m_shadingFramebuffer, kShadingWidth, kShadingHeight, 30.0);
+    glFinish();
+
+    double totalMilliseconds = 0.0;
+    for (int i = 0; i < kShadingFrames; ++i)
+    {
+        double sunElevation = -12.0 + 102.0 * i / (kShadingFrames - 1);
+        glBeginQuery(GL_TIME_ELAPSED, m_timerQuery);
+        RenderSky(model, m_shadingFramebuffer, kShadingWidth, kShadingHeight, sunElevation);
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 elapsedNanoseconds = 0;
+        glGetQueryObjectui64v(m_timerQuery, GL_QUERY_RESULT, &elapsedNanoseconds);
+        totalMilliseconds += elapsedNanoseconds * 1e-6;
+    }
+    return totalMilliseconds / kShadingFrames;
+}
+
+std::vector<float> LutBenchmark::RenderSkyImages(const Model& model)
+{
+    constexpr std::size_t kImageSize = 4 * kImageWidth * kImageHeight;
+    std::vector<float> images(kImageSize * std::size(kSunElevations));
+    for (std::size_t i = 0; i < std::size(kSunElevations); ++i)
+    {
+        RenderSky(model, m_imageFramebuffer, kImageWidth, kImageHeight, kSunElevations[i]);
+        glBindTexture(GL_TEXTURE_2D, m_imageTexture);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, images.data() + i * kImageSize);
+    }
+    return images;
+}
+
+void LutBenchmark::RenderSky(const Model& model, GLuint framebuffer, int width, int height, double sunElevation)
+{
+    double elevation = glm::radians(sunElevation);
+    glm::vec3 sunDirection = glm::vec3(std::cos(elevation), 0.0, std::sin(elevation));
+    glm::vec3 cameraPosition = glm::vec3(0.0, 0.0, (m_parameters.bottomRadius / kLengthUnitInMeters) + kCameraAltitude);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    m_skyShader.Use();
+    model.SetProgramUniforms(m_skyShader.m_id, 0, 1, 2, 3);
+    // The lunar samplers are unused, but must not share the texture units of the solar ones
+    m_skyShader.SetInt("moon_transmittance_texture", 4);
+    m_skyShader.SetInt("moon_scattering_texture", 5);
+    m_skyShader.SetInt("moon_irradiance_texture", 6);
+    m_skyShader.SetInt("moon_single_mie_scattering_texture", 7);
+    m_skyShader.SetVec3("e_CameraPos", cameraPosition);
+    m_skyShader.SetVec3("e_SunDir", sunDirection);
+    glBindVertexArray(m_fullScreenQuadVao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
\ No newline at end of file
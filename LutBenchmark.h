@@ -0,0 +1,59 @@
+#pragma once
+
+#include "AtmospherePrecomputer.h"
+#include "ShaderProgram.h"
+#include "ShaderStage.h"
+
+#include <glad/glad.h>
+
+#include <atmosphere/model.h>
+
+#include <vector>
+
+// Compares the texture resolution tiers of the atmosphere model, and the default
+// tier precomputed with adaptive quadratures, with combined scattering textures
+// or with reduced precision scattering textures: precomputation time, GPU
+// memory, per-frame sky shading time and RMS error of the sky radiance with
+// respect to the reference tier (over the whole sphere of view directions, for
+// several sun elevations), and with respect to the default tier for its other
+// configurations. Each configuration is precomputed with both backends, if the
+// compute shader one is supported. Must be run with a current OpenGL context.
+class LutBenchmark
+{
+public:
+    struct TierResult
+    {
+        const char* name;
+        const char* backend; // Of the precomputation, as actually used by the model
+        double precomputationMilliseconds; // GPU time, as measured by the model
+        double wallClockMilliseconds;
+        std::size_t memoryBytes;
+        double skyShadingMilliseconds; // GPU time of a full HD frame
+        double rmsError; // W*m^-2*sr^-1
+        double relativeRmsError; // RMS error divided by the RMS reference radiance
+        double relativeRmsErrorToDefault; // Same, with respect to the default tier, for its other configurations (negative otherwise)
+    };
+public:
+    LutBenchmark(const ModelParameters& parameters);
+    ~LutBenchmark();
+    std::vector<TierResult> Run();
+    static ModelParameters GetDefaultModelParameters();
+    static void Print(const std::vector<TierResult>& results);
+private:
+    void BuildShader(const atmosphere::Model& model);
+    double MeasureSkyShading(const atmosphere::Model& model);
+    std::vector<float> RenderSkyImages(const atmosphere::Model& model);
+    void RenderSky(const atmosphere::Model& model, GLuint framebuffer, int width, int height, double sunElevation);
+private:
+    ModelParameters m_parameters;
+    ShaderStage m_skyVertexShader;
+    ShaderStage m_skyFragmentShader;
+    ShaderProgram m_skyShader;
+    GLuint m_fullScreenQuadVao;
+    GLuint m_fullScreenQuadVbo;
+    GLuint m_shadingFramebuffer;
+    GLuint m_shadingTexture;
+    GLuint m_imageFramebuffer;
+    GLuint m_imageTexture;
+    GLuint m_timerQuery;
+};
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "LutCache.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // Bump when the layout of the file changes
+    constexpr std::uint32_t kFormatVersion = 2;
+    constexpr char kMagic[4] = {'L', 'U', 'T', 'C'};
+
+    struct FileHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t key;
+        std::uint64_t numFloats;
+        std::uint32_t numPrecomputedScatteringOrders;
+        std::uint32_t padding;
+    };
+
+    // Read-only memory mapping of a whole file
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::string& path);
+        ~MappedFile();
+        const void* GetData() const { return m_data; }
+        std::size_t GetSize() const { return m_size; }
+    private:
+        const void* m_data;
+        std::size_t m_size;
+#ifdef _WIN32
+        HANDLE m_file;
+        HANDLE m_mapping;
+#endif
+    };
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path)
+        : m_data(nullptr)
+        , m_size(0)
+        , m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+    {
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return;
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) return;
+
+        m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_data) m_size = static_cast<std::size_t>(size.QuadPart);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    }
+#else
+    MappedFile::MappedFile(const std::string& path)
+        : m_data(nullptr)
+        , m_size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat status;
+        if (fstat(fd, &status) == 0 && status.st_size > 0)
+        {
+            void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                m_data = data;
+                m_size = static_cast<std::size_t>(status.st_size);
+            }
+        }
+        close(fd); // The mapping stays valid after closing the descriptor
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_data) munmap(const_cast<void*>(m_data), m_size);
+    }
+#endif
+}
+
+LutCache::LutCache(const std::string& directory)
+    : m_directory(directory)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+std::string LutCache::GetPath(std::uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.lut", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+bool LutCache::Load(atmosphere::Model& model, unsigned int numScatteringOrders, double convergenceTolerance, unsigned int adaptiveQuadraturePasses)
+{
+    if (m_directory.empty()) return false;
+
+    std::uint64_t key = model.GetPrecomputedTexturesKey(numScatteringOrders, convergenceTolerance, adaptiveQuadraturePasses);
+    std::uint64_t numFloats = model.GetPrecomputedTexturesSize();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MappedFile file = MappedFile(GetPath(key));
+    const FileHeader* header = static_cast<const FileHeader*>(file.GetData());
+    bool valid = header
+        && file.GetSize() == sizeof(FileHeader) + numFloats * sizeof(float)
+        && std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+        && header->version == kFormatVersion
+        && header->key == key
+        && header->numFloats == numFloats;
+
+    if (!valid)
+    {
+        ++m_misses;
+        return false;
+    }
+
+    model.SetPrecomputedTextures(reinterpret_cast<const float*>(header + 1), header->numPrecomputedScatteringOrders);
+    ++m_hits;
+    return true;
+}
+
+void LutCache::Store(const atmosphere::Model& model, unsigned int numScatteringOrders, double convergenceTolerance, unsigned int adaptiveQuadraturePasses)
+{
+    if (m_directory.empty()) return;
+
+    std::vector<float> data(model.GetPrecomputedTexturesSize());
+    model.GetPrecomputedTextures(data.data());
+    Store(model.GetPrecomputedTexturesKey(numScatteringOrders, convergenceTolerance, adaptiveQuadraturePasses), data, model.num_precomputed_scattering_orders());
+}
+
+void LutCache::Store(std::uint64_t key, const std::vector<float>& data, unsigned int numPrecomputedScatteringOrders)
+{
+    if (m_directory.empty()) return;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error)
+    {
+        std::cerr << "[LutCache] E: Could not create directory " << m_directory << "." << std::endl;
+        return;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.key = key;
+    header.numFloats = data.size();
+    header.numPrecomputedScatteringOrders = numPrecomputedScatteringOrders;
+    header.padding = 0;
+
+    // Write to a temporary file first so that a partially written file is never picked up
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string path = GetPath(header.key);
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+        if (!file)
+        {
+            std::cerr << "[LutCache] E: Could not write " << temporaryPath << "." << std::endl;
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) std::cerr << "[LutCache] E: Could not rename " << temporaryPath << "." << std::endl;
+}
+
+void LutCache::Clear()
+{
+    if (m_directory.empty()) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, error))
+    {
+        if (entry.path().extension() == ".lut") std::filesystem::remove(entry.path(), error);
+    }
+    m_hits = 0;
+    m_misses = 0;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atmosphere/model.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Persistent cache of the textures precomputed by atmosphere::Model, stored as
+// one binary file per model key that is memory-mapped and uploaded on a hit.
+// Load and Store may be called from a precomputation thread while Clear is
+// called from the render thread, so the files are only accessed with a lock
+// held and the counters are atomic. An empty directory disables the cache.
+class LutCache
+{
+public:
+    LutCache(const std::string& directory);
+    ~LutCache() = default;
+    bool Load(atmosphere::Model& model, unsigned int numScatteringOrders, double convergenceTolerance, unsigned int adaptiveQuadraturePasses);
+    void Store(const atmosphere::Model& model, unsigned int numScatteringOrders, double convergenceTolerance, unsigned int adaptiveQuadraturePasses);
+    // Textures precomputed without a model, in the layout of Model::GetPrecomputedTextures, with the key of the model that will load them
+    void Store(std::uint64_t key, const std::vector<float>& data, unsigned int numPrecomputedScatteringOrders);
+    void Clear();
+    int GetHits() const { return m_hits; }
+    int GetMisses() const { return m_misses; }
+private:
+    std::string GetPath(std::uint64_t key) const;
+private:
+    std::string m_directory;
+    std::mutex m_mutex; // Of the files in the directory
+    std::atomic<int> m_hits;
+    std::atomic<int> m_misses;
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Mesh.h"
 #include "ImGuiNfd.h"
+#include "Profiler.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
@@ -157,6 +158,7 @@ void Mesh::Render()
 {
     glBindVertexArray(m_vao);
     glDrawElements(GL_TRIANGLES, m_numElements, GL_UNSIGNED_INT, 0);
+    Profiler::CountGlCalls(2);
 }
 
 Mesh::~Mesh()
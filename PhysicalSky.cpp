@@ -4,18 +4,61 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cstdio>
 #include <iostream>
+#include <vector>
 
 namespace {
     constexpr double kLengthUnitInMeters = 1000.0;
+    constexpr int kNumScatteringOrders = 4;
+    constexpr GLuint kFrameUniformsBinding = 0;
+
+    // The precomputed textures of each model stay bound to 4 consecutive units
+    // (transmittance, scattering, irradiance, single Mie scattering), above
+    // the ones used by the rest of the application
+    constexpr GLuint kSolarTextureUnit = 16;
+    constexpr GLuint kLunarTextureUnit = 20;
+
+    // Small enough for the atmosphere shading cost to be nearly independent of the output resolution
+    constexpr int kSkyViewLutWidth = 256;
+    constexpr int kSkyViewLutHeight = 128;
+    constexpr GLuint kSkyViewLutTextureUnit = 24;
+
+    // Full precision for the same reason as the sky-view LUT, at the cost of some sharpness of the stars
+    constexpr int kSkyCubemapSize = 512;
+    constexpr GLuint kSkyCubemapTextureUnit = 25;
+    constexpr float kSkyCubemapPositionTolerance = 0.01f; // km, the sky does not change visibly when orbiting the camera
+
+    // Columns: directions of the s and t texture coordinates and of the center of each face (OpenGL cubemap convention)
+    const glm::mat3 kWorldFromCubemapFace[6] =
+    {
+        glm::mat3(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f)), // +X
+        glm::mat3(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f)), // -X
+        glm::mat3(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f)), // +Y
+        glm::mat3(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)), // -Y
+        glm::mat3(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)), // +Z
+        glm::mat3(glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)), // -Z
+    };
+
+    // Unit vector of horizon coordinates (azimuth, altitude, distance) in the horizon coordinate system
+    glm::dvec3 HorizonDirection(const glm::dvec3& horizonCoordinates)
+    {
+        double cosAltitude = glm::cos(horizonCoordinates.y);
+        return glm::dvec3(cosAltitude * glm::cos(horizonCoordinates.x), cosAltitude * glm::sin(horizonCoordinates.x), glm::sin(horizonCoordinates.y));
+    }
+
+    // GL calls issued by the atmosphere::Model methods, for Profiler::CountGlCalls (there is no single Mie scattering texture with combined scattering textures)
+    constexpr unsigned int kSourceUniformsGlCalls = 6; // 3 glGetUniformLocation and 3 glUniform
+    unsigned int BindTexturesGlCalls(const atmosphere::Model& model) { return model.combine_scattering_textures() ? 6 : 8; }
+    unsigned int ProgramSamplersGlCalls(const atmosphere::Model& model) { return (model.combine_scattering_textures() ? 6 : 8) + kSourceUniformsGlCalls; }
 }  // anonymous namespace
 
 using namespace atmosphere;
 
-PhysicalSky::PhysicalSky()
-    : m_dPlanetRadius(6360.0f) // km
-    , m_dAtmosphereHeight(100.0f) // km
-    , m_dGroundAlbedo(0.300000f, 0.300000f, 0.300000f) // unitless
+PhysicalSky::PhysicalSky(GLFWwindow* sharedContextWindow, const std::string& lutCacheDirectory)
+    : m_dPlanetRadius(kDefaultModelSettings.planetRadius)
+    , m_dAtmosphereHeight(kDefaultModelSettings.atmosphereHeight)
+    , m_dGroundAlbedo(kDefaultModelSettings.groundAlbedo)
 
     , m_dSunSizeMultiplier(5.0f) // unitless
     , m_dSunIrradiance(1905.000000f) // W*m^-2
@@ -28,25 +71,62 @@ PhysicalSky::PhysicalSky()
 
     , m_dSkyStarsMapMultiplier(-1.0f)
     , m_dSkyMilkywayMapMultiplier(-1.0f)
+    , m_dSkyViewLutEnable(false)
+    , m_skyViewLutFramebuffer(GL_NONE)
+    , m_skyViewLutTexture(GL_NONE)
+    , m_skyViewLutComparisonRequested(false)
+    , m_skyViewLutError()
+    , m_dSkyCubemapEnable(false)
+    , m_dSkyCubemapFacesPerFrame(1)
+    , m_skyCubemapFramebuffer(GL_NONE)
+    , m_skyCubemapTexture(GL_NONE)
+    , m_skyCubemapValid(false)
+    , m_skyCubemapKey()
+    , m_skyCubemapStaleFaces(0)
+    , m_skyCubemapNextFace(0)
+    , m_skyCubemapHits(0)
+    , m_skyCubemapPartialUpdates(0)
+    , m_skyCubemapFullUpdates(0)
+    , m_dSceneFirstEnable(true)
+    , m_atmosphereSourcesValid(false)
+    , m_sunSourceIrradiance(0.0)
+    , m_sunSourceAngularRadius(0.0)
+    , m_moonSourceIrradiance(0.0)
+    , m_moonSourceAngularRadius(0.0)
 
     , m_dArtificialLightEnable(false)
     , m_dArtificialLightPos(0.0f, 5.0f, 0.0f)
     , m_dArtificialLightRadiantIntensity(1.0f) // W*sr^-1
 
-    , m_dRayleighScatteringScale(0.033100f) // km^-1
-    , m_dRayleighScatteringCoefficient(0.175287f, 0.409607f, 1.000000f) // unitless
-    , m_dRayleighExponentialDistribution(8.000000f) // km
-
-    , m_dMieScatteringScale(0.003996f) // km^-1
-    , m_dMieScatteringCoefficient(1.000000f, 1.000000f, 1.000000f) // unitless
-    , m_dMieAbsorptionScale(0.000444f) // km^-1
-    , m_dMieAbsorptionCoefficient(1.000000f, 1.000000f, 1.000000f) // unitless
-    , m_dMiePhaseFunctionG(0.800000f) // unitless
-    , m_dMieExponentialDistribution(1.200000f) // km
-
-    , m_dOzoneAbsorptionScale(0.001881f) // km^-1
-    , m_dOzoneAbsorptionCoefficient(0.345561f, 1.000000f, 0.045189f) // unitless
-
+    , m_dRayleighScatteringScale(kDefaultModelSettings.rayleighScatteringScale)
+    , m_dRayleighScatteringCoefficient(kDefaultModelSettings.rayleighScatteringCoefficient)
+    , m_dRayleighExponentialDistribution(kDefaultModelSettings.rayleighExponentialDistribution)
+
+    , m_dMieScatteringScale(kDefaultModelSettings.mieScatteringScale)
+    , m_dMieScatteringCoefficient(kDefaultModelSettings.mieScatteringCoefficient)
+    , m_dMieAbsorptionScale(kDefaultModelSettings.mieAbsorptionScale)
+    , m_dMieAbsorptionCoefficient(kDefaultModelSettings.mieAbsorptionCoefficient)
+    , m_dMiePhaseFunctionG(kDefaultModelSettings.miePhaseFunctionG)
+    , m_dMieExponentialDistribution(kDefaultModelSettings.mieExponentialDistribution)
+
+    , m_dOzoneAbsorptionScale(kDefaultModelSettings.ozoneAbsorptionScale)
+    , m_dOzoneAbsorptionCoefficient(kDefaultModelSettings.ozoneAbsorptionCoefficient)
+
+    , m_dSharedPrecomputationEnable(kDefaultModelSettings.sharedPrecomputation)
+    , m_dComputeShaderPrecomputationEnable(kDefaultModelSettings.computeShaderPrecomputation)
+    , m_dTextureResolutionTier(kDefaultModelSettings.textureResolutionTier)
+    , m_dCombinedScatteringTexturesEnable(kDefaultModelSettings.combinedScatteringTextures)
+    , m_dScatteringTextureFormat(kDefaultModelSettings.scatteringTextureFormat)
+    , m_dNumScatteringOrders(kDefaultModelSettings.numScatteringOrders)
+    , m_dAdaptiveScatteringOrdersEnable(kDefaultModelSettings.adaptiveScatteringOrders)
+    , m_dScatteringOrdersTolerance(kDefaultModelSettings.scatteringOrdersTolerance)
+    , m_dAdaptiveQuadraturePasses(kDefaultModelSettings.adaptiveQuadraturePasses)
+    , m_dAutoRecomputeEnable(true)
+
+    , m_atmosphereShaderHash(0)
+    , m_frameUniformBuffer(GL_NONE)
+    , m_lutCache(lutCacheDirectory)
+    , m_precomputer(sharedContextWindow ? std::make_unique<AtmospherePrecomputer>(sharedContextWindow, m_lutCache) : nullptr)
     , m_notAppliedChanges(false)
     , m_mesh("./resources/models/Human.glb") // How to change this
     , m_bulbMesh("./resources/models/Sphere.glb")
@@ -56,9 +136,20 @@ PhysicalSky::PhysicalSky()
     Init();
 }
 
+PhysicalSky::~PhysicalSky()
+{
+    glDeleteBuffers(1, &m_frameUniformBuffer);
+    glDeleteFramebuffers(1, &m_skyViewLutFramebuffer);
+    glDeleteTextures(1, &m_skyViewLutTexture);
+    glDeleteFramebuffers(1, &m_skyCubemapFramebuffer);
+    glDeleteTextures(1, &m_skyCubemapTexture);
+}
+
 void PhysicalSky::Init()
 {
+    Model::LoadComputeShaderFunctions(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
     ResetDefaults();
+    InitShaders();
     InitModel();
     InitResources();
 }
@@ -69,11 +160,6 @@ void PhysicalSky::MakeDefaultParametersNew()
     m_nAtmosphereHeight = m_dAtmosphereHeight;
     m_nGroundAlbedo = m_dGroundAlbedo;
 
-    m_nSunSizeMultiplier = m_dSunSizeMultiplier;
-    m_nSunIrradiance = m_dSunIrradiance;
-
-    m_nMoonSizeMultiplier = m_dMoonSizeMultiplier;
-
     m_nRayleighScatteringScale = m_dRayleighScatteringScale;
     m_nRayleighScatteringCoefficient = m_dRayleighScatteringCoefficient;
     m_nRayleighExponentialDistribution = m_dRayleighExponentialDistribution;
@@ -87,6 +173,16 @@ void PhysicalSky::MakeDefaultParametersNew()
 
     m_nOzoneAbsorptionScale = m_dOzoneAbsorptionScale;
     m_nOzoneAbsorptionCoefficient = m_dOzoneAbsorptionCoefficient;
+
+    m_nSharedPrecomputationEnable = m_dSharedPrecomputationEnable;
+    m_nComputeShaderPrecomputationEnable = m_dComputeShaderPrecomputationEnable;
+    m_nTextureResolutionTier = m_dTextureResolutionTier;
+    m_nCombinedScatteringTexturesEnable = m_dCombinedScatteringTexturesEnable;
+    m_nScatteringTextureFormat = m_dScatteringTextureFormat;
+    m_nNumScatteringOrders = m_dNumScatteringOrders;
+    m_nAdaptiveScatteringOrdersEnable = m_dAdaptiveScatteringOrdersEnable;
+    m_nScatteringOrdersTolerance = m_dScatteringOrdersTolerance;
+    m_nAdaptiveQuadraturePasses = m_dAdaptiveQuadraturePasses;
 }
 
 void PhysicalSky::MakeNewParametersCurrent()
@@ -95,11 +191,6 @@ void PhysicalSky::MakeNewParametersCurrent()
     m_cAtmosphereHeight = m_nAtmosphereHeight;
     m_cGroundAlbedo = m_nGroundAlbedo;
 
-    m_cSunSizeMultiplier = m_nSunSizeMultiplier;
-    m_cSunIrradiance = m_nSunIrradiance;
-
-    m_cMoonSizeMultiplier = m_nMoonSizeMultiplier;
-
     m_cRayleighScatteringScale = m_nRayleighScatteringScale;
     m_cRayleighScatteringCoefficient = m_nRayleighScatteringCoefficient;
     m_cRayleighExponentialDistribution = m_nRayleighExponentialDistribution;
@@ -113,6 +204,16 @@ void PhysicalSky::MakeNewParametersCurrent()
 
     m_cOzoneAbsorptionScale = m_nOzoneAbsorptionScale;
     m_cOzoneAbsorptionCoefficient = m_nOzoneAbsorptionCoefficient;
+
+    m_cSharedPrecomputationEnable = m_nSharedPrecomputationEnable;
+    m_cComputeShaderPrecomputationEnable = m_nComputeShaderPrecomputationEnable;
+    m_cTextureResolutionTier = m_nTextureResolutionTier;
+    m_cCombinedScatteringTexturesEnable = m_nCombinedScatteringTexturesEnable;
+    m_cScatteringTextureFormat = m_nScatteringTextureFormat;
+    m_cNumScatteringOrders = m_nNumScatteringOrders;
+    m_cAdaptiveScatteringOrdersEnable = m_nAdaptiveScatteringOrdersEnable;
+    m_cScatteringOrdersTolerance = m_nScatteringOrdersTolerance;
+    m_cAdaptiveQuadraturePasses = m_nAdaptiveQuadraturePasses;
 }
 
 void PhysicalSky::ResetDefaults()
@@ -121,18 +222,27 @@ void PhysicalSky::ResetDefaults()
 
     MakeNewParametersCurrent();
 
+    m_cSunSizeMultiplier = m_dSunSizeMultiplier;
+    m_cSunIrradiance = m_dSunIrradiance;
     m_cSunLimbDarkeningAlgorithm = m_dSunLimbDarkeningAlgorithm;
 
+    m_cMoonSizeMultiplier = m_dMoonSizeMultiplier;
     m_cMoonEarthshineEnable = m_dMoonEarthshineEnable;
     m_cMoonColorMapEnable = m_dMoonColorMapEnable;
     m_cMoonNormalMapStrength = m_dMoonNormalMapStrength;
 
     m_cSkyStarsMapMultiplier = m_dSkyStarsMapMultiplier;
     m_cSkyMilkywayMapMultiplier = m_dSkyMilkywayMapMultiplier;
+    m_cSkyViewLutEnable = m_dSkyViewLutEnable;
+    m_cSkyCubemapEnable = m_dSkyCubemapEnable;
+    m_cSkyCubemapFacesPerFrame = m_dSkyCubemapFacesPerFrame;
+    m_cSceneFirstEnable = m_dSceneFirstEnable;
 
     m_cArtificialLightEnable = m_dArtificialLightEnable;
     m_cArtificialLightPos = m_dArtificialLightPos;
     m_cArtificialLightRadiantIntensity = m_dArtificialLightRadiantIntensity;
+
+    m_cAutoRecomputeEnable = m_dAutoRecomputeEnable;
 }
 
 bool PhysicalSky::AnyChange()
@@ -143,11 +253,6 @@ bool PhysicalSky::AnyChange()
     result |= m_nAtmosphereHeight != m_dAtmosphereHeight;
     result |= m_nGroundAlbedo != m_dGroundAlbedo;
 
-    result |= m_nSunSizeMultiplier != m_dSunSizeMultiplier;
-    result |= m_nSunIrradiance != m_dSunIrradiance;
-
-    result |= m_nMoonSizeMultiplier != m_dMoonSizeMultiplier;
-
     result |= m_nRayleighScatteringScale != m_dRayleighScatteringScale;
     result |= m_nRayleighScatteringCoefficient != m_dRayleighScatteringCoefficient;
     result |= m_nRayleighExponentialDistribution != m_dRayleighExponentialDistribution;
@@ -162,15 +267,32 @@ bool PhysicalSky::AnyChange()
     result |= m_nOzoneAbsorptionScale != m_dOzoneAbsorptionScale;
     result |= m_nOzoneAbsorptionCoefficient != m_dOzoneAbsorptionCoefficient;
 
+    result |= m_nSharedPrecomputationEnable != m_dSharedPrecomputationEnable;
+    result |= m_nComputeShaderPrecomputationEnable != m_dComputeShaderPrecomputationEnable;
+    result |= m_nTextureResolutionTier != m_dTextureResolutionTier;
+    result |= m_nCombinedScatteringTexturesEnable != m_dCombinedScatteringTexturesEnable;
+    result |= m_nScatteringTextureFormat != m_dScatteringTextureFormat;
+    result |= m_nNumScatteringOrders != m_dNumScatteringOrders;
+    result |= m_nAdaptiveScatteringOrdersEnable != m_dAdaptiveScatteringOrdersEnable;
+    result |= m_nScatteringOrdersTolerance != m_dScatteringOrdersTolerance;
+    result |= m_nAdaptiveQuadraturePasses != m_dAdaptiveQuadraturePasses;
+
 
+    result |= m_cSunSizeMultiplier != m_dSunSizeMultiplier;
+    result |= m_cSunIrradiance != m_dSunIrradiance;
     result |= m_cSunLimbDarkeningAlgorithm != m_dSunLimbDarkeningAlgorithm;
 
+    result |= m_cMoonSizeMultiplier != m_dMoonSizeMultiplier;
     result |= m_cMoonEarthshineEnable != m_dMoonEarthshineEnable;
     result |= m_cMoonColorMapEnable != m_dMoonColorMapEnable;
     result |= m_cMoonNormalMapStrength != m_dMoonNormalMapStrength;
 
     result |= m_cSkyStarsMapMultiplier != m_dSkyStarsMapMultiplier;
     result |= m_cSkyMilkywayMapMultiplier != m_dSkyMilkywayMapMultiplier;
+    result |= m_cSkyViewLutEnable != m_dSkyViewLutEnable;
+    result |= m_cSkyCubemapEnable != m_dSkyCubemapEnable;
+    result |= m_cSkyCubemapFacesPerFrame != m_dSkyCubemapFacesPerFrame;
+    result |= m_cSceneFirstEnable != m_dSceneFirstEnable;
 
     result |= m_cArtificialLightEnable != m_dArtificialLightEnable;
     result |= m_cArtificialLightPos != m_dArtificialLightPos;
@@ -202,70 +324,156 @@ double PhysicalSky::ComputeEarthshineIrradiance()
     return earthshineIrradiance;
 }
 
-void PhysicalSky::InitModel()
+const PhysicalSky::ModelSettings PhysicalSky::kDefaultModelSettings =
 {
-    int viewportData[4];
-    glGetIntegerv(GL_VIEWPORT, viewportData);
+    6360.0f, // planetRadius
+    100.0f, // atmosphereHeight
+    glm::vec3(0.300000f, 0.300000f, 0.300000f), // groundAlbedo
+    0.033100f, // rayleighScatteringScale
+    glm::vec3(0.175287f, 0.409607f, 1.000000f), // rayleighScatteringCoefficient
+    8.000000f, // rayleighExponentialDistribution
+    0.003996f, // mieScatteringScale
+    glm::vec3(1.000000f, 1.000000f, 1.000000f), // mieScatteringCoefficient
+    0.000444f, // mieAbsorptionScale
+    glm::vec3(1.000000f, 1.000000f, 1.000000f), // mieAbsorptionCoefficient
+    0.800000f, // miePhaseFunctionG
+    1.200000f, // mieExponentialDistribution
+    0.001881f, // ozoneAbsorptionScale
+    glm::vec3(0.345561f, 1.000000f, 0.045189f), // ozoneAbsorptionCoefficient
+    true, // sharedPrecomputation
+    false, // computeShaderPrecomputation
+    DEFAULT_RESOLUTION, // textureResolutionTier
+    false, // combinedScatteringTextures
+    FULL_PRECISION, // scatteringTextureFormat
+    kNumScatteringOrders, // numScatteringOrders
+    false, // adaptiveScatteringOrders
+    0.01f, // scatteringOrdersTolerance
+    0, // adaptiveQuadraturePasses
+};
+
+// Those of the default parameters of the constructor, without an instance (e.g. to precompute their textures offline)
+ModelParameters PhysicalSky::GetDefaultModelParameters()
+{
+    return ComputeModelParameters(kDefaultModelSettings);
+}
 
-    glm::dvec3 sun_irradiance = glm::dvec3(1.0, 1.0, 1.0) * (static_cast<double>(m_cSunIrradiance) / 3.0);
-    glm::vec3 sunHorizonCoordinates = m_astronomicalPositioning.GetSunHorizonCoordinates();
-    constexpr double sunRadius = 0.00465047;
-    double sunTanAngularRadius = (sunRadius * m_cSunSizeMultiplier)/ sunHorizonCoordinates.z;
-    double sun_angular_radius = glm::atan(sunTanAngularRadius);
+ModelParameters PhysicalSky::ComputeModelParameters()
+{
+    ModelSettings settings;
+    settings.planetRadius = m_cPlanetRadius;
+    settings.atmosphereHeight = m_cAtmosphereHeight;
+    settings.groundAlbedo = m_cGroundAlbedo;
+    settings.rayleighScatteringScale = m_cRayleighScatteringScale;
+    settings.rayleighScatteringCoefficient = m_cRayleighScatteringCoefficient;
+    settings.rayleighExponentialDistribution = m_cRayleighExponentialDistribution;
+    settings.mieScatteringScale = m_cMieScatteringScale;
+    settings.mieScatteringCoefficient = m_cMieScatteringCoefficient;
+    settings.mieAbsorptionScale = m_cMieAbsorptionScale;
+    settings.mieAbsorptionCoefficient = m_cMieAbsorptionCoefficient;
+    settings.miePhaseFunctionG = m_cMiePhaseFunctionG;
+    settings.mieExponentialDistribution = m_cMieExponentialDistribution;
+    settings.ozoneAbsorptionScale = m_cOzoneAbsorptionScale;
+    settings.ozoneAbsorptionCoefficient = m_cOzoneAbsorptionCoefficient;
+    settings.sharedPrecomputation = m_cSharedPrecomputationEnable;
+    settings.computeShaderPrecomputation = m_cComputeShaderPrecomputationEnable;
+    settings.textureResolutionTier = m_cTextureResolutionTier;
+    settings.combinedScatteringTextures = m_cCombinedScatteringTexturesEnable;
+    settings.scatteringTextureFormat = m_cScatteringTextureFormat;
+    settings.numScatteringOrders = m_cNumScatteringOrders;
+    settings.adaptiveScatteringOrders = m_cAdaptiveScatteringOrdersEnable;
+    settings.scatteringOrdersTolerance = m_cScatteringOrdersTolerance;
+    settings.adaptiveQuadraturePasses = m_cAdaptiveQuadraturePasses;
+    return ComputeModelParameters(settings);
+}
+
+ModelParameters PhysicalSky::ComputeModelParameters(const ModelSettings& settings)
+{
+    ModelParameters parameters;
 
-    glm::dvec3 moon_irradiance = ComputeMoonIrradiance();
-    glm::vec3 moonHorizonCoordinates = m_astronomicalPositioning.GetMoonHorizonCoordinates();
-    constexpr double moonRadius = 0.00001163;
-    double moonTanAngularRadius = (moonRadius * m_cMoonSizeMultiplier) / moonHorizonCoordinates.z;
-    double moon_angular_radius = glm::atan(moonTanAngularRadius);
+    // Precomputed for a unit irradiance and the mean angular radius of each source, the actual ones (which depend on the date) are set at runtime by UpdateAtmosphereSources
+    parameters.sunIrradiance = glm::dvec3(1.0, 1.0, 1.0);
+    constexpr double sunRadius = 0.00465047; // AU
+    constexpr double sunMeanDistance = 1.0; // AU
+    parameters.sunAngularRadius = glm::atan(sunRadius / sunMeanDistance);
 
-    double bottom_radius = static_cast<double>(m_cPlanetRadius) * 1000.0;
-    double top_radius = bottom_radius + static_cast<double>(m_cAtmosphereHeight) * 1000.0;
+    parameters.moonIrradiance = glm::dvec3(1.0, 1.0, 1.0);
+    constexpr double moonRadius = 0.00001163; // AU
+    constexpr double moonMeanDistance = 0.00256955; // AU
+    parameters.moonAngularRadius = glm::atan(moonRadius / moonMeanDistance);
 
-    DensityProfileLayer rayleigh_layer(0.0, 1.0, -1.0 / (static_cast<double>(m_cRayleighExponentialDistribution) * 1000.0), 0.0, 0.0);
-    glm::dvec3 rayleigh_scattering = static_cast<glm::dvec3>(m_cRayleighScatteringCoefficient) * (static_cast<double>(m_cRayleighScatteringScale) / 1000.0);
+    parameters.bottomRadius = static_cast<double>(settings.planetRadius) * 1000.0;
+    parameters.topRadius = parameters.bottomRadius + static_cast<double>(settings.atmosphereHeight) * 1000.0;
 
-    DensityProfileLayer mie_layer(0.0, 1.0, -1.0 / (static_cast<double>(m_cMieExponentialDistribution) * 1000.0), 0.0, 0.0);
-    glm::dvec3 mie_scattering = static_cast<glm::dvec3>(m_cMieScatteringCoefficient) * (static_cast<double>(m_cMieScatteringScale) / 1000.0);
-    glm::dvec3 mie_extinction = mie_scattering + static_cast<glm::dvec3>(m_cMieAbsorptionCoefficient) * (static_cast<double>(m_cMieAbsorptionScale) / 1000.0);
-    double mie_phase_function_g = static_cast<double>(m_cMiePhaseFunctionG);
+    DensityProfileLayer rayleigh_layer(0.0, 1.0, -1.0 / (static_cast<double>(settings.rayleighExponentialDistribution) * 1000.0), 0.0, 0.0);
+    parameters.rayleighDensity = { rayleigh_layer };
+    parameters.rayleighScattering = static_cast<glm::dvec3>(settings.rayleighScatteringCoefficient) * (static_cast<double>(settings.rayleighScatteringScale) / 1000.0);
+
+    DensityProfileLayer mie_layer(0.0, 1.0, -1.0 / (static_cast<double>(settings.mieExponentialDistribution) * 1000.0), 0.0, 0.0);
+    parameters.mieDensity = { mie_layer };
+    parameters.mieScattering = static_cast<glm::dvec3>(settings.mieScatteringCoefficient) * (static_cast<double>(settings.mieScatteringScale) / 1000.0);
+    parameters.mieExtinction = parameters.mieScattering + static_cast<glm::dvec3>(settings.mieAbsorptionCoefficient) * (static_cast<double>(settings.mieAbsorptionScale) / 1000.0);
+    parameters.miePhaseFunctionG = static_cast<double>(settings.miePhaseFunctionG);
 
     // Density profile increasing linearly from 0 to 1 between 10 and 25km, and
     // decreasing linearly from 1 to 0 between 25 and 40km. This is an approximate
     // profile from http://www.kln.ac.lk/science/Chemistry/Teaching_Resources/
     // Documents/Introduction%20to%20atmospheric%20chemistry.pdf (page 10).
-    std::vector<DensityProfileLayer> ozone_density;
-    ozone_density.push_back(DensityProfileLayer(25000.0, 0.0, 0.0, 1.0 / 15000.0, -2.0 / 3.0));
-    ozone_density.push_back(DensityProfileLayer(0.0, 0.0, 0.0, -1.0 / 15000.0, 8.0 / 3.0));
-    glm::dvec3 absorption_extinction = (static_cast<glm::dvec3>(m_cOzoneAbsorptionCoefficient) * static_cast<double>(m_cOzoneAbsorptionScale)) / 1000.0;
-
-    glm::dvec3 ground_albedo = static_cast<glm::dvec3>(m_cGroundAlbedo);
-    constexpr double max_sun_zenith_angle = 120.0 / 180.0 * glm::pi<double>(); // TODO: Take a look at this value https://ebruneton.github.io/precomputed_atmospheric_scattering/atmosphere/model.h.html
-
-    m_solarModel.reset(new Model(sun_irradiance, sun_angular_radius, moon_irradiance, moon_angular_radius,
-        bottom_radius, top_radius, { rayleigh_layer }, rayleigh_scattering,
-        { mie_layer }, mie_scattering, mie_extinction, mie_phase_function_g,
-        ozone_density, absorption_extinction, ground_albedo, max_sun_zenith_angle,
-        kLengthUnitInMeters, SOURCE_SUN));
-    m_solarModel->Init();
-
-    m_lunarModel.reset(new Model(sun_irradiance, sun_angular_radius, moon_irradiance, moon_angular_radius,
-        bottom_radius, top_radius, { rayleigh_layer }, rayleigh_scattering,
-        { mie_layer }, mie_scattering, mie_extinction, mie_phase_function_g,
-        ozone_density, absorption_extinction, ground_albedo, max_sun_zenith_angle,
-        kLengthUnitInMeters, SOURCE_MOON));
-    m_lunarModel->Init();
+    parameters.absorptionDensity.push_back(DensityProfileLayer(25000.0, 0.0, 0.0, 1.0 / 15000.0, -2.0 / 3.0));
+    parameters.absorptionDensity.push_back(DensityProfileLayer(0.0, 0.0, 0.0, -1.0 / 15000.0, 8.0 / 3.0));
+    parameters.absorptionExtinction = (static_cast<glm::dvec3>(settings.ozoneAbsorptionCoefficient) * static_cast<double>(settings.ozoneAbsorptionScale)) / 1000.0;
+
+    parameters.groundAlbedo = static_cast<glm::dvec3>(settings.groundAlbedo);
+    parameters.maxSunZenithAngle = 120.0 / 180.0 * glm::pi<double>(); // TODO: Take a look at this value https://ebruneton.github.io/precomputed_atmospheric_scattering/atmosphere/model.h.html
+    parameters.lengthUnitInMeters = kLengthUnitInMeters;
+
+    parameters.textureResolution = GetTextureResolution(settings.textureResolutionTier);
+    parameters.combineScatteringTextures = settings.combinedScatteringTextures;
+    parameters.scatteringTextureFormat = settings.scatteringTextureFormat;
+    parameters.numScatteringOrders = static_cast<unsigned int>(settings.numScatteringOrders);
+    parameters.convergenceTolerance = settings.adaptiveScatteringOrders ? static_cast<double>(settings.scatteringOrdersTolerance) : 0.0;
+    parameters.adaptiveQuadraturePasses = settings.adaptiveQuadraturePasses;
+    parameters.sharedPrecomputation = settings.sharedPrecomputation;
+    parameters.precomputationBackend = settings.computeShaderPrecomputation ? COMPUTE_SHADER : FRAGMENT_SHADER;
+
+    return parameters;
+}
+
+void PhysicalSky::InitModel()
+{
+    int viewportData[4];
+    glGetIntegerv(GL_VIEWPORT, viewportData);
+
+    m_requestedModelParameters = ComputeModelParameters();
+    AtmospherePrecomputer::Build(m_requestedModelParameters, m_lutCache, m_solarModel, m_lunarModel, Model::ProgressCallback());
 
     glViewport(viewportData[0], viewportData[1], viewportData[2], viewportData[3]);
 
     if (glGetError() != GL_NO_ERROR) std::cerr << "[OpenGL] E: Initializing model." << std::endl;
 
+    OnModelChanged();
+}
+
+void PhysicalSky::RequestModel()
+{
+    if (m_precomputer)
+    {
+        m_requestedModelParameters = ComputeModelParameters();
+        m_precomputer->Request(m_requestedModelParameters);
+    }
+    else InitModel();
+}
+
+void PhysicalSky::OnModelChanged()
+{
     /*
-    <p>Then, it creates and compiles the vertex and fragment shaders used to render
-    our demo scene, and link them with the <code>Model</code>'s atmosphere shader
-    to get the final scene rendering program:
+    <p>Then, it links the vertex and fragment shaders used to render our demo
+    scene with the <code>Model</code>'s atmosphere shader to get the final scene
+    rendering programs. This is only needed when the source of the atmosphere
+    shader changes (e.g. not for another number of scattering orders):
     */
-    InitShaders();
+    if (m_solarModel->shader_hash() != m_atmosphereShaderHash) LinkAtmospherePrograms();
+    BindAtmosphereTextures();
+    m_skyCubemapValid = false;
 
     // Required because initalizing the model messes with these
     glEnable(GL_BLEND);
@@ -275,53 +483,42 @@ void PhysicalSky::InitModel()
 
 void PhysicalSky::InitShaders()
 {
-    ShaderStage skyVertexShader = ShaderStage();
-    skyVertexShader.Create(ShaderType::VERTEX);
-    skyVertexShader.Compile("./resources/shaders/sky.vert", "./resources/shaders/");
-    ShaderStage skyFragmentShader = ShaderStage();
-    skyFragmentShader.Create(ShaderType::FRAGMENT);
-    skyFragmentShader.Compile("./resources/shaders/sky.frag", "./resources/shaders/");
-    m_skyShader.Create();
-    m_skyShader.AttachShader(skyVertexShader.m_id);
-    m_skyShader.AttachShader(skyFragmentShader.m_id);
-    m_skyShader.AttachShader(m_solarModel->shader());
-    m_skyShader.Build();
-
-    ShaderStage moonVertexShader = ShaderStage();
-    moonVertexShader.Create(ShaderType::VERTEX);
-    moonVertexShader.Compile("./resources/shaders/moon.vert", "./resources/shaders/");
-    ShaderStage moonFragmentShader = ShaderStage();
-    moonFragmentShader.Create(ShaderType::FRAGMENT);
-    moonFragmentShader.Compile("./resources/shaders/moon.frag", "./resources/shaders/");
-    m_moonShader.Create();
-    m_moonShader.AttachShader(moonVertexShader.m_id);
-    m_moonShader.AttachShader(moonFragmentShader.m_id);
-    m_moonShader.AttachShader(m_solarModel->shader());
-    m_moonShader.Build();
-
-    ShaderStage sunVertexShader = ShaderStage();
-    sunVertexShader.Create(ShaderType::VERTEX);
-    sunVertexShader.Compile("./resources/shaders/sun.vert", "./resources/shaders/");
-    ShaderStage sunFragmentShader = ShaderStage();
-    sunFragmentShader.Create(ShaderType::FRAGMENT);
-    sunFragmentShader.Compile("./resources/shaders/sun.frag", "./resources/shaders/");
-    m_sunShader.Create();
-    m_sunShader.AttachShader(sunVertexShader.m_id);
-    m_sunShader.AttachShader(sunFragmentShader.m_id);
-    m_sunShader.AttachShader(m_solarModel->shader());
-    m_sunShader.Build();
-
-    ShaderStage meshVertexShader = ShaderStage();
-    meshVertexShader.Create(ShaderType::VERTEX);
-    meshVertexShader.Compile("./resources/shaders/mesh.vert", "./resources/shaders/");
-    ShaderStage meshFragmentShader = ShaderStage();
-    meshFragmentShader.Create(ShaderType::FRAGMENT);
-    meshFragmentShader.Compile("./resources/shaders/mesh.frag", "./resources/shaders/");
-    m_meshShader.Create();
-    m_meshShader.AttachShader(meshVertexShader.m_id);
-    m_meshShader.AttachShader(meshFragmentShader.m_id);
-    m_meshShader.AttachShader(m_solarModel->shader());
-    m_meshShader.Build();
+    m_skyVertexShader.Create(ShaderType::VERTEX);
+    m_skyVertexShader.Compile("./resources/shaders/sky.vert", "./resources/shaders/");
+    m_skyFragmentShader.Create(ShaderType::FRAGMENT);
+    m_skyFragmentShader.Compile("./resources/shaders/sky.frag", "./resources/shaders/");
+
+    m_skyViewLutVertexShader.Create(ShaderType::VERTEX);
+    m_skyViewLutVertexShader.Compile("./resources/shaders/sky_view_lut.vert", "./resources/shaders/");
+    m_skyViewLutFragmentShader.Create(ShaderType::FRAGMENT);
+    m_skyViewLutFragmentShader.Compile("./resources/shaders/sky_view_lut.frag", "./resources/shaders/");
+
+    m_skyCubemapVertexShader.Create(ShaderType::VERTEX);
+    m_skyCubemapVertexShader.Compile("./resources/shaders/sky_cubemap.vert", "./resources/shaders/");
+
+    ShaderStage skyCachedFragmentShader = ShaderStage();
+    skyCachedFragmentShader.Create(ShaderType::FRAGMENT);
+    skyCachedFragmentShader.Compile("./resources/shaders/sky_cached.frag", "./resources/shaders/");
+    m_skyCachedShader.Create();
+    m_skyCachedShader.AttachShader(m_skyVertexShader.m_id);
+    m_skyCachedShader.AttachShader(skyCachedFragmentShader.m_id);
+    m_skyCachedShader.Build();
+    m_skyCachedShader.SetUniformBlockBinding("FrameUniforms", kFrameUniformsBinding);
+
+    m_moonVertexShader.Create(ShaderType::VERTEX);
+    m_moonVertexShader.Compile("./resources/shaders/moon.vert", "./resources/shaders/");
+    m_moonFragmentShader.Create(ShaderType::FRAGMENT);
+    m_moonFragmentShader.Compile("./resources/shaders/moon.frag", "./resources/shaders/");
+
+    m_sunVertexShader.Create(ShaderType::VERTEX);
+    m_sunVertexShader.Compile("./resources/shaders/sun.vert", "./resources/shaders/");
+    m_sunFragmentShader.Create(ShaderType::FRAGMENT);
+    m_sunFragmentShader.Compile("./resources/shaders/sun.frag", "./resources/shaders/");
+
+    m_meshVertexShader.Create(ShaderType::VERTEX);
+    m_meshVertexShader.Compile("./resources/shaders/mesh.vert", "./resources/shaders/");
+    m_meshFragmentShader.Create(ShaderType::FRAGMENT);
+    m_meshFragmentShader.Compile("./resources/shaders/mesh.frag", "./resources/shaders/");
 
     // NOTE: Might add atmosphere shader
     ShaderStage lightVertexShader = ShaderStage();
@@ -334,20 +531,154 @@ void PhysicalSky::InitShaders()
     m_lightShader.AttachShader(lightVertexShader.m_id);
     m_lightShader.AttachShader(lightFragmentShader.m_id);
     m_lightShader.Build();
+    m_lightShader.SetUniformBlockBinding("FrameUniforms", kFrameUniformsBinding);
 
 }
 
+// Links the stages compiled by InitShaders with the atmosphere shader of the solar model
+void PhysicalSky::LinkAtmospherePrograms()
+{
+    struct Stages
+    {
+        ShaderProgram* program;
+        GLuint vertexShader;
+        GLuint fragmentShader;
+    };
+    const Stages programs[] =
+    {
+        {&m_skyShader, m_skyVertexShader.m_id, m_skyFragmentShader.m_id},
+        {&m_skyViewLutShader, m_skyViewLutVertexShader.m_id, m_skyViewLutFragmentShader.m_id},
+        {&m_skyCubemapShader, m_skyCubemapVertexShader.m_id, m_skyFragmentShader.m_id},
+        {&m_sunShader, m_sunVertexShader.m_id, m_sunFragmentShader.m_id},
+        {&m_moonShader, m_moonVertexShader.m_id, m_moonFragmentShader.m_id},
+        {&m_meshShader, m_meshVertexShader.m_id, m_meshFragmentShader.m_id},
+    };
+    for (const Stages& stages : programs)
+    {
+        stages.program->Create();
+        stages.program->AttachShader(stages.vertexShader);
+        stages.program->AttachShader(stages.fragmentShader);
+        stages.program->AttachShader(m_solarModel->shader());
+        stages.program->Build();
+        stages.program->SetUniformBlockBinding("FrameUniforms", kFrameUniformsBinding);
+    }
+    m_atmosphereShaderHash = m_solarModel->shader_hash();
+}
+
+// Only needed when the models are replaced, the textures then stay bound and the samplers of the (new) programs keep their value
+void PhysicalSky::BindAtmosphereTextures()
+{
+    m_solarModel->BindTextures(kSolarTextureUnit, kSolarTextureUnit + 1, kSolarTextureUnit + 2, kSolarTextureUnit + 3);
+    m_lunarModel->BindTextures(kLunarTextureUnit, kLunarTextureUnit + 1, kLunarTextureUnit + 2, kLunarTextureUnit + 3);
+    glActiveTexture(GL_TEXTURE0);
+    Profiler::CountGlCalls(BindTexturesGlCalls(*m_solarModel) + BindTexturesGlCalls(*m_lunarModel) + 1);
+
+    m_atmosphereSourcesValid = false; // The new models are set to a unit irradiance, see UpdateAtmosphereSources
+    for (ShaderProgram* program : GetAtmospherePrograms())
+    {
+        program->Use();
+        m_solarModel->SetProgramSamplers(program->m_id, kSolarTextureUnit, kSolarTextureUnit + 1, kSolarTextureUnit + 2, kSolarTextureUnit + 3);
+        m_lunarModel->SetProgramSamplers(program->m_id, kLunarTextureUnit, kLunarTextureUnit + 1, kLunarTextureUnit + 2, kLunarTextureUnit + 3);
+        Profiler::CountGlCalls(ProgramSamplersGlCalls(*m_solarModel) + ProgramSamplersGlCalls(*m_lunarModel));
+    }
+    // Bound by InitResources
+    m_skyShader.Use();
+    m_skyShader.SetInt("SkyViewLut", kSkyViewLutTextureUnit);
+    m_skyCubemapShader.Use();
+    m_skyCubemapShader.SetInt("SkyViewLut", kSkyViewLutTextureUnit);
+    m_skyCachedShader.Use();
+    m_skyCachedShader.SetInt("SkyCubemap", kSkyCubemapTextureUnit);
+    glUseProgram(0);
+    Profiler::CountGlCalls(1);
+}
+
+// The programs linked with the atmosphere shader of the models
+std::array<ShaderProgram*, 6> PhysicalSky::GetAtmospherePrograms()
+{
+    return {&m_skyShader, &m_skyViewLutShader, &m_skyCubemapShader, &m_sunShader, &m_moonShader, &m_meshShader};
+}
+
+// Sets the irradiance and angular radius of the sun and moon of the current date, only updating the programs when they change
+void PhysicalSky::UpdateAtmosphereSources(float tanSunAngularRadius, float tanMoonAngularRadius)
+{
+    glm::dvec3 sunIrradiance = glm::dvec3(1.0, 1.0, 1.0) * (static_cast<double>(m_cSunIrradiance) / 3.0);
+    double sunAngularRadius = glm::atan(static_cast<double>(tanSunAngularRadius));
+    glm::dvec3 moonIrradiance = ComputeMoonIrradiance();
+    double moonAngularRadius = glm::atan(static_cast<double>(tanMoonAngularRadius));
+
+    bool changed = !m_atmosphereSourcesValid;
+    changed |= sunIrradiance != m_sunSourceIrradiance || sunAngularRadius != m_sunSourceAngularRadius;
+    changed |= moonIrradiance != m_moonSourceIrradiance || moonAngularRadius != m_moonSourceAngularRadius;
+    if (!changed) return;
+
+    m_solarModel->SetSource(sunIrradiance, sunAngularRadius);
+    m_lunarModel->SetSource(moonIrradiance, moonAngularRadius);
+    for (ShaderProgram* program : GetAtmospherePrograms())
+    {
+        program->Use();
+        m_solarModel->SetProgramSourceUniforms(program->m_id);
+        m_lunarModel->SetProgramSourceUniforms(program->m_id);
+        Profiler::CountGlCalls(2 * kSourceUniformsGlCalls); // glUseProgram is counted by ShaderProgram
+    }
+
+    m_sunSourceIrradiance = sunIrradiance;
+    m_sunSourceAngularRadius = sunAngularRadius;
+    m_moonSourceIrradiance = moonIrradiance;
+    m_moonSourceAngularRadius = moonAngularRadius;
+    m_atmosphereSourcesValid = true;
+}
+
 void PhysicalSky::InitResources()
 {
+    glGenBuffers(1, &m_frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+
+    // Full precision, since the radiance of the night sky can be below the normal range of half floats
+    glGenTextures(1, &m_skyViewLutTexture);
+    glActiveTexture(GL_TEXTURE0 + kSkyViewLutTextureUnit);
+    glBindTexture(GL_TEXTURE_2D, m_skyViewLutTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, kSkyViewLutWidth, kSkyViewLutHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // Azimuth
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0);
+
+    glGenFramebuffers(1, &m_skyViewLutFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_skyViewLutFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_skyViewLutTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) std::cerr << "[OpenGL] E: Sky-view LUT framebuffer is not complete." << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+
+    glGenTextures(1, &m_skyCubemapTexture);
+    glActiveTexture(GL_TEXTURE0 + kSkyCubemapTextureUnit);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_skyCubemapTexture);
+    for (int face = 0; face < 6; ++face)
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA32F, kSkyCubemapSize, kSkyCubemapSize, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+    glGenFramebuffers(1, &m_skyCubemapFramebuffer);
+
     m_moonNormalMap.Load("./resources/textures/moon_normal.png");
     m_moonColorMap.Load("./resources/textures/moon_color.png");
     m_skyStarsMap.Load("./resources/textures/stars_foreground.hdr");
     m_skyMilkywayMap.Load("./resources/textures/stars_background.hdr");
 }
 
-void PhysicalSky::Update()
+void PhysicalSky::Update(float deltaTime)
 {
-    m_astronomicalPositioning.Update();
+    m_astronomicalPositioning.Update(deltaTime);
+
+    // Swap in the models precomputed in the background, if any, at the frame boundary
+    if (m_precomputer && m_precomputer->Poll(m_solarModel, m_lunarModel)) OnModelChanged();
+    m_cpuReference.Poll();
 
     if (ImGui::Begin("Atmosphere Rendering"))
     {
@@ -364,8 +695,9 @@ void PhysicalSky::Update()
         {
             ImGui::PushID("Sun");
             // TODO: Color
-            m_notAppliedChanges |= ImGui::SliderFloat("Size Multiplier", &m_nSunSizeMultiplier, 0.2f, 5.0f);
-            m_notAppliedChanges |= ImGui::SliderFloat("Irradiance (W*m^-2)", &m_nSunIrradiance, 0.0f, 15000.0f);
+            // Applied by UpdateAtmosphereSources, the models do not depend on them
+            ImGui::SliderFloat("Size Multiplier", &m_cSunSizeMultiplier, 0.2f, 5.0f);
+            ImGui::SliderFloat("Irradiance (W*m^-2)", &m_cSunIrradiance, 0.0f, 15000.0f);
             ImGui::RadioButton("None", reinterpret_cast<int*>(&m_cSunLimbDarkeningAlgorithm), static_cast<int>(SunLimbDarkeningAlgorithm::NONE)); ImGui::SameLine();
             ImGui::RadioButton("NEC96", reinterpret_cast<int*>(&m_cSunLimbDarkeningAlgorithm), static_cast<int>(SunLimbDarkeningAlgorithm::NEC96)); ImGui::SameLine();
             ImGui::RadioButton("HM98", reinterpret_cast<int*>(&m_cSunLimbDarkeningAlgorithm), static_cast<int>(SunLimbDarkeningAlgorithm::HM98)); ImGui::SameLine();
@@ -376,7 +708,7 @@ void PhysicalSky::Update()
         if (ImGui::CollapsingHeader("Moon"))
         {
             ImGui::PushID("Moon");
-            m_notAppliedChanges |= ImGui::SliderFloat("Size Multiplier", &m_nMoonSizeMultiplier, 0.2f, 5.0f);
+            ImGui::SliderFloat("Size Multiplier", &m_cMoonSizeMultiplier, 0.2f, 5.0f);
             ImGui::Checkbox("Enable Earthshine", &m_cMoonEarthshineEnable);
             ImGui::Checkbox("Use Color Map", &m_cMoonColorMapEnable);
             ImGui::SliderFloat("Normal Map Strength", &m_cMoonNormalMapStrength, 0.0f, 1.0f, "%.3f", ImGuiSliderFlags_AlwaysClamp);
@@ -388,6 +720,19 @@ void PhysicalSky::Update()
             ImGui::PushID("Sky");
             ImGui::SliderFloat("Stars Map Multiplier", &m_cSkyStarsMapMultiplier, -5.0f, 5.0f);
             ImGui::SliderFloat("Milky Way Map Multiplier", &m_cSkyMilkywayMapMultiplier, -5.0f, 5.0f);
+            ImGui::Checkbox("Use Sky-View LUT", &m_cSkyViewLutEnable);
+            if (ImGui::Button("Compare Sky-View LUT With Per-Pixel Sky")) RequestSkyViewLutComparison();
+            if (m_skyViewLutError.valid)
+                ImGui::Text("RMS: %.3e, RMS Rel: %.3e, Max Rel: %.3e", m_skyViewLutError.rmsError, m_skyViewLutError.relativeRmsError, m_skyViewLutError.maxRelativeError);
+            ImGui::Checkbox("Cache Sky In Cubemap", &m_cSkyCubemapEnable);
+            if (m_cSkyCubemapEnable)
+            {
+                ImGui::SliderInt("Cubemap Faces Per Frame", &m_cSkyCubemapFacesPerFrame, 1, 6, "%d", ImGuiSliderFlags_AlwaysClamp);
+                unsigned int frames = m_skyCubemapHits + m_skyCubemapPartialUpdates + m_skyCubemapFullUpdates;
+                float hitRate = frames > 0 ? 100.0f * static_cast<float>(m_skyCubemapHits) / static_cast<float>(frames) : 0.0f;
+                ImGui::Text("Hit Rate: %.1f%% | Hits: %u, Partial Updates: %u, Full Updates: %u", hitRate, m_skyCubemapHits, m_skyCubemapPartialUpdates, m_skyCubemapFullUpdates);
+            }
+            ImGui::Checkbox("Draw Scene First", &m_cSceneFirstEnable);
             ImGui::PopID();
         }
 
@@ -429,21 +774,78 @@ void PhysicalSky::Update()
             ImGui::PopID();
         }
 
+        if (ImGui::CollapsingHeader("Precomputation"))
+        {
+            ImGui::PushID("Precomputation");
+            m_notAppliedChanges |= ImGui::Checkbox("Share Solar and Lunar Textures", &m_nSharedPrecomputationEnable);
+            if (Model::IsComputeShaderBackendSupported()) m_notAppliedChanges |= ImGui::Checkbox("Use Compute Shaders", &m_nComputeShaderPrecomputationEnable);
+            else ImGui::Text("Compute Shaders: Unsupported (OpenGL 4.3 required)");
+            ImGui::Text("Texture Resolution"); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::RadioButton("Low", reinterpret_cast<int*>(&m_nTextureResolutionTier), static_cast<int>(LOW_RESOLUTION)); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::RadioButton("Default", reinterpret_cast<int*>(&m_nTextureResolutionTier), static_cast<int>(DEFAULT_RESOLUTION)); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::RadioButton("Reference", reinterpret_cast<int*>(&m_nTextureResolutionTier), static_cast<int>(REFERENCE_RESOLUTION));
+            m_notAppliedChanges |= ImGui::Checkbox("Combine Scattering Textures (Approximate Mie)", &m_nCombinedScatteringTexturesEnable);
+            ImGui::Text("Scattering Storage"); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::RadioButton("32F", reinterpret_cast<int*>(&m_nScatteringTextureFormat), static_cast<int>(FULL_PRECISION)); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::RadioButton("16F", reinterpret_cast<int*>(&m_nScatteringTextureFormat), static_cast<int>(HALF_PRECISION)); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::RadioButton("RGB9E5", reinterpret_cast<int*>(&m_nScatteringTextureFormat), static_cast<int>(SHARED_EXPONENT));
+            m_notAppliedChanges |= ImGui::SliderInt(m_nAdaptiveScatteringOrdersEnable ? "Max Scattering Orders" : "Scattering Orders", &m_nNumScatteringOrders, 1, 10, "%d", ImGuiSliderFlags_AlwaysClamp);
+            m_notAppliedChanges |= ImGui::Checkbox("Stop On Convergence", &m_nAdaptiveScatteringOrdersEnable);
+            if (m_nAdaptiveScatteringOrdersEnable) m_notAppliedChanges |= ImGui::SliderFloat("Energy Tolerance", &m_nScatteringOrdersTolerance, 0.0001f, 0.1f, "%.4f", ImGuiSliderFlags_AlwaysClamp);
+            ImGui::Text("Adaptive Quadrature");
+            m_notAppliedChanges |= ImGui::CheckboxFlags("Transmittance", &m_nAdaptiveQuadraturePasses, ADAPTIVE_TRANSMITTANCE_QUADRATURE); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::CheckboxFlags("Single Scattering", &m_nAdaptiveQuadraturePasses, ADAPTIVE_SINGLE_SCATTERING_QUADRATURE);
+            m_notAppliedChanges |= ImGui::CheckboxFlags("Scattering Density", &m_nAdaptiveQuadraturePasses, ADAPTIVE_SCATTERING_DENSITY_QUADRATURE); ImGui::SameLine();
+            m_notAppliedChanges |= ImGui::CheckboxFlags("Multiple Scattering", &m_nAdaptiveQuadraturePasses, ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE);
+            ImGui::Checkbox("Recompute Automatically", &m_cAutoRecomputeEnable);
+            if (m_precomputer && m_precomputer->IsBusy())
+            {
+                unsigned int completedOrders = m_precomputer->GetCompletedOrders();
+                unsigned int totalOrders = m_precomputer->GetTotalOrders();
+                char overlay[64];
+                std::snprintf(overlay, sizeof(overlay), "Scattering Order %u/%u", completedOrders, totalOrders);
+                ImGui::ProgressBar(totalOrders > 0 ? static_cast<float>(completedOrders) / static_cast<float>(totalOrders) : 0.0f, ImVec2(0.0f, 0.0f), overlay);
+            }
+            if (m_solarModel->precomputation_time() > 0.0)
+            {
+                const char* backend = m_solarModel->precomputation_backend() == COMPUTE_SHADER ? "Compute Shaders" : "Fragment Shaders";
+                ImGui::Text("Last Precomputation: %.1f ms (%s)", m_solarModel->precomputation_time() * 1000.0, backend);
+            }
+            ImGui::Text("Scattering Orders | Sun: %u, Moon: %u", m_solarModel->num_precomputed_scattering_orders(), m_lunarModel->num_precomputed_scattering_orders());
+            ImGui::Text("LUT Cache | Hits: %d, Misses: %d", m_lutCache.GetHits(), m_lutCache.GetMisses());
+            if (ImGui::Button("Clear Cache")) m_lutCache.Clear();
+            bool precomputing = m_precomputer && m_precomputer->IsBusy();
+            if (m_cpuReference.IsRunning()) ImGui::Text("Computing CPU Reference...");
+            else if (!CpuReference::IsSupported(*m_solarModel)) ImGui::Text("CPU Reference: Default Resolution, Separate Textures Only");
+            else if (!precomputing && ImGui::Button("Compare With CPU Reference")) m_cpuReference.Start(m_requestedModelParameters, *m_solarModel, SOURCE_SUN);
+            if (m_cpuReference.HasResult())
+            {
+                const CpuReference::Result& result = m_cpuReference.GetResult();
+                ImGui::Text("CPU Time: %.2f s (%u threads)", result.totalSeconds, result.numThreads);
+                ImGui::Text("Transmittance: %.3f s, Direct Irradiance: %.3f s", result.transmittanceSeconds, result.directIrradianceSeconds);
+                ImGui::Text("Single Scattering: %.3f s, Scattering Density: %.3f s", result.singleScatteringSeconds, result.scatteringDensitySeconds);
+                ImGui::Text("Indirect Irradiance: %.3f s, Multiple Scattering: %.3f s", result.indirectIrradianceSeconds, result.multipleScatteringSeconds);
+                for (const CpuReference::TextureDifference& difference : result.differences)
+                    ImGui::Text("%s | Max Abs: %.3e, Max Rel: %.3e, RMS Rel: %.3e", difference.name, difference.maxAbsoluteError, difference.maxRelativeError, difference.rmsRelativeError);
+            }
+            ImGui::PopID();
+        }
+
         if (AnyChange())
         {
             if (ImGui::Button("Reset Defaults"))
             {
                 ResetDefaults();
-                InitModel();
+                RequestModel();
             }
         }
 
         if (m_notAppliedChanges)
         {
-            if (ImGui::Button("Recompute Model"))
+            if ((m_precomputer && m_cAutoRecomputeEnable) || ImGui::Button("Recompute Model"))
             {
                 MakeNewParametersCurrent();
-                InitModel();
+                RequestModel();
                 m_notAppliedChanges = false;
             }
         }
@@ -451,78 +853,174 @@ void PhysicalSky::Update()
     ImGui::End();
 }
 
-void PhysicalSky::Render(const Camera& camera)
+// Sets the new value of a parameter by name, as used by benchmark scripts (enumerations and booleans as numbers)
+bool PhysicalSky::SetParameter(const std::string& name, double value)
+{
+    if (name == "texture_resolution") m_nTextureResolutionTier = static_cast<TextureResolutionTier>(static_cast<int>(value));
+    else if (name == "combine_scattering_textures") m_nCombinedScatteringTexturesEnable = value != 0.0;
+    else if (name == "scattering_texture_format") m_nScatteringTextureFormat = static_cast<ScatteringTextureFormat>(static_cast<int>(value));
+    else if (name == "scattering_orders") m_nNumScatteringOrders = static_cast<int>(value);
+    else if (name == "scattering_orders_tolerance")
+    {
+        m_nAdaptiveScatteringOrdersEnable = value > 0.0;
+        if (value > 0.0) m_nScatteringOrdersTolerance = static_cast<float>(value);
+    }
+    else if (name == "adaptive_quadrature_passes") m_nAdaptiveQuadraturePasses = static_cast<unsigned int>(value);
+    else if (name == "shared_precomputation") m_nSharedPrecomputationEnable = value != 0.0;
+    else if (name == "compute_shaders") m_nComputeShaderPrecomputationEnable = value != 0.0 && Model::IsComputeShaderBackendSupported();
+    else if (name == "sun_size_multiplier") m_cSunSizeMultiplier = static_cast<float>(value);
+    else if (name == "moon_size_multiplier") m_cMoonSizeMultiplier = static_cast<float>(value);
+    else if (name == "moon_earthshine") m_cMoonEarthshineEnable = value != 0.0;
+    else if (name == "stars_multiplier") m_cSkyStarsMapMultiplier = static_cast<float>(value);
+    else if (name == "milky_way_multiplier") m_cSkyMilkywayMapMultiplier = static_cast<float>(value);
+    else if (name == "sky_view_lut") m_cSkyViewLutEnable = value != 0.0;
+    else if (name == "sky_cubemap") m_cSkyCubemapEnable = value != 0.0;
+    else if (name == "scene_first") m_cSceneFirstEnable = value != 0.0;
+    else if (name == "sky_cubemap_faces_per_frame") m_cSkyCubemapFacesPerFrame = glm::clamp(static_cast<int>(value), 1, 6);
+    else if (name == "artificial_light") m_cArtificialLightEnable = value != 0.0;
+    else if (name == "ephemeris_tier") m_astronomicalPositioning.SetEphemerisTier(static_cast<Ephemeris::Tier>(glm::clamp(static_cast<int>(value), static_cast<int>(Ephemeris::Tier::LOW_PRECISION), static_cast<int>(Ephemeris::Tier::TABULATED))));
+    else return false;
+    return true;
+}
+
+// Makes the new parameters current and recomputes the model, even if nothing changed
+void PhysicalSky::ApplyParameters()
 {
-    glm::mat4 horizonToWorld = glm::mat4(glm::vec4(0.0f, 0.0f, 1.0f, 0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    MakeNewParametersCurrent();
+    RequestModel();
+    m_notAppliedChanges = false;
+}
+
+// Of the last completed models, in seconds
+double PhysicalSky::GetPrecomputationTime() const
+{
+    return m_solarModel->precomputation_time() + m_lunarModel->precomputation_time();
+}
+
+void PhysicalSky::Render(const Camera& camera, Profiler& profiler)
+{
+    const AstronomicalPositioning::Transforms& transforms = m_astronomicalPositioning.GetTransforms();
 
     glm::dvec3 sunHorizonCoordinates = m_astronomicalPositioning.GetSunHorizonCoordinates();
-    glm::vec2 sunHorizonCos = glm::cos(sunHorizonCoordinates);
-    glm::vec2 sunHorizonSin = glm::sin(sunHorizonCoordinates);
-    glm::vec3 sunHorizonDirection = glm::vec3(sunHorizonCos.y * sunHorizonCos.x, sunHorizonCos.y * sunHorizonSin.x, sunHorizonSin.y);
-    glm::vec3 sunWorldDirection = glm::vec3(horizonToWorld * glm::vec4(sunHorizonDirection, 0.0));
+    glm::vec3 sunWorldDirection = glm::vec3(transforms.worldFromHorizon * HorizonDirection(sunHorizonCoordinates));
     constexpr float sunRadius = 0.00465047f;
     float tanSunAngularRadius = (m_cSunSizeMultiplier * sunRadius) / sunHorizonCoordinates.z;
 
     glm::dvec3 moonHorizonCoordinates = m_astronomicalPositioning.GetMoonHorizonCoordinates();
-    glm::vec2 moonHorizonCos = glm::cos(moonHorizonCoordinates);
-    glm::vec2 moonHorizonSin = glm::sin(moonHorizonCoordinates);
-    glm::vec3 moonHorizonDirection = glm::vec3(moonHorizonCos.y * moonHorizonCos.x, moonHorizonCos.y * moonHorizonSin.x, moonHorizonSin.y);
-    glm::vec3 moonWorldDirection = glm::vec3(horizonToWorld * glm::vec4(moonHorizonDirection, 0.0));
+    glm::vec3 moonWorldDirection = glm::vec3(transforms.worldFromHorizon * HorizonDirection(moonHorizonCoordinates));
     constexpr float moonRadius = 0.00001163f;
     float tanMoonAngularRadius = (m_cMoonSizeMultiplier * moonRadius) / moonHorizonCoordinates.z;
 
-    glDisable(GL_DEPTH_TEST);
+    UpdateFrameUniforms(camera, sunWorldDirection, moonWorldDirection);
+    UpdateAtmosphereSources(tanSunAngularRadius, tanMoonAngularRadius);
+
+    if (m_skyViewLutComparisonRequested)
+    {
+        m_skyViewLutError = CompareSkyViewLut();
+        m_skyViewLutComparisonRequested = false;
+    }
+
+    int numSkyCubemapFaces = 0;
+    if (m_cSkyCubemapEnable) numSkyCubemapFaces = UpdateSkyCubemapState(camera.GetPosition(), sunWorldDirection, moonWorldDirection);
+    else m_skyCubemapValid = false; // Rendered again entirely when enabled
+
+    // Only needed by the faces of the sky cubemap rendered in this frame, if it is enabled
+    if (m_cSkyViewLutEnable && (!m_cSkyCubemapEnable || numSkyCubemapFaces > 0))
+    {
+        Profiler::Scope scope(profiler, "Sky View LUT");
+        RenderSkyViewLut();
+    }
+
+    if (numSkyCubemapFaces > 0)
     {
-        RenderSky(camera, sunWorldDirection, moonWorldDirection);
-        RenderSun(camera, sunWorldDirection, moonWorldDirection, tanSunAngularRadius);
-        RenderMoon(camera, sunWorldDirection, moonWorldDirection, tanMoonAngularRadius);
+        Profiler::Scope scope(profiler, "Sky Cubemap");
+        RenderSkyCubemapFaces(numSkyCubemapFaces);
     }
-    glEnable(GL_DEPTH_TEST);
 
-    RenderScene(camera, sunWorldDirection, moonWorldDirection);
-    if (m_cArtificialLightEnable) RenderLight(camera);
+    auto renderSkySunAndMoon = [&]()
+    {
+        { Profiler::Scope scope(profiler, "Sky"); RenderSky(); }
+        { Profiler::Scope scope(profiler, "Sun"); RenderSun(camera, sunWorldDirection, tanSunAngularRadius); }
+        { Profiler::Scope scope(profiler, "Moon"); RenderMoon(camera, moonWorldDirection, tanMoonAngularRadius); }
+    };
+
+    auto renderOpaqueGeometry = [&]()
+    {
+        { Profiler::Scope scope(profiler, "Scene"); RenderScene(); }
+        if (m_cArtificialLightEnable)
+        {
+            Profiler::Scope scope(profiler, "Light");
+            RenderLight();
+        }
+    };
+
+    if (m_cSceneFirstEnable)
+    {
+        // The sky, sun and moon are at the far plane, so they are only shaded where no geometry is visible (early depth test)
+        renderOpaqueGeometry();
+
+        GLint previousDepthFunc;
+        glGetIntegerv(GL_DEPTH_FUNC, &previousDepthFunc);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+        renderSkySunAndMoon();
+        glDepthMask(GL_TRUE);
+        glDepthFunc(previousDepthFunc);
+    }
+    else
+    {
+        glDisable(GL_DEPTH_TEST);
+        renderSkySunAndMoon();
+        glEnable(GL_DEPTH_TEST);
+
+        renderOpaqueGeometry();
+    }
 }
 
-void PhysicalSky::RenderSun(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection, float tanSunAngularRadius)
+// Written once per frame, instead of setting the same uniforms in every program
+void PhysicalSky::UpdateFrameUniforms(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection)
+{
+    FrameUniforms frameUniforms;
+    frameUniforms.view = camera.GetViewMatrix();
+    frameUniforms.projection = camera.GetProjectionMatrix();
+    frameUniforms.worldFromView = camera.GetWorldFromViewMatrix();
+    frameUniforms.viewFromClip = camera.GetViewFromClipMatrix();
+    frameUniforms.cameraPosition = glm::vec4(camera.GetPosition(), 1.0f);
+    frameUniforms.earthCenterPosition = glm::vec4(0.0f, -m_cPlanetRadius, 0.0f, 1.0f);
+    frameUniforms.sunDirection = glm::vec4(sunWorldDirection, 0.0f);
+    frameUniforms.moonDirection = glm::vec4(moonWorldDirection, 0.0f);
+    const AstronomicalPositioning::Transforms& transforms = m_astronomicalPositioning.GetTransforms();
+    frameUniforms.equatorialFromWorld = glm::mat4(glm::mat3(glm::transpose(transforms.worldFromEquatorial)));
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frameUniforms);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kFrameUniformsBinding, m_frameUniformBuffer);
+    Profiler::CountGlCalls(3);
+}
+
+void PhysicalSky::RenderSun(const Camera& camera, const glm::vec3& sunWorldDirection, float tanSunAngularRadius)
 {
     m_sunShader.Use();
-    m_solarModel->SetProgramUniforms(m_sunShader.m_id, 0, 1, 2, 3);
-    m_lunarModel->SetProgramUniforms(m_sunShader.m_id, 4, 5, 6, 7);
 
     glm::mat4 sunBillboardModel = BillboardModelFromCamera(camera.GetPosition(), sunWorldDirection);
     glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(tanSunAngularRadius));
 
     m_sunShader.SetMat4("Model", sunBillboardModel * scale);
-    m_sunShader.SetMat4("View", camera.GetViewMatrix());
-    m_sunShader.SetMat4("Projection", camera.GetProjectionMatrix());
-
-    m_sunShader.SetVec3("w_CameraPos", camera.GetPosition());
-    m_sunShader.SetVec3("w_EarthCenterPos", glm::vec3(0.0f, -m_cPlanetRadius, 0.0f));
-    m_sunShader.SetVec3("w_SunDir", sunWorldDirection);
-    m_sunShader.SetVec3("w_MoonDir", moonWorldDirection);
 
     m_sunShader.SetInt("LimbDarkeningAlgorithm", static_cast<int>(m_cSunLimbDarkeningAlgorithm));
 
     m_fullScreenQuadMesh.Render();
 }
 
-void PhysicalSky::RenderMoon(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection, float tanMoonAngularRadius)
+void PhysicalSky::RenderMoon(const Camera& camera, const glm::vec3& moonWorldDirection, float tanMoonAngularRadius)
 {
     m_moonShader.Use();
-    m_solarModel->SetProgramUniforms(m_moonShader.m_id, 0, 1, 2, 3);
-    m_lunarModel->SetProgramUniforms(m_moonShader.m_id, 4, 5, 6, 7);
 
     glm::mat4 moonBillboardModel = BillboardModelFromCamera(camera.GetPosition(), moonWorldDirection);
     glm::mat4 moonScale = glm::scale(glm::mat4(1.0f), glm::vec3(tanMoonAngularRadius));
 
     m_moonShader.SetMat4("Model", moonBillboardModel * moonScale);
-    m_moonShader.SetMat4("View", camera.GetViewMatrix());
-    m_moonShader.SetMat4("Projection", camera.GetProjectionMatrix());
 
-    m_moonShader.SetVec3("w_CameraPos", camera.GetPosition());
-    m_moonShader.SetVec3("w_PlanetPos", glm::vec3(0.0f, -m_cPlanetRadius, 0.0f));
-    m_moonShader.SetVec3("w_SunDir", sunWorldDirection);
-    m_moonShader.SetVec3("w_MoonDir", moonWorldDirection);
     m_moonShader.SetVec3("w_EarthDir", -moonWorldDirection);
 
     double earthshineIrradiance = ComputeEarthshineIrradiance();
@@ -537,47 +1035,215 @@ void PhysicalSky::RenderMoon(const Camera& camera, const glm::vec3& sunWorldDire
     m_fullScreenQuadMesh.Render();
 }
 
-void PhysicalSky::RenderSky(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection)
+// Renders the atmosphere around the camera into the sky-view LUT, which is then sampled by RenderSky
+void PhysicalSky::RenderSkyViewLut()
 {
-    m_skyShader.Use();
-    m_solarModel->SetProgramUniforms(m_skyShader.m_id, 0, 1, 2, 3);
-    m_lunarModel->SetProgramUniforms(m_skyShader.m_id, 4, 5, 6, 7);
+    GLint viewportData[4];
+    glGetIntegerv(GL_VIEWPORT, viewportData);
+    GLint drawFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
 
-    m_skyShader.SetMat4("WorldFromView", camera.GetWorldFromViewMatrix());
-    m_skyShader.SetMat4("ViewFromClip", camera.GetViewFromClipMatrix());
+    glBindFramebuffer(GL_FRAMEBUFFER, m_skyViewLutFramebuffer);
+    glViewport(0, 0, kSkyViewLutWidth, kSkyViewLutHeight);
+    Profiler::CountGlCalls(4);
 
-    m_skyShader.SetVec3("w_CameraPos", camera.GetPosition());
-    m_skyShader.SetVec3("w_EarthCenterPos", glm::vec3(0.0f, -m_cPlanetRadius, 0.0f));
-    m_skyShader.SetVec3("w_SunDir", sunWorldDirection);
-    m_skyShader.SetVec3("w_MoonDir", moonWorldDirection);
+    m_skyViewLutShader.Use();
+    m_skyViewLutShader.SetFloat("BottomRadius", m_cPlanetRadius);
+    m_fullScreenQuadMesh.Render();
 
-    m_skyShader.SetTexture("StarsMap", 8, m_skyStarsMap);
-    m_skyShader.SetFloat("StarsMapMultiplier", glm::pow(10.0f, m_cSkyStarsMapMultiplier));
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    glViewport(viewportData[0], viewportData[1], viewportData[2], viewportData[3]);
+    Profiler::CountGlCalls(2);
+}
 
-    m_skyShader.SetTexture("MilkywayMap", 9, m_skyMilkywayMap);
-    m_skyShader.SetFloat("MilkywayMapMultiplier", glm::pow(10.0f, m_cSkyMilkywayMapMultiplier));
+// Per pixel, or from the sky cubemap
+void PhysicalSky::RenderSky()
+{
+    if (m_cSkyCubemapEnable)
+    {
+        m_skyCachedShader.Use();
+        m_fullScreenQuadMesh.Render();
+        return;
+    }
 
-    m_skyShader.SetFloat("lon", m_astronomicalPositioning.GetLon());
-    m_skyShader.SetFloat("lat", m_astronomicalPositioning.GetLat());
-    m_skyShader.SetFloat("T", m_astronomicalPositioning.GetT());
+    m_skyShader.Use();
+    SetSkyUniforms(m_skyShader);
 
     m_fullScreenQuadMesh.Render();
 }
 
-void PhysicalSky::RenderScene(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection)
+// Uniforms of sky.frag, besides the atmosphere textures
+void PhysicalSky::SetSkyUniforms(ShaderProgram& program)
+{
+    program.SetBool("UseSkyViewLut", m_cSkyViewLutEnable);
+    program.SetFloat("BottomRadius", m_cPlanetRadius);
+
+    program.SetTexture("StarsMap", 8, m_skyStarsMap);
+    program.SetFloat("StarsMapMultiplier", glm::pow(10.0f, m_cSkyStarsMapMultiplier));
+
+    program.SetTexture("MilkywayMap", 9, m_skyMilkywayMap);
+    program.SetFloat("MilkywayMapMultiplier", glm::pow(10.0f, m_cSkyMilkywayMapMultiplier));
+}
+
+// Returns the number of faces of the sky cubemap to render in this frame: all of them when the sky changed, and at most
+// m_cSkyCubemapFacesPerFrame of the ones older than the current time (oldest first) when it is only animated by the time
+int PhysicalSky::UpdateSkyCubemapState(const glm::vec3& cameraPosition, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection)
+{
+    SkyCubemapKey key;
+    key.cameraPosition = cameraPosition;
+    key.starsMapMultiplier = m_cSkyStarsMapMultiplier;
+    key.milkywayMapMultiplier = m_cSkyMilkywayMapMultiplier;
+    key.lon = static_cast<float>(m_astronomicalPositioning.GetLon());
+    key.lat = static_cast<float>(m_astronomicalPositioning.GetLat());
+    key.skyViewLutEnable = m_cSkyViewLutEnable;
+    key.sunIrradiance = m_cSunIrradiance;
+    key.sunSizeMultiplier = m_cSunSizeMultiplier;
+    key.moonSizeMultiplier = m_cMoonSizeMultiplier;
+    key.sunDirection = sunWorldDirection;
+    key.moonDirection = moonWorldDirection;
+    key.T = static_cast<float>(m_astronomicalPositioning.GetT());
+
+    bool skyChanged = !m_skyCubemapValid;
+    skyChanged |= glm::distance(key.cameraPosition, m_skyCubemapKey.cameraPosition) > kSkyCubemapPositionTolerance;
+    skyChanged |= key.starsMapMultiplier != m_skyCubemapKey.starsMapMultiplier;
+    skyChanged |= key.milkywayMapMultiplier != m_skyCubemapKey.milkywayMapMultiplier;
+    skyChanged |= key.lon != m_skyCubemapKey.lon;
+    skyChanged |= key.lat != m_skyCubemapKey.lat;
+    skyChanged |= key.skyViewLutEnable != m_skyCubemapKey.skyViewLutEnable;
+    skyChanged |= key.sunIrradiance != m_skyCubemapKey.sunIrradiance;
+    skyChanged |= key.sunSizeMultiplier != m_skyCubemapKey.sunSizeMultiplier;
+    skyChanged |= key.moonSizeMultiplier != m_skyCubemapKey.moonSizeMultiplier;
+    if (skyChanged)
+    {
+        m_skyCubemapKey = key;
+        m_skyCubemapValid = true;
+        m_skyCubemapStaleFaces = 0;
+        ++m_skyCubemapFullUpdates;
+        return 6;
+    }
+
+    bool timeChanged = false;
+    timeChanged |= key.sunDirection != m_skyCubemapKey.sunDirection;
+    timeChanged |= key.moonDirection != m_skyCubemapKey.moonDirection;
+    timeChanged |= key.T != m_skyCubemapKey.T;
+    if (timeChanged)
+    {
+        // The reference camera position is kept, so that small movements do not accumulate
+        m_skyCubemapKey.sunDirection = key.sunDirection;
+        m_skyCubemapKey.moonDirection = key.moonDirection;
+        m_skyCubemapKey.T = key.T;
+        m_skyCubemapStaleFaces = 6;
+    }
+
+    int numFaces = glm::min(m_cSkyCubemapFacesPerFrame, m_skyCubemapStaleFaces);
+    m_skyCubemapStaleFaces -= numFaces;
+    if (numFaces > 0) ++m_skyCubemapPartialUpdates;
+    else ++m_skyCubemapHits;
+    return numFaces;
+}
+
+// Renders sky.frag into the next faces of the cubemap, from the current camera position
+void PhysicalSky::RenderSkyCubemapFaces(int numFaces)
+{
+    GLint viewportData[4];
+    glGetIntegerv(GL_VIEWPORT, viewportData);
+    GLint drawFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_skyCubemapFramebuffer);
+    glViewport(0, 0, kSkyCubemapSize, kSkyCubemapSize);
+    Profiler::CountGlCalls(4);
+
+    m_skyCubemapShader.Use();
+    SetSkyUniforms(m_skyCubemapShader);
+    for (int i = 0; i < numFaces; ++i)
+    {
+        int face = m_skyCubemapNextFace;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_skyCubemapTexture, 0);
+        Profiler::CountGlCalls(1);
+        m_skyCubemapShader.SetMat3("WorldFromFace", kWorldFromCubemapFace[face]);
+        m_fullScreenQuadMesh.Render();
+        m_skyCubemapNextFace = (face + 1) % 6;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    glViewport(viewportData[0], viewportData[1], viewportData[2], viewportData[3]);
+    Profiler::CountGlCalls(2);
+}
+
+// Renders the sky with and without the sky-view LUT (at the current viewport size) and compares both images
+PhysicalSky::SkyViewLutError PhysicalSky::CompareSkyViewLut()
+{
+    GLint viewportData[4];
+    glGetIntegerv(GL_VIEWPORT, viewportData);
+    GLint drawFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+    int width = viewportData[2];
+    int height = viewportData[3];
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glViewport(0, 0, width, height);
+
+    std::vector<float> images[2]; // With and without the sky-view LUT
+    bool skyViewLutEnable = m_cSkyViewLutEnable;
+    bool skyCubemapEnable = m_cSkyCubemapEnable;
+    m_cSkyCubemapEnable = false;
+    for (int i = 0; i < 2; ++i)
+    {
+        m_cSkyViewLutEnable = i == 0;
+        if (m_cSkyViewLutEnable) RenderSkyViewLut();
+        RenderSky();
+        images[i].resize(static_cast<std::size_t>(width) * height * 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_FLOAT, images[i].data());
+    }
+    m_cSkyViewLutEnable = skyViewLutEnable;
+    m_cSkyCubemapEnable = skyCubemapEnable;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+    glViewport(viewportData[0], viewportData[1], viewportData[2], viewportData[3]);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+
+    double maxReference = 0.0;
+    for (std::size_t i = 0; i < images[1].size(); i += 4)
+        for (int c = 0; c < 3; ++c) maxReference = glm::max(maxReference, static_cast<double>(images[1][i + c]));
+
+    SkyViewLutError error = {};
+    double squaredError = 0.0;
+    double squaredReference = 0.0;
+    std::size_t numValues = 0;
+    for (std::size_t i = 0; i < images[1].size(); i += 4)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            double value = images[0][i + c];
+            double reference = images[1][i + c];
+            squaredError += (value - reference) * (value - reference);
+            squaredReference += reference * reference;
+            if (reference > 1e-4 * maxReference) error.maxRelativeError = glm::max(error.maxRelativeError, glm::abs(value - reference) / reference);
+            ++numValues;
+        }
+    }
+    if (numValues == 0) return error;
+
+    error.valid = true;
+    error.rmsError = glm::sqrt(squaredError / numValues);
+    error.relativeRmsError = squaredReference > 0.0 ? glm::sqrt(squaredError / squaredReference) : 0.0;
+    return error;
+}
+
+void PhysicalSky::RenderScene()
 {
     m_meshShader.Use();
-    m_solarModel->SetProgramUniforms(m_meshShader.m_id, 0, 1, 2, 3);
-    m_lunarModel->SetProgramUniforms(m_meshShader.m_id, 4, 5, 6, 7);
 
     m_meshShader.SetMat4("Model", glm::scale(glm::mat4(1.0f), glm::vec3(1e-3f)));
-    m_meshShader.SetMat4("View", camera.GetViewMatrix());
-    m_meshShader.SetMat4("Projection", camera.GetProjectionMatrix());
-
-    m_meshShader.SetVec3("w_CameraPos", camera.GetPosition());
-    m_meshShader.SetVec3("w_EarthCenterPos", glm::vec3(0.0f, -m_cPlanetRadius, 0.0f));
-    m_meshShader.SetVec3("w_SunDir", sunWorldDirection);
-    m_meshShader.SetVec3("w_MoonDir", moonWorldDirection);
 
     m_meshShader.SetVec3("w_LightPos", m_cArtificialLightPos / 1000.0f);
     m_meshShader.SetVec3("LightRadiantIntensity", glm::vec3(1.0f) * (m_cArtificialLightRadiantIntensity / 3.0f));
@@ -589,7 +1255,7 @@ void PhysicalSky::RenderScene(const Camera& camera, const glm::vec3& sunWorldDir
     m_groundMesh.Render();
 }
 
-void PhysicalSky::RenderLight(const Camera& camera)
+void PhysicalSky::RenderLight()
 {
     m_lightShader.Use();
 
@@ -598,8 +1264,6 @@ void PhysicalSky::RenderLight(const Camera& camera)
     model = glm::translate(model, m_cArtificialLightPos);
     model = glm::scale(model, glm::vec3(0.2f));
     m_lightShader.SetMat4("Model", model);
-    m_lightShader.SetMat4("View", camera.GetViewMatrix());
-    m_lightShader.SetMat4("Projection", camera.GetProjectionMatrix());
 
     m_bulbMesh.Render();
 }
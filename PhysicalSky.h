@@ -5,38 +5,140 @@
 #include "AstronomicalPositioning.h"
 #include "Texture.h"
 #include "Mesh.h"
+#include "LutCache.h"
+#include "AtmospherePrecomputer.h"
+#include "CpuReference.h"
+#include "Profiler.h"
 
 #include <glm/glm.hpp>
 
 #include <atmosphere/model.h>
 
+#include <array>
+#include <cstdint>
+#include <string>
+
 class PhysicalSky
 {
 public:
-    PhysicalSky();
-    ~PhysicalSky() = default;
+    // Of the sky rendered with the sky-view LUT, with respect to the per-pixel evaluation of the atmosphere
+    struct SkyViewLutError
+    {
+        bool valid;
+        double rmsError; // W*m^-2*sr^-1
+        double relativeRmsError; // RMS error divided by the RMS reference radiance
+        double maxRelativeError; // Of the pixels whose reference radiance is not negligible
+    };
+private:
+    // The settings which the models depend on, in the units of the UI
+    struct ModelSettings
+    {
+        float planetRadius; // km
+        float atmosphereHeight; // km
+        glm::vec3 groundAlbedo; // unitless
+        float rayleighScatteringScale; // km^-1
+        glm::vec3 rayleighScatteringCoefficient; // unitless
+        float rayleighExponentialDistribution; // km
+        float mieScatteringScale; // km^-1
+        glm::vec3 mieScatteringCoefficient; // unitless
+        float mieAbsorptionScale; // km^-1
+        glm::vec3 mieAbsorptionCoefficient; // unitless
+        float miePhaseFunctionG; // unitless
+        float mieExponentialDistribution; // km
+        float ozoneAbsorptionScale; // km^-1
+        glm::vec3 ozoneAbsorptionCoefficient; // unitless
+        bool sharedPrecomputation;
+        bool computeShaderPrecomputation;
+        atmosphere::TextureResolutionTier textureResolutionTier;
+        bool combinedScatteringTextures;
+        atmosphere::ScatteringTextureFormat scatteringTextureFormat;
+        int numScatteringOrders;
+        bool adaptiveScatteringOrders;
+        float scatteringOrdersTolerance; // unitless
+        unsigned int adaptiveQuadraturePasses;
+    };
+
+    static const ModelSettings kDefaultModelSettings; // Also the defaults of the UI
+    static ModelParameters ComputeModelParameters(const ModelSettings& settings);
+public:
+    PhysicalSky(GLFWwindow* sharedContextWindow, const std::string& lutCacheDirectory);
+    ~PhysicalSky();
     void Init();
     void MakeDefaultParametersNew();
     void MakeNewParametersCurrent();
     void InitResources();
     void InitShaders();
     void InitModel();
-    void Update();
-    void Render(const Camera& camera);
+    void Update(float deltaTime);
+    void Render(const Camera& camera, Profiler& profiler);
+    bool SetParameter(const std::string& name, double value);
+    void ApplyParameters();
+    double GetPrecomputationTime() const;
+    static ModelParameters GetDefaultModelParameters();
+    AstronomicalPositioning& GetAstronomicalPositioning() { return m_astronomicalPositioning; }
+    void RequestSkyViewLutComparison() { m_skyViewLutComparisonRequested = true; } // Done at the next Render
+    const SkyViewLutError& GetSkyViewLutError() const { return m_skyViewLutError; }
 private:
     bool AnyChange();
     void ResetDefaults();
+    ModelParameters ComputeModelParameters();
+    void RequestModel();
+    void OnModelChanged();
+    void LinkAtmospherePrograms();
+    void BindAtmosphereTextures();
+    std::array<ShaderProgram*, 6> GetAtmospherePrograms();
+    void UpdateAtmosphereSources(float tanSunAngularRadius, float tanMoonAngularRadius);
     glm::dvec3 ComputeMoonIrradiance();
     static glm::mat4 BillboardModelFromCamera(const glm::vec3& cameraPosition, const glm::vec3& billboardDirection);
-    void RenderSun(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection, float tanSunAngularRadius);
-    void RenderMoon(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection, float tanMoonAngularRadius);
-    void RenderSky(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection);
-    void RenderScene(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection);
-    void RenderLight(const Camera& camera);
+    void RenderSun(const Camera& camera, const glm::vec3& sunWorldDirection, float tanSunAngularRadius);
+    void RenderMoon(const Camera& camera, const glm::vec3& moonWorldDirection, float tanMoonAngularRadius);
+    void RenderSkyViewLut();
+    int UpdateSkyCubemapState(const glm::vec3& cameraPosition, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection);
+    void RenderSkyCubemapFaces(int numFaces);
+    void SetSkyUniforms(ShaderProgram& program);
+    void RenderSky();
+    SkyViewLutError CompareSkyViewLut();
+    void RenderScene();
+    void RenderLight();
+    void UpdateFrameUniforms(const Camera& camera, const glm::vec3& sunWorldDirection, const glm::vec3& moonWorldDirection);
     static double VisibleLitFractionFromPhaseAngle(double phi);
     double ComputeEarthshineIrradiance();
 private:
     enum class SunLimbDarkeningAlgorithm {NONE, NEC96, HM98};
+
+    // std140 layout of the FrameUniforms block (see frame_uniforms.glsl)
+    struct FrameUniforms
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 worldFromView;
+        glm::mat4 viewFromClip;
+        glm::vec4 cameraPosition; // w unused
+        glm::vec4 earthCenterPosition; // w unused
+        glm::vec4 sunDirection; // w unused
+        glm::vec4 moonDirection; // w unused
+        glm::mat4 equatorialFromWorld; // Rotations, from the double precision ones of AstronomicalPositioning::Transforms
+    };
+
+    // Inputs of the sky cached in the cubemap, besides the models
+    struct SkyCubemapKey
+    {
+        glm::vec3 cameraPosition;
+        float starsMapMultiplier;
+        float milkywayMapMultiplier;
+        float lon;
+        float lat;
+        bool skyViewLutEnable;
+        // Of the sources, see UpdateAtmosphereSources (the other inputs of their irradiances and radii are animated by the time)
+        float sunIrradiance;
+        float sunSizeMultiplier;
+        float moonSizeMultiplier;
+
+        // Animated by the time, the faces are then updated progressively
+        glm::vec3 sunDirection;
+        glm::vec3 moonDirection;
+        float T;
+    };
 private:
     std::unique_ptr<atmosphere::Model> m_solarModel;
     std::unique_ptr<atmosphere::Model> m_lunarModel;
@@ -64,11 +166,9 @@ private:
     ShaderProgram m_sunShader;
 
     float m_dSunSizeMultiplier;
-    float m_nSunSizeMultiplier;
     float m_cSunSizeMultiplier;
 
     float m_dSunIrradiance;
-    float m_nSunIrradiance;
     float m_cSunIrradiance;
 
     SunLimbDarkeningAlgorithm m_dSunLimbDarkeningAlgorithm;
@@ -78,7 +178,6 @@ private:
     ShaderProgram m_moonShader;
 
     float m_dMoonSizeMultiplier;
-    float m_nMoonSizeMultiplier;
     float m_cMoonSizeMultiplier;
 
     bool m_cMoonEarthshineEnable;
@@ -103,6 +202,40 @@ private:
     float m_dSkyMilkywayMapMultiplier;
     float m_cSkyMilkywayMapMultiplier;
 
+    ShaderProgram m_skyViewLutShader;
+    bool m_dSkyViewLutEnable;
+    bool m_cSkyViewLutEnable;
+    GLuint m_skyViewLutFramebuffer;
+    GLuint m_skyViewLutTexture;
+    bool m_skyViewLutComparisonRequested;
+    SkyViewLutError m_skyViewLutError;
+
+    ShaderProgram m_skyCubemapShader; // Renders the faces of the cubemap
+    ShaderProgram m_skyCachedShader; // Samples the cubemap
+    bool m_dSkyCubemapEnable;
+    bool m_cSkyCubemapEnable;
+    int m_dSkyCubemapFacesPerFrame;
+    int m_cSkyCubemapFacesPerFrame;
+    GLuint m_skyCubemapFramebuffer;
+    GLuint m_skyCubemapTexture;
+    bool m_skyCubemapValid;
+    SkyCubemapKey m_skyCubemapKey;
+    int m_skyCubemapStaleFaces;
+    int m_skyCubemapNextFace;
+    unsigned int m_skyCubemapHits; // Frames without any face rendered
+    unsigned int m_skyCubemapPartialUpdates;
+    unsigned int m_skyCubemapFullUpdates;
+
+    bool m_dSceneFirstEnable; // Opaque geometry before the sky, sun and moon
+    bool m_cSceneFirstEnable;
+
+    // Irradiance and angular radius of the sun and moon last set to the atmosphere programs (the models are precomputed for a unit irradiance)
+    bool m_atmosphereSourcesValid;
+    glm::dvec3 m_sunSourceIrradiance;
+    double m_sunSourceAngularRadius;
+    glm::dvec3 m_moonSourceIrradiance;
+    double m_moonSourceAngularRadius;
+
     // ARTIFICIAL LIGHT
     ShaderProgram m_lightShader;
     Mesh m_bulbMesh;
@@ -163,7 +296,63 @@ private:
     glm::vec3 m_nOzoneAbsorptionCoefficient;
     glm::vec3 m_cOzoneAbsorptionCoefficient;
 
+    // PRECOMPUTATION
+    bool m_dSharedPrecomputationEnable;
+    bool m_nSharedPrecomputationEnable;
+    bool m_cSharedPrecomputationEnable;
+
+    bool m_dComputeShaderPrecomputationEnable;
+    bool m_nComputeShaderPrecomputationEnable;
+    bool m_cComputeShaderPrecomputationEnable;
+
+    atmosphere::TextureResolutionTier m_dTextureResolutionTier;
+    atmosphere::TextureResolutionTier m_nTextureResolutionTier;
+    atmosphere::TextureResolutionTier m_cTextureResolutionTier;
+    bool m_dCombinedScatteringTexturesEnable;
+    bool m_nCombinedScatteringTexturesEnable;
+    bool m_cCombinedScatteringTexturesEnable;
+    atmosphere::ScatteringTextureFormat m_dScatteringTextureFormat;
+    atmosphere::ScatteringTextureFormat m_nScatteringTextureFormat;
+    atmosphere::ScatteringTextureFormat m_cScatteringTextureFormat;
+
+    int m_dNumScatteringOrders;
+    int m_nNumScatteringOrders;
+    int m_cNumScatteringOrders;
+
+    bool m_dAdaptiveScatteringOrdersEnable;
+    bool m_nAdaptiveScatteringOrdersEnable;
+    bool m_cAdaptiveScatteringOrdersEnable;
+
+    float m_dScatteringOrdersTolerance;
+    float m_nScatteringOrdersTolerance;
+    float m_cScatteringOrdersTolerance;
+
+    unsigned int m_dAdaptiveQuadraturePasses;
+    unsigned int m_nAdaptiveQuadraturePasses;
+    unsigned int m_cAdaptiveQuadraturePasses;
+
+    bool m_dAutoRecomputeEnable;
+    bool m_cAutoRecomputeEnable;
+
     // OTHERS
+    // Compiled once by InitShaders, and linked with the atmosphere shader by LinkAtmospherePrograms
+    ShaderStage m_skyVertexShader;
+    ShaderStage m_skyFragmentShader;
+    ShaderStage m_skyViewLutVertexShader;
+    ShaderStage m_skyViewLutFragmentShader;
+    ShaderStage m_skyCubemapVertexShader;
+    ShaderStage m_sunVertexShader;
+    ShaderStage m_sunFragmentShader;
+    ShaderStage m_moonVertexShader;
+    ShaderStage m_moonFragmentShader;
+    ShaderStage m_meshVertexShader;
+    ShaderStage m_meshFragmentShader;
+    std::uint64_t m_atmosphereShaderHash; // Of the atmosphere shader the programs are linked with, 0 if none
+    GLuint m_frameUniformBuffer;
+    LutCache m_lutCache;
+    std::unique_ptr<AtmospherePrecomputer> m_precomputer;
+    ModelParameters m_requestedModelParameters;
+    CpuReference m_cpuReference;
     bool m_notAppliedChanges;
     Mesh m_mesh;
     Mesh m_groundMesh;
@@ -0,0 +1,324 @@
+#include "Profiler.h"
+#include "ImGuiNfd.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    struct PassStatistics
+    {
+        const char* name;
+        double cpuMillisecondsSum;
+        double gpuMillisecondsSum;
+        double gpuMillisecondsMax;
+        double glCallsSum;
+        std::vector<float> gpuMilliseconds;
+    };
+
+    std::vector<PassStatistics> ComputePassStatistics(const std::deque<Profiler::FrameRecord>& history)
+    {
+        std::vector<PassStatistics> statistics;
+        for (const Profiler::FrameRecord& frame : history)
+        {
+            for (const Profiler::ScopeRecord& scope : frame.scopes)
+            {
+                auto it = std::find_if(statistics.begin(), statistics.end(), [&](const PassStatistics& pass) { return std::strcmp(pass.name, scope.name) == 0; });
+                if (it == statistics.end())
+                {
+                    statistics.push_back({scope.name, 0.0, 0.0, 0.0, 0.0, {}});
+                    it = statistics.end() - 1;
+                }
+                it->cpuMillisecondsSum += scope.cpuMilliseconds;
+                it->gpuMillisecondsSum += scope.gpuMilliseconds;
+                it->gpuMillisecondsMax = std::max(it->gpuMillisecondsMax, scope.gpuMilliseconds);
+                it->glCallsSum += scope.glCalls;
+                it->gpuMilliseconds.push_back(static_cast<float>(scope.gpuMilliseconds));
+            }
+        }
+        return statistics;
+    }
+
+    double Milliseconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+Profiler::Scope::Scope(Profiler& profiler, const char* name)
+    : m_profiler(profiler)
+    , m_index(profiler.m_inFrame ? profiler.BeginScope(name) : -1)
+{
+}
+
+Profiler::Scope::~Scope()
+{
+    if (m_index >= 0) m_profiler.EndScope(m_index);
+}
+
+Profiler::Profiler()
+    : m_enabled(false)
+    , m_waitForResults(false)
+    , m_inFrame(false)
+    , m_inScope(false)
+    , m_frame(0)
+    , m_slot(0)
+    , m_pendingFrames()
+    , m_scopeStartGlCalls(0)
+    , m_history()
+    , m_historySize(kHistorySize)
+    , m_droppedFrames(0)
+{
+    glGenQueries(kFrameLatency * kMaxScopes, &m_queries[0][0]);
+}
+
+Profiler::~Profiler()
+{
+    glDeleteQueries(kFrameLatency * kMaxScopes, &m_queries[0][0]);
+}
+
+void Profiler::BeginFrame()
+{
+    if (!m_enabled) return;
+
+    m_slot = static_cast<int>(m_frame % kFrameLatency);
+    if (m_pendingFrames[m_slot].pending) ReadBack(m_slot);
+
+    PendingFrame& pendingFrame = m_pendingFrames[m_slot];
+    pendingFrame.frame = m_frame;
+    pendingFrame.numScopes = 0;
+    m_inFrame = true;
+    m_frameStart = Clock::now();
+}
+
+void Profiler::EndFrame()
+{
+    if (!m_inFrame) return;
+
+    PendingFrame& pendingFrame = m_pendingFrames[m_slot];
+    pendingFrame.frameCpuMilliseconds = Milliseconds(Clock::now() - m_frameStart);
+    pendingFrame.pending = true;
+    m_inFrame = false;
+    ++m_frame;
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+    if (enabled == m_enabled) return;
+    m_enabled = enabled;
+
+    // Results of frames still in flight are discarded, and the current frame (if any) is not measured
+    for (PendingFrame& pendingFrame : m_pendingFrames) pendingFrame.pending = false;
+    m_inFrame = false;
+}
+
+void Profiler::SetHistorySize(std::size_t historySize)
+{
+    m_historySize = historySize;
+    while (m_history.size() > m_historySize) m_history.pop_front();
+}
+
+void Profiler::SetWaitForResults(bool waitForResults)
+{
+    m_waitForResults = waitForResults;
+}
+
+void Profiler::Flush()
+{
+    glFinish();
+    for (int i = 0; i < kFrameLatency; ++i)
+    {
+        int slot = static_cast<int>((m_frame + i) % kFrameLatency); // Oldest frame first
+        if (m_pendingFrames[slot].pending) ReadBack(slot);
+    }
+}
+
+int Profiler::BeginScope(const char* name)
+{
+    PendingFrame& pendingFrame = m_pendingFrames[m_slot];
+    if (m_inScope || pendingFrame.numScopes == kMaxScopes) return -1;
+
+    int index = pendingFrame.numScopes++;
+    pendingFrame.names[index] = name;
+    m_inScope = true;
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_slot][index]);
+    m_scopeStart = Clock::now();
+    m_scopeStartGlCalls = s_numGlCalls;
+    return index;
+}
+
+void Profiler::EndScope(int index)
+{
+    m_pendingFrames[m_slot].scopeCpuMilliseconds[index] = Milliseconds(Clock::now() - m_scopeStart);
+    m_pendingFrames[m_slot].scopeGlCalls[index] = static_cast<unsigned int>(s_numGlCalls - m_scopeStartGlCalls);
+    glEndQuery(GL_TIME_ELAPSED);
+    m_inScope = false;
+}
+
+void Profiler::ReadBack(int slot)
+{
+    PendingFrame& pendingFrame = m_pendingFrames[slot];
+    pendingFrame.pending = false;
+
+    // Queries complete in order, so if the last one is available all the others are too
+    if (pendingFrame.numScopes > 0 && !m_waitForResults)
+    {
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(m_queries[slot][pendingFrame.numScopes - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            ++m_droppedFrames;
+            return;
+        }
+    }
+
+    FrameRecord frame;
+    frame.frame = pendingFrame.frame;
+    frame.cpuMilliseconds = pendingFrame.frameCpuMilliseconds;
+    frame.scopes.reserve(pendingFrame.numScopes);
+    for (int i = 0; i < pendingFrame.numScopes; ++i)
+    {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(m_queries[slot][i], GL_QUERY_RESULT, &nanoseconds);
+        frame.scopes.push_back({pendingFrame.names[i], pendingFrame.scopeCpuMilliseconds[i], static_cast<double>(nanoseconds) * 1e-6, pendingFrame.scopeGlCalls[i]});
+    }
+
+    m_history.push_back(std::move(frame));
+    if (m_history.size() > m_historySize) m_history.pop_front();
+}
+
+void Profiler::ShowWindow()
+{
+    if (ImGui::Begin("Profiler"))
+    {
+        bool enabled = m_enabled;
+        if (ImGui::Checkbox("Enabled", &enabled)) SetEnabled(enabled);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear"))
+        {
+            m_history.clear();
+            m_droppedFrames = 0;
+        }
+
+        ImGui::Text("%zu Frames Recorded, %u Dropped (GPU more than %d frames behind)", m_history.size(), m_droppedFrames, kFrameLatency);
+
+        if (!m_history.empty())
+        {
+            const FrameRecord& lastFrame = m_history.back();
+            std::vector<PassStatistics> statistics = ComputePassStatistics(m_history);
+            auto passColor = [&](std::size_t pass) { return ImColor::HSV(static_cast<float>(pass) / static_cast<float>(statistics.size()), 0.6f, 0.8f); };
+
+            // Timeline of the last frame: the GPU time of each pass, one after the other
+            double lastFrameGpuMilliseconds = 0.0;
+            for (const ScopeRecord& scope : lastFrame.scopes) lastFrameGpuMilliseconds += scope.gpuMilliseconds;
+            ImGui::Text("Frame %llu: CPU %.3f ms, GPU %.3f ms", static_cast<unsigned long long>(lastFrame.frame), lastFrame.cpuMilliseconds, lastFrameGpuMilliseconds);
+
+            ImVec2 timelineSize = ImVec2(ImGui::GetContentRegionAvail().x, 20.0f);
+            ImVec2 timelineStart = ImGui::GetCursorScreenPos();
+            ImDrawList* drawList = ImGui::GetWindowDrawList();
+            drawList->AddRectFilled(timelineStart, ImVec2(timelineStart.x + timelineSize.x, timelineStart.y + timelineSize.y), ImGui::GetColorU32(ImGuiCol_FrameBg));
+            float pixelsPerMillisecond = lastFrameGpuMilliseconds > 0.0 ? timelineSize.x / static_cast<float>(lastFrameGpuMilliseconds) : 0.0f;
+            float x = timelineStart.x;
+            for (const ScopeRecord& scope : lastFrame.scopes)
+            {
+                std::size_t pass = std::find_if(statistics.begin(), statistics.end(), [&](const PassStatistics& other) { return std::strcmp(other.name, scope.name) == 0; }) - statistics.begin();
+                float width = static_cast<float>(scope.gpuMilliseconds) * pixelsPerMillisecond;
+                drawList->AddRectFilled(ImVec2(x, timelineStart.y), ImVec2(x + width, timelineStart.y + timelineSize.y), passColor(pass));
+                x += width;
+            }
+            ImGui::Dummy(timelineSize);
+
+            if (ImGui::BeginTable("Passes", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Pass");
+                ImGui::TableSetupColumn("CPU Avg. (ms)");
+                ImGui::TableSetupColumn("GPU Avg. (ms)");
+                ImGui::TableSetupColumn("GPU Max. (ms)");
+                ImGui::TableSetupColumn("GL Calls");
+                ImGui::TableSetupColumn("GPU History");
+                ImGui::TableHeadersRow();
+                for (std::size_t pass = 0; pass < statistics.size(); ++pass)
+                {
+                    const PassStatistics& passStatistics = statistics[pass];
+                    double count = static_cast<double>(passStatistics.gpuMilliseconds.size());
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::TextColored(passColor(pass), "%s", passStatistics.name);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", passStatistics.cpuMillisecondsSum / count);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", passStatistics.gpuMillisecondsSum / count);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", passStatistics.gpuMillisecondsMax);
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f", passStatistics.glCallsSum / count);
+                    ImGui::TableNextColumn();
+                    ImGui::PushID(static_cast<int>(pass));
+                    ImGui::PlotLines("##GpuHistory", passStatistics.gpuMilliseconds.data(), static_cast<int>(passStatistics.gpuMilliseconds.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 30.0f));
+                    ImGui::PopID();
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        nfdu8filteritem_t csvFilter = { "CSV", "csv" };
+        nfdu8filteritem_t jsonFilter = { "JSON", "json" };
+        if (ImGui::Button("Export CSV..."))
+        {
+            std::string path = ImGuiNfd::Save(&csvFilter, 1, "profile.csv");
+            if (path != "") ExportCsv(path);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Export JSON..."))
+        {
+            std::string path = ImGuiNfd::Save(&jsonFilter, 1, "profile.json");
+            if (path != "") ExportJson(path);
+        }
+    }
+    ImGui::End();
+}
+
+bool Profiler::ExportCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "[Profiler] E: Could not open " << path << " for writing." << std::endl;
+        return false;
+    }
+
+    // One row per pass and frame, plus one row per frame with its whole CPU time
+    file << "frame,pass,cpu_ms,gpu_ms,gl_calls\n";
+    for (const FrameRecord& frame : m_history)
+    {
+        file << frame.frame << ",Frame," << frame.cpuMilliseconds << ",,\n";
+        for (const ScopeRecord& scope : frame.scopes)
+            file << frame.frame << "," << scope.name << "," << scope.cpuMilliseconds << "," << scope.gpuMilliseconds << "," << scope.glCalls << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool Profiler::ExportJson(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "[Profiler] E: Could not open " << path << " for writing." << std::endl;
+        return false;
+    }
+
+    file << "{\n  \"frames\": [";
+    for (std::size_t i = 0; i < m_history.size(); ++i)
+    {
+        const FrameRecord& frame = m_history[i];
+        file << (i > 0 ? ",\n" : "\n") << "    {\"frame\": " << frame.frame << ", \"cpu_ms\": " << frame.cpuMilliseconds << ", \"passes\": [";
+        for (std::size_t j = 0; j < frame.scopes.size(); ++j)
+        {
+            const ScopeRecord& scope = frame.scopes[j];
+            file << (j > 0 ? ", " : "") << "{\"name\": \"" << scope.name << "\", \"cpu_ms\": " << scope.cpuMilliseconds << ", \"gpu_ms\": " << scope.gpuMilliseconds << ", \"gl_calls\": " << scope.glCalls << "}";
+        }
+        file << "]}";
+    }
+    file << "\n  ]\n}\n";
+    return static_cast<bool>(file);
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Measures the CPU and GPU time of the render passes of each frame. The GPU time
+// is measured with GL_TIME_ELAPSED queries kept in a ring buffer of frames, which
+// are only read back kFrameLatency frames later (and dropped if still not
+// available), so that profiling never waits for the GPU. Scopes cannot be nested,
+// and cost a single test when the profiler is disabled. The GL calls reported
+// with CountGlCalls are also counted per scope.
+class Profiler
+{
+public:
+    // Measures the pass from its construction to its destruction
+    class Scope
+    {
+    public:
+        Scope(Profiler& profiler, const char* name);
+        ~Scope();
+    private:
+        Profiler& m_profiler;
+        int m_index; // -1 if not measured
+    };
+
+    struct ScopeRecord
+    {
+        const char* name;
+        double cpuMilliseconds;
+        double gpuMilliseconds;
+        unsigned int glCalls; // Counted with CountGlCalls
+    };
+
+    struct FrameRecord
+    {
+        std::uint64_t frame;
+        double cpuMilliseconds; // From BeginFrame to EndFrame
+        std::vector<ScopeRecord> scopes;
+    };
+public:
+    Profiler();
+    ~Profiler();
+    void BeginFrame();
+    void EndFrame();
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return m_enabled; }
+    void SetHistorySize(std::size_t historySize);
+    void SetWaitForResults(bool waitForResults); // Wait for late GPU results instead of dropping the frame
+    void Flush(); // Waits for the GPU and reads back all the frames in flight
+    unsigned int GetDroppedFrames() const { return m_droppedFrames; }
+    static void CountGlCalls(unsigned int count) { s_numGlCalls += count; } // Called after the per-frame GL calls (by ShaderProgram, Mesh, and the callers of raw GL or atmosphere::Model calls)
+    void ShowWindow();
+    const std::deque<FrameRecord>& GetHistory() const { return m_history; }
+    bool ExportCsv(const std::string& path) const;
+    bool ExportJson(const std::string& path) const;
+private:
+    int BeginScope(const char* name);
+    void EndScope(int index);
+    void ReadBack(int slot);
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr int kFrameLatency = 4;
+    static constexpr int kMaxScopes = 16;
+    static constexpr std::size_t kHistorySize = 300;
+
+    struct PendingFrame
+    {
+        bool pending;
+        std::uint64_t frame;
+        double frameCpuMilliseconds;
+        int numScopes;
+        const char* names[kMaxScopes];
+        double scopeCpuMilliseconds[kMaxScopes];
+        unsigned int scopeGlCalls[kMaxScopes];
+    };
+private:
+    bool m_enabled;
+    bool m_waitForResults;
+    bool m_inFrame;
+    bool m_inScope;
+    std::uint64_t m_frame;
+    int m_slot;
+    GLuint m_queries[kFrameLatency][kMaxScopes];
+    PendingFrame m_pendingFrames[kFrameLatency];
+    Clock::time_point m_frameStart;
+    Clock::time_point m_scopeStart;
+    std::uint64_t m_scopeStartGlCalls;
+    std::deque<FrameRecord> m_history;
+    std::size_t m_historySize;
+    unsigned int m_droppedFrames;
+
+    inline static std::uint64_t s_numGlCalls = 0;
+};
\ No newline at end of file
@@ -1,13 +1,16 @@
 #include "ShaderProgram.h"
+#include "Profiler.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
 ShaderProgram::ShaderProgram()
     : m_id(GL_NONE)
     , m_attachedShaders()
+    , m_uniformLocations()
 {
 }
 
@@ -48,41 +51,97 @@ void ShaderProgram::Build()
 
     for (GLuint attachedShader : m_attachedShaders) glDetachShader(m_id, attachedShader);
     m_attachedShaders.clear();
+
+    CacheUniformLocations();
+}
+
+void ShaderProgram::CacheUniformLocations()
+{
+    m_uniformLocations.clear();
+
+    GLint numUniforms = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &numUniforms);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<GLchar> name(std::max(maxNameLength, 1));
+    for (GLint i = 0; i < numUniforms; ++i)
+    {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(m_id, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        GLint location = glGetUniformLocation(m_id, name.data());
+        if (location == -1) continue; // Member of a uniform block
+
+        // Arrays are reported as "name[0]", but are also set as "name"
+        std::string uniformName = std::string(name.data(), length);
+        m_uniformLocations[uniformName] = location;
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            m_uniformLocations[uniformName.substr(0, uniformName.size() - 3)] = location;
+    }
+}
+
+// -1 (ignored by glUniform*) if the uniform is not active
+GLint ShaderProgram::GetUniformLocation(std::string_view key) const
+{
+    auto it = m_uniformLocations.find(key);
+    return it != m_uniformLocations.end() ? it->second : -1;
 }
 
 void ShaderProgram::Use()
 {
     glUseProgram(m_id);
+    Profiler::CountGlCalls(1);
 }
 
 void ShaderProgram::SetInt(std::string_view key, int value)
 {
-    glUniform1i(glGetUniformLocation(m_id, key.data()), value);
+    glUniform1i(GetUniformLocation(key), value);
+    Profiler::CountGlCalls(1);
 }
 
 void ShaderProgram::SetFloat(std::string_view key, float value)
 {
-    glUniform1f(glGetUniformLocation(m_id, key.data()), value);
+    glUniform1f(GetUniformLocation(key), value);
+    Profiler::CountGlCalls(1);
 }
 
 void ShaderProgram::SetBool(std::string_view key, bool value)
 {
-    glUniform1i(glGetUniformLocation(m_id, key.data()), value);
+    glUniform1i(GetUniformLocation(key), value);
+    Profiler::CountGlCalls(1);
 }
 
 void ShaderProgram::SetVec3(std::string_view key, const glm::vec3& value)
 {
-    glUniform3fv(glGetUniformLocation(m_id, key.data()), 1, glm::value_ptr(value));
+    glUniform3fv(GetUniformLocation(key), 1, glm::value_ptr(value));
+    Profiler::CountGlCalls(1);
+}
+
+void ShaderProgram::SetMat3(std::string_view key, const glm::mat3& value)
+{
+    glUniformMatrix3fv(GetUniformLocation(key), 1, GL_FALSE, glm::value_ptr(value));
+    Profiler::CountGlCalls(1);
 }
 
 void ShaderProgram::SetMat4(std::string_view key, const glm::mat4& value)
 {
-    glUniformMatrix4fv(glGetUniformLocation(m_id, key.data()), 1, GL_FALSE, glm::value_ptr(value));
+    glUniformMatrix4fv(GetUniformLocation(key), 1, GL_FALSE, glm::value_ptr(value));
+    Profiler::CountGlCalls(1);
 }
 
 void ShaderProgram::SetTexture(std::string_view key, unsigned int unit, const Texture& value)
 {
     glActiveTexture(GL_TEXTURE0 + unit);
     glBindTexture(GL_TEXTURE_2D, value.m_id);
-    glUniform1i(glGetUniformLocation(m_id, key.data()), unit);
+    glUniform1i(GetUniformLocation(key), unit);
+    Profiler::CountGlCalls(3);
+}
+
+// Uniform blocks cannot be bound in GLSL 3.30 shaders, so this has to be called after every Build
+void ShaderProgram::SetUniformBlockBinding(std::string_view key, GLuint binding)
+{
+    GLuint index = glGetUniformBlockIndex(m_id, std::string(key).c_str());
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(m_id, index, binding);
 }
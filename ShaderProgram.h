@@ -7,9 +7,14 @@
 
 #include <glm/glm.hpp>
 
+#include <functional>
+#include <map>
+#include <string>
 #include <string_view>
 #include <vector>
 
+// Uniform locations are resolved once, when the program is built, so setting
+// a uniform does not query the driver.
 class ShaderProgram
 {
 public:
@@ -23,9 +28,15 @@ public:
     void SetFloat(std::string_view, float value);
     void SetBool(std::string_view, bool value);
     void SetVec3(std::string_view, const glm::vec3& value);
+    void SetMat3(std::string_view, const glm::mat3& value);
     void SetMat4(std::string_view, const glm::mat4& value);
     void SetTexture(std::string_view, unsigned int unit, const Texture& value);
+    void SetUniformBlockBinding(std::string_view, GLuint binding);
+    GLint GetUniformLocation(std::string_view key) const;
     GLuint m_id;
+private:
+    void CacheUniformLocations();
 private:
     std::vector<GLuint> m_attachedShaders;
+    std::map<std::string, GLint, std::less<>> m_uniformLocations;
 };
\ No newline at end of file
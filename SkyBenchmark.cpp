@@ -0,0 +1,278 @@
+#include "SkyBenchmark.h"
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    struct Statistics
+    {
+        double mean;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+    };
+
+    // Nearest-rank percentiles
+    Statistics ComputeStatistics(std::vector<double> values)
+    {
+        Statistics statistics = {};
+        if (values.empty()) return statistics;
+
+        std::sort(values.begin(), values.end());
+        auto percentile = [&values](double p)
+        {
+            std::size_t rank = static_cast<std::size_t>(std::ceil(p * values.size()));
+            return values[std::max<std::size_t>(rank, 1) - 1];
+        };
+
+        double sum = 0.0;
+        for (double value : values) sum += value;
+        statistics.mean = sum / values.size();
+        statistics.p50 = percentile(0.50);
+        statistics.p90 = percentile(0.90);
+        statistics.p99 = percentile(0.99);
+        statistics.max = values.back();
+        return statistics;
+    }
+
+    void WriteStatistics(std::ostream& output, const char* name, const std::vector<double>& values)
+    {
+        Statistics statistics = ComputeStatistics(values);
+        output << "\"" << name << "\": {\"mean\": " << statistics.mean << ", \"p50\": " << statistics.p50 << ", \"p90\": " << statistics.p90
+            << ", \"p99\": " << statistics.p99 << ", \"max\": " << statistics.max << "}";
+    }
+
+    // Keys sorted by frame, clamped outside of their range
+    template <typename Key>
+    void FindKeys(const std::vector<Key>& keys, int frame, const Key*& previous, const Key*& next, float& t)
+    {
+        auto it = std::upper_bound(keys.begin(), keys.end(), frame, [](int value, const Key& key) { return value < key.frame; });
+        next = it == keys.end() ? &keys.back() : &*it;
+        previous = it == keys.begin() ? &keys.front() : &*(it - 1);
+        t = next->frame > previous->frame ? static_cast<float>(frame - previous->frame) / static_cast<float>(next->frame - previous->frame) : 0.0f;
+        t = glm::clamp(t, 0.0f, 1.0f);
+    }
+}
+
+SkyBenchmark::SkyBenchmark()
+    : m_path()
+    , m_outputPath()
+    , m_width(1920)
+    , m_height(1080)
+    , m_measuredFrames(600)
+    , m_warmupFrames(60)
+    , m_frameRate(60.0f)
+    , m_date{2022, 10, 10, 6, 0, 33}
+    , m_skyParameters()
+    , m_cameraKeys()
+    , m_timeKeys()
+    , m_precomputationMilliseconds(0.0)
+    , m_precomputationWallClockMilliseconds(0.0)
+{
+}
+
+bool SkyBenchmark::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "[SkyBenchmark] E: Could not open " << path << "." << std::endl;
+        return false;
+    }
+    m_path = path;
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        std::istringstream stream(line.substr(0, line.find('#')));
+        std::string command;
+        if (!(stream >> command)) continue;
+
+        bool valid = true;
+        if (command == "resolution") valid = static_cast<bool>(stream >> m_width >> m_height) && m_width > 0 && m_height > 0;
+        else if (command == "frames") valid = static_cast<bool>(stream >> m_measuredFrames) && m_measuredFrames > 0;
+        else if (command == "warmup") valid = static_cast<bool>(stream >> m_warmupFrames) && m_warmupFrames >= 0;
+        else if (command == "frame_rate") valid = static_cast<bool>(stream >> m_frameRate) && m_frameRate > 0.0f;
+        else if (command == "date") valid = static_cast<bool>(stream >> m_date[0] >> m_date[1] >> m_date[2] >> m_date[3] >> m_date[4] >> m_date[5]);
+        else if (command == "sky")
+        {
+            std::pair<std::string, double> parameter;
+            valid = static_cast<bool>(stream >> parameter.first >> parameter.second);
+            if (valid) m_skyParameters.push_back(parameter);
+        }
+        else if (command == "camera")
+        {
+            CameraKey key;
+            valid = static_cast<bool>(stream >> key.frame >> key.azimuth >> key.zenith >> key.verticalFov);
+            if (valid) m_cameraKeys.push_back(key);
+        }
+        else if (command == "time")
+        {
+            TimeKey key;
+            valid = static_cast<bool>(stream >> key.frame >> key.seconds);
+            if (valid) m_timeKeys.push_back(key);
+        }
+        else valid = false;
+
+        if (!valid)
+        {
+            std::cerr << "[SkyBenchmark] E: " << path << ":" << lineNumber << ": Invalid command." << std::endl;
+            return false;
+        }
+    }
+
+    std::stable_sort(m_cameraKeys.begin(), m_cameraKeys.end(), [](const CameraKey& a, const CameraKey& b) { return a.frame < b.frame; });
+    std::stable_sort(m_timeKeys.begin(), m_timeKeys.end(), [](const TimeKey& a, const TimeKey& b) { return a.frame < b.frame; });
+    return true;
+}
+
+void SkyBenchmark::SetOutputPath(const std::string& outputPath)
+{
+    m_outputPath = outputPath;
+}
+
+int SkyBenchmark::GetScriptFrame(int frame) const
+{
+    return std::max(frame - m_warmupFrames, 0);
+}
+
+float SkyBenchmark::GetFrameTime(int frame) const
+{
+    return static_cast<float>(GetScriptFrame(frame)) / m_frameRate;
+}
+
+// Sets the parameters of the script and precomputes the atmosphere (even if they are the default ones), timing it
+bool SkyBenchmark::ApplyParameters(PhysicalSky& physicalSky)
+{
+    for (const std::pair<std::string, double>& parameter : m_skyParameters)
+    {
+        if (!physicalSky.SetParameter(parameter.first, parameter.second))
+        {
+            std::cerr << "[SkyBenchmark] E: Unknown sky parameter " << parameter.first << "." << std::endl;
+            return false;
+        }
+    }
+
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    physicalSky.ApplyParameters();
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+
+    m_precomputationWallClockMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    m_precomputationMilliseconds = physicalSky.GetPrecomputationTime() * 1000.0;
+    return true;
+}
+
+void SkyBenchmark::ApplyFrame(int frame, Camera& camera, PhysicalSky& physicalSky) const
+{
+    int scriptFrame = GetScriptFrame(frame);
+
+    if (!m_cameraKeys.empty())
+    {
+        const CameraKey* previous;
+        const CameraKey* next;
+        float t;
+        FindKeys(m_cameraKeys, scriptFrame, previous, next, t);
+        float azimuth = glm::mix(previous->azimuth, next->azimuth, t);
+        float zenith = glm::mix(previous->zenith, next->zenith, t);
+        float verticalFov = glm::mix(previous->verticalFov, next->verticalFov, t);
+        camera.SetView(glm::radians(azimuth), glm::radians(zenith), glm::radians(verticalFov));
+    }
+
+    double seconds = 0.0;
+    if (!m_timeKeys.empty())
+    {
+        const TimeKey* previous;
+        const TimeKey* next;
+        float t;
+        FindKeys(m_timeKeys, scriptFrame, previous, next, t);
+        seconds = glm::mix(previous->seconds, next->seconds, static_cast<double>(t));
+    }
+    int second = m_date[5] + static_cast<int>(std::lround(seconds));
+    physicalSky.GetAstronomicalPositioning().SetDateTime(m_date[0], m_date[1], m_date[2], m_date[3], m_date[4], second);
+}
+
+bool SkyBenchmark::Report(const Profiler& profiler, const PhysicalSky::SkyViewLutError& skyViewLutError) const
+{
+    std::ofstream file;
+    if (!m_outputPath.empty())
+    {
+        file.open(m_outputPath);
+        if (!file)
+        {
+            std::cerr << "[SkyBenchmark] E: Could not open " << m_outputPath << " for writing." << std::endl;
+            return false;
+        }
+    }
+    std::ostream& output = m_outputPath.empty() ? std::cout : file;
+
+    // Passes in order of first appearance, the warm-up frames are discarded
+    std::vector<const char*> passNames;
+    std::vector<std::vector<double>> passCpuMilliseconds;
+    std::vector<std::vector<double>> passGpuMilliseconds;
+    std::vector<std::vector<double>> passGlCalls;
+    std::vector<double> frameCpuMilliseconds;
+    std::vector<double> frameGpuMilliseconds;
+    const std::deque<Profiler::FrameRecord>& history = profiler.GetHistory();
+    std::size_t warmupFrames = std::min(static_cast<std::size_t>(m_warmupFrames), history.size());
+    for (auto frame = history.begin() + warmupFrames; frame != history.end(); ++frame)
+    {
+        double gpuMilliseconds = 0.0;
+        for (const Profiler::ScopeRecord& scope : frame->scopes)
+        {
+            auto it = std::find_if(passNames.begin(), passNames.end(), [&](const char* name) { return std::strcmp(name, scope.name) == 0; });
+            std::size_t pass = it - passNames.begin();
+            if (it == passNames.end())
+            {
+                passNames.push_back(scope.name);
+                passCpuMilliseconds.emplace_back();
+                passGpuMilliseconds.emplace_back();
+                passGlCalls.emplace_back();
+            }
+            passCpuMilliseconds[pass].push_back(scope.cpuMilliseconds);
+            passGpuMilliseconds[pass].push_back(scope.gpuMilliseconds);
+            passGlCalls[pass].push_back(scope.glCalls);
+            gpuMilliseconds += scope.gpuMilliseconds;
+        }
+        frameCpuMilliseconds.push_back(frame->cpuMilliseconds);
+        frameGpuMilliseconds.push_back(gpuMilliseconds);
+    }
+
+    output << "{\n";
+    output << "  \"script\": \"" << m_path << "\",\n";
+    output << "  \"width\": " << m_width << ", \"height\": " << m_height << ",\n";
+    output << "  \"warmup_frames\": " << m_warmupFrames << ", \"measured_frames\": " << frameCpuMilliseconds.size() << ", \"dropped_frames\": " << profiler.GetDroppedFrames() << ",\n";
+    output << "  \"precomputation\": {\"gpu_ms\": " << m_precomputationMilliseconds << ", \"wall_clock_ms\": " << m_precomputationWallClockMilliseconds << "},\n";
+    if (skyViewLutError.valid)
+    {
+        output << "  \"sky_view_lut_error\": {\"rms\": " << skyViewLutError.rmsError << ", \"relative_rms\": " << skyViewLutError.relativeRmsError
+            << ", \"max_relative\": " << skyViewLutError.maxRelativeError << "},\n";
+    }
+    output << "  \"frame\": {"; WriteStatistics(output, "cpu_ms", frameCpuMilliseconds); output << ", "; WriteStatistics(output, "gpu_ms", frameGpuMilliseconds); output << "},\n";
+    output << "  \"passes\": [";
+    for (std::size_t pass = 0; pass < passNames.size(); ++pass)
+    {
+        output << (pass > 0 ? ",\n" : "\n") << "    {\"name\": \"" << passNames[pass] << "\", \"samples\": " << passGpuMilliseconds[pass].size() << ", ";
+        WriteStatistics(output, "cpu_ms", passCpuMilliseconds[pass]);
+        output << ", ";
+        WriteStatistics(output, "gpu_ms", passGpuMilliseconds[pass]);
+        output << ", ";
+        WriteStatistics(output, "gl_calls", passGlCalls[pass]);
+        output << "}";
+    }
+    output << "\n  ]\n}\n";
+    output.flush();
+    return static_cast<bool>(output);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Camera.h"
+#include "PhysicalSky.h"
+#include "Profiler.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Scripted benchmark of the whole renderer. A script file sets the resolution,
+// the number of frames, the parameters of the sky and, through keyframes that
+// are linearly interpolated, the camera and the date and time of each frame.
+// Everything only depends on the frame number (warm-up frames repeat the first
+// one), so that results can be compared across commits. The percentiles of the
+// CPU and GPU time of each pass, the precomputation time and the error of the
+// sky-view LUT with respect to the per-pixel sky are written as JSON.
+//
+// Script syntax, one command per line ('#' starts a comment):
+//   resolution <width> <height>
+//   frames <measured frames>
+//   warmup <frames>
+//   frame_rate <frames per second of the simulated clock>
+//   date <year> <month> <day> <hour> <minute> <second>
+//   sky <PhysicalSky::SetParameter name> <value>
+//   camera <frame> <azimuth> <zenith> <vertical fov> (degrees)
+//   time <frame> <seconds since the date>
+class SkyBenchmark
+{
+public:
+    SkyBenchmark();
+    bool Load(const std::string& path);
+    void SetOutputPath(const std::string& outputPath); // Standard output if empty
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetNumFrames() const { return m_warmupFrames + m_measuredFrames; }
+    float GetFrameTime(int frame) const;
+    bool ApplyParameters(PhysicalSky& physicalSky);
+    void ApplyFrame(int frame, Camera& camera, PhysicalSky& physicalSky) const;
+    bool Report(const Profiler& profiler, const PhysicalSky::SkyViewLutError& skyViewLutError) const;
+private:
+    struct CameraKey
+    {
+        int frame;
+        float azimuth;
+        float zenith;
+        float verticalFov;
+    };
+
+    struct TimeKey
+    {
+        int frame;
+        double seconds;
+    };
+private:
+    int GetScriptFrame(int frame) const;
+private:
+    std::string m_path;
+    std::string m_outputPath;
+    int m_width;
+    int m_height;
+    int m_measuredFrames;
+    int m_warmupFrames;
+    float m_frameRate;
+    int m_date[6]; // Year, month, day, hour, minute, second
+    std::vector<std::pair<std::string, double>> m_skyParameters;
+    std::vector<CameraKey> m_cameraKeys;
+    std::vector<TimeKey> m_timeKeys;
+    double m_precomputationMilliseconds; // GPU time, as measured by the models
+    double m_precomputationWallClockMilliseconds; // Including the compilation of the shaders
+};
\ No newline at end of file
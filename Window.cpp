@@ -4,22 +4,56 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include <cstdlib>
+#include <iostream>
+
 Window::Window()
+    : m_headless(false)
+    , m_benchmarkTime(0.0f)
 {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     // glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
     m_window = glfwCreateWindow(1920, 1080, "miri-tfm", glfwGetPrimaryMonitor(), nullptr);
+
+    // Hidden window whose context shares objects with the main one, used to precompute the atmosphere in the background
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_sharedContextWindow = glfwCreateWindow(1, 1, "miri-tfm (shared context)", nullptr, m_window);
+    glfwDefaultWindowHints();
+}
+
+// Without a shared context window the atmosphere is precomputed synchronously, so that benchmarks are deterministic
+Window::Window(int width, int height)
+    : m_sharedContextWindow(nullptr)
+    , m_headless(true)
+    , m_benchmarkTime(0.0f)
+{
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    m_window = glfwCreateWindow(width, height, "miri-tfm (benchmark)", nullptr, nullptr);
+    glfwDefaultWindowHints();
 }
 
 Window::~Window()
 {
-    glfwDestroyWindow(m_window);
+    // The application must release the shared context before the windows are destroyed
+    m_application.reset();
+    if (m_sharedContextWindow) glfwDestroyWindow(m_sharedContextWindow);
+    if (m_window) glfwDestroyWindow(m_window);
 }
 
 void Window::Init()
 {
+    if (!m_window)
+    {
+        std::cerr << "[Window] E: Could not be created." << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
     MakeCurrent();
     InstallCallbacks();
     InitImGui();
@@ -72,7 +106,7 @@ void Window::InitImGui() const
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
-    io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+    if (!m_headless) io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
 
     ImGui::StyleColorsDark();
 
@@ -95,12 +129,18 @@ void Window::MainLoop()
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        Profiler& profiler = m_application->GetProfiler();
+        profiler.BeginFrame();
+
         glfwPollEvents();
         m_application->OnUpdate();
         m_application->OnRender();
 
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            Profiler::Scope imGuiScope(profiler, "ImGui");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
         {
@@ -110,8 +150,50 @@ void Window::MainLoop()
             glfwMakeContextCurrent(backup_current_context);
         }
 
+        profiler.EndFrame();
+        glfwSwapBuffers(m_window);
+    }
+}
+
+// Renders the frames of the benchmark into the hidden window, without the UI, and reports the results
+bool Window::RunBenchmark(SkyBenchmark& benchmark)
+{
+    Profiler& profiler = m_application->GetProfiler();
+    profiler.SetEnabled(true);
+    profiler.SetWaitForResults(true);
+    profiler.SetHistorySize(benchmark.GetNumFrames());
+
+    if (!benchmark.ApplyParameters(m_application->GetPhysicalSky())) return false;
+
+    for (int frame = 0; frame < benchmark.GetNumFrames(); ++frame)
+    {
+        m_benchmarkTime = benchmark.GetFrameTime(frame);
+
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        profiler.BeginFrame();
+
+        glfwPollEvents();
+        benchmark.ApplyFrame(frame, m_application->GetCamera(), m_application->GetPhysicalSky());
+        m_application->OnUpdate();
+        m_application->OnRender();
+
+        ImGui::Render();
+
+        profiler.EndFrame();
         glfwSwapBuffers(m_window);
     }
+
+    profiler.Flush();
+
+    // Additional frame, not measured, comparing the sky rendered with the sky-view LUT and per pixel from the last camera
+    profiler.SetEnabled(false);
+    m_application->GetPhysicalSky().RequestSkyViewLutComparison();
+    m_application->OnRender();
+
+    return benchmark.Report(profiler, m_application->GetPhysicalSky().GetSkyViewLutError());
 }
 
 void Window::OnCursorPos(double xpos, double ypos)
@@ -139,5 +221,11 @@ void Window::OnFramebufferSize(int width, int height)
 
 float Window::GetTime() const
 {
+    if (m_headless) return m_benchmarkTime;
     return static_cast<float>(glfwGetTime());
 }
+
+GLFWwindow* Window::GetSharedContextWindow() const
+{
+    return m_sharedContextWindow;
+}
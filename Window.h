@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Application.h"
+#include "SkyBenchmark.h"
 
 #include <GLFW/glfw3.h>
 
@@ -10,10 +11,14 @@ class Window
 {
 public:
     Window();
+    Window(int width, int height); // Hidden, for benchmarks
     ~Window();
     void Init();
     void MainLoop();
+    bool RunBenchmark(SkyBenchmark& benchmark);
     float GetTime() const;
+    bool IsHeadless() const { return m_headless; }
+    GLFWwindow* GetSharedContextWindow() const;
 private:
     void MakeCurrent() const;
     void InstallCallbacks();
@@ -24,5 +29,8 @@ private:
     void OnFramebufferSize(int width, int height);
 private:
     GLFWwindow* m_window;
+    GLFWwindow* m_sharedContextWindow;
+    bool m_headless;
+    float m_benchmarkTime; // Replaces the wall clock time in benchmarks, so that they are deterministic
     std::unique_ptr<Application> m_application;
 };
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "LutBenchmark.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstdlib>
+#include <iostream>
+
+// Compares the texture resolution tiers of the atmosphere model (see LutBenchmark)
+int main()
+{
+    glfwSetErrorCallback([](int error_code, const char* description)
+    {
+        std::cerr << "[glfw] E(" << error_code << "): " << description << std::endl;
+    });
+
+    if (glfwInit() != GLFW_TRUE)
+    {
+        std::cerr << "[glfw] E: Could not be initialized." << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(1, 1, "miri-tfm (benchmark)", nullptr, nullptr);
+    if (!window)
+    {
+        glfwTerminate();
+        std::exit(EXIT_FAILURE);
+    }
+
+    glfwMakeContextCurrent(window);
+    gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+    atmosphere::Model::LoadComputeShaderFunctions(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+
+    {
+        LutBenchmark benchmark = LutBenchmark(LutBenchmark::GetDefaultModelParameters());
+        LutBenchmark::Print(benchmark.Run());
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
\ No newline at end of file
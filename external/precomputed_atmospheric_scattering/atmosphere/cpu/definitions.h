@@ -0,0 +1,271 @@
+/*<h2>atmosphere/cpu/definitions.h</h2>
+
+<p>This C++ file defines the types and constants which are used in the main GLSL
+<a href="../functions.glsl.html">functions</a> of our atmosphere model, in such
+a way that they can be compiled by the C++ compiler and evaluated on CPU with
+the same 3 wavelengths as the GPU <code>Model</code>. Unlike the
+<a href="../reference/definitions.h.html">reference definitions</a>, which check
+the dimensional homogeneity of the GLSL code with spectral types, all the
+physical quantities are simply double precision numbers here, and all the
+spectra are RGB vectors.
+*/
+
+#ifndef ATMOSPHERE_CPU_DEFINITIONS_H_
+#define ATMOSPHERE_CPU_DEFINITIONS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "atmosphere/constants.h"
+
+namespace atmosphere {
+namespace cpu {
+
+/*
+<h3>Physical quantities</h3>
+*/
+
+typedef glm::dvec2 vec2;
+typedef glm::dvec3 vec3;
+typedef glm::dvec4 vec4;
+
+typedef double Length;
+typedef double Wavelength;
+typedef double Angle;
+typedef double SolidAngle;
+typedef double Power;
+typedef double LuminousPower;
+typedef double Number;
+typedef double InverseLength;
+typedef double Area;
+typedef double Volume;
+typedef double NumberDensity;
+typedef double Irradiance;
+typedef double Radiance;
+typedef double SpectralPower;
+typedef double SpectralIrradiance;
+typedef double SpectralRadiance;
+typedef double SpectralRadianceDensity;
+typedef double ScatteringCoefficient;
+typedef double InverseSolidAngle;
+typedef double LuminousIntensity;
+typedef double Luminance;
+typedef double Illuminance;
+
+typedef vec3 AbstractSpectrum;
+typedef vec3 DimensionlessSpectrum;
+typedef vec3 PowerSpectrum;
+typedef vec3 IrradianceSpectrum;
+typedef vec3 RadianceSpectrum;
+typedef vec3 RadianceDensitySpectrum;
+typedef vec3 ScatteringSpectrum;
+
+typedef vec3 Position;
+typedef vec3 Direction;
+typedef vec3 Luminance3;
+typedef vec3 Illuminance3;
+
+/*
+<h3>Precomputed textures</h3>
+
+<p>The precomputed textures store one RGB value per texel, in the same order as
+the OpenGL textures (i.e. with x varying fastest), and are sampled like them,
+with bilinear (resp. trilinear) interpolation and clamp to edge wrapping:
+*/
+
+template<int WIDTH, int HEIGHT>
+class Texture2d {
+ public:
+  Texture2d() : value_(WIDTH * HEIGHT) {}
+
+  const vec3& Get(int i, int j) const { return value_[i + j * WIDTH]; }
+  void Set(int i, int j, const vec3& value) { value_[i + j * WIDTH] = value; }
+  const std::vector<vec3>& data() const { return value_; }
+
+  vec3 Sample(const vec2& uv) const {
+    double u = uv.x * WIDTH - 0.5;
+    double v = uv.y * HEIGHT - 0.5;
+    int i = static_cast<int>(std::floor(u));
+    int j = static_cast<int>(std::floor(v));
+    double s = u - i;
+    double t = v - j;
+    int i0 = std::clamp(i, 0, WIDTH - 1);
+    int i1 = std::clamp(i + 1, 0, WIDTH - 1);
+    int j0 = std::clamp(j, 0, HEIGHT - 1);
+    int j1 = std::clamp(j + 1, 0, HEIGHT - 1);
+    return Get(i0, j0) * ((1.0 - s) * (1.0 - t)) + Get(i1, j0) * (s * (1.0 - t)) +
+        Get(i0, j1) * ((1.0 - s) * t) + Get(i1, j1) * (s * t);
+  }
+
+ private:
+  std::vector<vec3> value_;
+};
+
+template<int WIDTH, int HEIGHT, int DEPTH>
+class Texture3d {
+ public:
+  Texture3d() : value_(WIDTH * HEIGHT * DEPTH) {}
+
+  const vec3& Get(int i, int j, int k) const {
+    return value_[i + (j + k * HEIGHT) * WIDTH];
+  }
+  void Set(int i, int j, int k, const vec3& value) {
+    value_[i + (j + k * HEIGHT) * WIDTH] = value;
+  }
+  const std::vector<vec3>& data() const { return value_; }
+
+  vec3 Sample(const vec3& uvw) const {
+    double u = uvw.x * WIDTH - 0.5;
+    double v = uvw.y * HEIGHT - 0.5;
+    double w = uvw.z * DEPTH - 0.5;
+    int i = static_cast<int>(std::floor(u));
+    int j = static_cast<int>(std::floor(v));
+    int k = static_cast<int>(std::floor(w));
+    double s = u - i;
+    double t = v - j;
+    double r = w - k;
+    int i0 = std::clamp(i, 0, WIDTH - 1);
+    int i1 = std::clamp(i + 1, 0, WIDTH - 1);
+    int j0 = std::clamp(j, 0, HEIGHT - 1);
+    int j1 = std::clamp(j + 1, 0, HEIGHT - 1);
+    int k0 = std::clamp(k, 0, DEPTH - 1);
+    int k1 = std::clamp(k + 1, 0, DEPTH - 1);
+    vec3 value0 =
+        Get(i0, j0, k0) * ((1.0 - s) * (1.0 - t)) +
+        Get(i1, j0, k0) * (s * (1.0 - t)) +
+        Get(i0, j1, k0) * ((1.0 - s) * t) +
+        Get(i1, j1, k0) * (s * t);
+    vec3 value1 =
+        Get(i0, j0, k1) * ((1.0 - s) * (1.0 - t)) +
+        Get(i1, j0, k1) * (s * (1.0 - t)) +
+        Get(i0, j1, k1) * ((1.0 - s) * t) +
+        Get(i1, j1, k1) * (s * t);
+    return value0 * (1.0 - r) + value1 * r;
+  }
+
+ private:
+  std::vector<vec3> value_;
+};
+
+typedef Texture2d<TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT>
+    TransmittanceTexture;
+typedef Texture3d<SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT,
+    SCATTERING_TEXTURE_DEPTH> AbstractScatteringTexture;
+typedef AbstractScatteringTexture ReducedScatteringTexture;
+typedef AbstractScatteringTexture ScatteringTexture;
+typedef AbstractScatteringTexture ScatteringDensityTexture;
+typedef Texture2d<IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT>
+    IrradianceTexture;
+
+/*
+<h3>GLSL built-in functions</h3>
+
+<p>The GLSL functions used in <code>functions.glsl</code> are provided by GLM,
+except for <code>texture</code> and <code>mod</code>:
+*/
+
+using glm::clamp;
+using glm::dot;
+using glm::exp;
+using glm::floor;
+using glm::length;
+using glm::max;
+using glm::min;
+using glm::normalize;
+using glm::smoothstep;
+using std::cos;
+using std::exp;
+using std::floor;
+using std::pow;
+using std::sin;
+using std::sqrt;
+
+template<int WIDTH, int HEIGHT>
+inline vec3 texture(const Texture2d<WIDTH, HEIGHT>& sampler, const vec2& uv) {
+  return sampler.Sample(uv);
+}
+
+template<int WIDTH, int HEIGHT, int DEPTH>
+inline vec3 texture(const Texture3d<WIDTH, HEIGHT, DEPTH>& sampler,
+    const vec3& uvw) {
+  return sampler.Sample(uvw);
+}
+
+inline Number mod(Number x, Number y) { return x - y * std::floor(x / y); }
+
+/*
+<h3>Physical units</h3>
+*/
+
+constexpr Length m = 1.0;
+constexpr Wavelength nm = 1.0;
+constexpr Angle rad = 1.0;
+constexpr SolidAngle sr = 1.0;
+constexpr Power watt = 1.0;
+constexpr LuminousPower lm = 1.0;
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr Length km = 1000.0 * m;
+constexpr Area m2 = m * m;
+constexpr Volume m3 = m * m * m;
+constexpr Angle pi = PI * rad;
+constexpr Angle deg = pi / 180.0;
+constexpr Irradiance watt_per_square_meter = watt / m2;
+constexpr Radiance watt_per_square_meter_per_sr = watt / (m2 * sr);
+constexpr SpectralIrradiance watt_per_square_meter_per_nm = watt / (m2 * nm);
+constexpr SpectralRadiance watt_per_square_meter_per_sr_per_nm =
+    watt / (m2 * sr * nm);
+constexpr SpectralRadianceDensity watt_per_cubic_meter_per_sr_per_nm =
+    watt / (m3 * sr * nm);
+constexpr LuminousIntensity cd = lm / sr;
+constexpr LuminousIntensity kcd = 1000.0 * cd;
+constexpr Luminance cd_per_square_meter = cd / m2;
+constexpr Luminance kcd_per_square_meter = kcd / m2;
+
+/*
+<h3>Atmosphere parameters</h3>
+
+<p>These structs have the same fields as their
+<a href="../definitions.glsl.html">GLSL equivalent</a>, with lengths expressed
+in the length unit of the GPU <code>Model</code>:
+*/
+
+struct DensityProfileLayer {
+  Length width;
+  Number exp_term;
+  InverseLength exp_scale;
+  InverseLength linear_term;
+  Number constant_term;
+};
+
+struct DensityProfile {
+  DensityProfileLayer layers[2];
+};
+
+struct AtmosphereParameters {
+  IrradianceSpectrum sun_irradiance;
+  Angle sun_angular_radius;
+  IrradianceSpectrum moon_irradiance;
+  Angle moon_angular_radius;
+  Length bottom_radius;
+  Length top_radius;
+  DensityProfile rayleigh_density;
+  ScatteringSpectrum rayleigh_scattering;
+  DensityProfile mie_density;
+  ScatteringSpectrum mie_scattering;
+  ScatteringSpectrum mie_extinction;
+  Number mie_phase_function_g;
+  DensityProfile absorption_density;
+  ScatteringSpectrum absorption_extinction;
+  DimensionlessSpectrum ground_albedo;
+  Number mu_s_min;
+};
+
+}  // namespace cpu
+}  // namespace atmosphere
+
+#endif  // ATMOSPHERE_CPU_DEFINITIONS_H_
@@ -0,0 +1,245 @@
+/*<h2>atmosphere/cpu/model.cc</h2>
+
+<p>This file implements the <a href="model.h.html">CPU model</a>. The GLSL
+<a href="../functions.glsl.html">functions</a> are compiled as C++ code, with
+the <a href="definitions.h.html">CPU definitions</a> and the following macros
+(as in the <a href="../reference/functions.cc.html">reference
+implementation</a>):
+*/
+
+#include "atmosphere/cpu/model.h"
+
+#include <cassert>
+#include <chrono>
+#include <functional>
+
+#include "atmosphere/cpu/thread_pool.h"
+
+#define IN(x) const x&
+#define OUT(x) x&
+#define TEMPLATE(x)
+#define TEMPLATE_ARGUMENT(x)
+
+namespace atmosphere {
+namespace cpu {
+
+#include "atmosphere/functions.glsl"
+
+/*
+<p>Each precomputation pass evaluates one of the <code>Compute*Texture</code>
+functions for each texel of its output texture(s), at the texel centers, as the
+fragment shaders of the GPU model do with <code>gl_FragCoord</code>. The texels
+are processed one row at a time, and the rows of each pass are distributed on
+the threads of a work-stealing pool. Indeed the cost of a texel varies a lot
+with its parameters (e.g. rays hitting the ground are much cheaper to integrate
+than the others), so a static partition of the rows would leave most threads
+idle while waiting for the slowest one. The texels of a row are evaluated one
+after the other, and not several at once in SIMD lanes: the functions branch
+per texel (e.g. depending on whether the ray intersects the ground, or on the
+scattering order), and each texel samples its own texels of the textures of
+the previous passes, so most lanes would be masked or gathering most of the
+time. Only the RGB arithmetic of each texel
+is left to the auto-vectorization of the compiler.
+*/
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double SecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void ForEachTexel2d(ThreadPool& pool, int width, int height,
+    const std::function<void(int, int, const vec2&)>& function) {
+  pool.ParallelFor(height, [width, &function](int j) {
+    for (int i = 0; i < width; ++i) {
+      function(i, j, vec2(i + 0.5, j + 0.5));
+    }
+  });
+}
+
+void ForEachScatteringTexel(ThreadPool& pool,
+    const std::function<void(int, int, int, const vec3&)>& function) {
+  pool.ParallelFor(SCATTERING_TEXTURE_HEIGHT * SCATTERING_TEXTURE_DEPTH,
+      [&function](int row) {
+    int j = row % SCATTERING_TEXTURE_HEIGHT;
+    int k = row / SCATTERING_TEXTURE_HEIGHT;
+    for (int i = 0; i < SCATTERING_TEXTURE_WIDTH; ++i) {
+      function(i, j, k, vec3(i + 0.5, j + 0.5, k + 0.5));
+    }
+  });
+}
+
+template<class Texture>
+float* CopyTexture(const Texture& texture, float* data) {
+  for (const vec3& value : texture.data()) {
+    *data++ = static_cast<float>(value.r);
+    *data++ = static_cast<float>(value.g);
+    *data++ = static_cast<float>(value.b);
+  }
+  return data;
+}
+
+}  // anonymous namespace
+
+Model::Model(const AtmosphereParameters& atmosphere, int light_source)
+    : atmosphere_(atmosphere),
+      light_source_(light_source),
+      transmittance_texture_(new TransmittanceTexture()),
+      scattering_texture_(new ScatteringTexture()),
+      single_mie_scattering_texture_(new ReducedScatteringTexture()),
+      irradiance_texture_(new IrradianceTexture()),
+      timings_(),
+      num_threads_(0) {
+}
+
+std::size_t Model::GetPrecomputedTexturesSize() {
+  constexpr std::size_t kTransmittanceSize =
+      3 * TRANSMITTANCE_TEXTURE_WIDTH * TRANSMITTANCE_TEXTURE_HEIGHT;
+  constexpr std::size_t kScatteringSize = 3 * SCATTERING_TEXTURE_WIDTH *
+      SCATTERING_TEXTURE_HEIGHT * SCATTERING_TEXTURE_DEPTH;
+  constexpr std::size_t kIrradianceSize =
+      3 * IRRADIANCE_TEXTURE_WIDTH * IRRADIANCE_TEXTURE_HEIGHT;
+  return kTransmittanceSize + 2 * kScatteringSize + kIrradianceSize;
+}
+
+void Model::GetPrecomputedTextures(float* data) const {
+  data = CopyTexture(*transmittance_texture_, data);
+  data = CopyTexture(*scattering_texture_, data);
+  data = CopyTexture(*single_mie_scattering_texture_, data);
+  CopyTexture(*irradiance_texture_, data);
+}
+
+/*
+<p>The precomputation itself follows the same steps as the GPU
+<code>Model::Precompute</code> method, with the same temporary textures (in
+particular <code>delta_multiple_scattering_texture</code> is an alias of
+<code>delta_rayleigh_scattering_texture</code>, as on GPU). The only difference
+is that the additive blending used on GPU to accumulate the results of each
+scattering order is done explicitly here:
+*/
+
+void Model::Init(unsigned int num_scattering_orders,
+    unsigned int num_threads) {
+  ThreadPool pool(num_threads);
+  num_threads_ = pool.num_threads();
+  timings_ = Timings();
+  Clock::time_point init_start = Clock::now();
+
+  std::unique_ptr<IrradianceTexture> delta_irradiance_texture(
+      new IrradianceTexture());
+  std::unique_ptr<ReducedScatteringTexture> delta_rayleigh_scattering_texture(
+      new ReducedScatteringTexture());
+  std::unique_ptr<ReducedScatteringTexture> delta_mie_scattering_texture(
+      new ReducedScatteringTexture());
+  std::unique_ptr<ScatteringDensityTexture> delta_scattering_density_texture(
+      new ScatteringDensityTexture());
+  ScatteringTexture& delta_multiple_scattering_texture =
+      *delta_rayleigh_scattering_texture;
+
+  const AtmosphereParameters& atmosphere = atmosphere_;
+  TransmittanceTexture& transmittance_texture = *transmittance_texture_;
+  ScatteringTexture& scattering_texture = *scattering_texture_;
+  ReducedScatteringTexture& single_mie_scattering_texture =
+      *single_mie_scattering_texture_;
+  IrradianceTexture& irradiance_texture = *irradiance_texture_;
+
+  Angle source_angular_radius = atmosphere.sun_angular_radius;
+  IrradianceSpectrum source_irradiance = atmosphere.sun_irradiance;
+  if (light_source_ != 0) {
+    source_angular_radius = atmosphere.moon_angular_radius;
+    source_irradiance = atmosphere.moon_irradiance;
+  }
+
+  // Compute the transmittance.
+  Clock::time_point start = Clock::now();
+  ForEachTexel2d(pool, TRANSMITTANCE_TEXTURE_WIDTH,
+      TRANSMITTANCE_TEXTURE_HEIGHT, [&](int i, int j, const vec2& frag_coord) {
+    transmittance_texture.Set(i, j,
+        ComputeTransmittanceToTopAtmosphereBoundaryTexture(
+            atmosphere, frag_coord));
+  });
+  timings_.transmittance = SecondsSince(start);
+
+  // Compute the direct irradiance, and initialize the irradiance to 0 (the
+  // direct irradiance is not stored in the irradiance texture, as on GPU).
+  start = Clock::now();
+  ForEachTexel2d(pool, IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT,
+      [&](int i, int j, const vec2& frag_coord) {
+    delta_irradiance_texture->Set(i, j, ComputeDirectIrradianceTexture(
+        atmosphere, transmittance_texture, source_angular_radius,
+        source_irradiance, frag_coord));
+    irradiance_texture.Set(i, j, vec3(0.0));
+  });
+  timings_.direct_irradiance = SecondsSince(start);
+
+  // Compute the rayleigh and mie single scattering.
+  start = Clock::now();
+  ForEachScatteringTexel(pool,
+      [&](int i, int j, int k, const vec3& frag_coord) {
+    IrradianceSpectrum delta_rayleigh;
+    IrradianceSpectrum delta_mie;
+    ComputeSingleScatteringTexture(atmosphere, transmittance_texture,
+        source_angular_radius, source_irradiance, frag_coord, delta_rayleigh,
+        delta_mie);
+    delta_rayleigh_scattering_texture->Set(i, j, k, delta_rayleigh);
+    delta_mie_scattering_texture->Set(i, j, k, delta_mie);
+    scattering_texture.Set(i, j, k, delta_rayleigh);
+    single_mie_scattering_texture.Set(i, j, k, delta_mie);
+  });
+  timings_.single_scattering = SecondsSince(start);
+
+  // Compute the 2nd, 3rd and 4th order of scattering, in sequence.
+  for (unsigned int scattering_order = 2;
+       scattering_order <= num_scattering_orders; ++scattering_order) {
+    const int order = static_cast<int>(scattering_order);
+
+    // Compute the scattering density.
+    start = Clock::now();
+    ForEachScatteringTexel(pool,
+        [&](int i, int j, int k, const vec3& frag_coord) {
+      delta_scattering_density_texture->Set(i, j, k,
+          ComputeScatteringDensityTexture(atmosphere, transmittance_texture,
+              *delta_rayleigh_scattering_texture,
+              *delta_mie_scattering_texture,
+              delta_multiple_scattering_texture, *delta_irradiance_texture,
+              frag_coord, order));
+    });
+    timings_.scattering_density += SecondsSince(start);
+
+    // Compute the indirect irradiance, and accumulate it in the irradiance.
+    start = Clock::now();
+    ForEachTexel2d(pool, IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT,
+        [&](int i, int j, const vec2& frag_coord) {
+      IrradianceSpectrum delta_irradiance = ComputeIndirectIrradianceTexture(
+          atmosphere, *delta_rayleigh_scattering_texture,
+          *delta_mie_scattering_texture, delta_multiple_scattering_texture,
+          frag_coord, order - 1);
+      delta_irradiance_texture->Set(i, j, delta_irradiance);
+      irradiance_texture.Set(i, j,
+          irradiance_texture.Get(i, j) + delta_irradiance);
+    });
+    timings_.indirect_irradiance += SecondsSince(start);
+
+    // Compute the multiple scattering, and accumulate it in the scattering.
+    start = Clock::now();
+    ForEachScatteringTexel(pool,
+        [&](int i, int j, int k, const vec3& frag_coord) {
+      Number nu;
+      RadianceSpectrum delta_multiple_scattering =
+          ComputeMultipleScatteringTexture(atmosphere, transmittance_texture,
+              *delta_scattering_density_texture, frag_coord, nu);
+      delta_multiple_scattering_texture.Set(i, j, k,
+          delta_multiple_scattering);
+      scattering_texture.Set(i, j, k, scattering_texture.Get(i, j, k) +
+          delta_multiple_scattering / RayleighPhaseFunction(nu));
+    });
+    timings_.multiple_scattering += SecondsSince(start);
+  }
+
+  timings_.total = SecondsSince(init_start);
+}
+
+}  // namespace cpu
+}  // namespace atmosphere
@@ -0,0 +1,82 @@
+/*<h2>atmosphere/cpu/model.h</h2>
+
+<p>This file defines a CPU version of the precomputations done by the GPU
+<a href="../model.h.html">Model</a>. It evaluates the same GLSL
+<a href="../functions.glsl.html">functions</a>, compiled as C++ code, in the
+same passes (transmittance, direct irradiance, single scattering and, for each
+scattering order, scattering density, indirect irradiance and multiple
+scattering), and produces the same textures. Since it does not need an OpenGL
+context, it can be used to precompute the textures offline, or to check the
+textures precomputed on GPU. To use it:
+<ul>
+<li>create a <code>Model</code> instance with the desired atmosphere
+parameters, expressed in the length unit of the GPU model,</li>
+<li>call <code>Init</code> to precompute the atmosphere textures, with the
+desired number of threads,</li>
+<li>call <code>GetPrecomputedTextures</code> to get the textures, with the same
+layout as <code>atmosphere::Model::GetPrecomputedTextures</code>.</li>
+</ul>
+
+<p>Note that the computations are done in double precision, while the GPU uses
+single precision floats. The results are thus close to, but not exactly the same
+as the GPU ones.
+*/
+
+#ifndef ATMOSPHERE_CPU_MODEL_H_
+#define ATMOSPHERE_CPU_MODEL_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "atmosphere/cpu/definitions.h"
+
+namespace atmosphere {
+namespace cpu {
+
+class Model {
+ public:
+  // The duration of each precomputation pass of the last call to Init, in
+  // seconds. The last 3 values are summed over all the scattering orders.
+  struct Timings {
+    double transmittance;
+    double direct_irradiance;
+    double single_scattering;
+    double scattering_density;
+    double indirect_irradiance;
+    double multiple_scattering;
+    double total;
+  };
+
+  // 'light_source' is SOURCE_SUN (0) or SOURCE_MOON (1), as in the GPU model.
+  Model(const AtmosphereParameters& atmosphere, int light_source);
+
+  // Precomputes the textures with 'num_threads' threads, or with one thread
+  // per hardware thread if 'num_threads' is 0.
+  void Init(unsigned int num_scattering_orders = 4,
+      unsigned int num_threads = 0);
+
+  // Returns the number of floats written by GetPrecomputedTextures.
+  static std::size_t GetPrecomputedTexturesSize();
+
+  // Writes the precomputed textures to 'data', as RGB float values, in the
+  // same order and layout as atmosphere::Model::GetPrecomputedTextures.
+  void GetPrecomputedTextures(float* data) const;
+
+  const Timings& timings() const { return timings_; }
+  unsigned int num_threads() const { return num_threads_; }
+
+ private:
+  AtmosphereParameters atmosphere_;
+  int light_source_;
+  std::unique_ptr<TransmittanceTexture> transmittance_texture_;
+  std::unique_ptr<ScatteringTexture> scattering_texture_;
+  std::unique_ptr<ReducedScatteringTexture> single_mie_scattering_texture_;
+  std::unique_ptr<IrradianceTexture> irradiance_texture_;
+  Timings timings_;
+  unsigned int num_threads_;
+};
+
+}  // namespace cpu
+}  // namespace atmosphere
+
+#endif  // ATMOSPHERE_CPU_MODEL_H_
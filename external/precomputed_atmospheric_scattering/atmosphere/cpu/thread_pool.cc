@@ -0,0 +1,133 @@
+/*<h2>atmosphere/cpu/thread_pool.cc</h2>
+
+<p>This file implements the <a href="thread_pool.h.html">work-stealing thread
+pool</a> used by the CPU <code>Model</code>. The calling thread of
+<code>ParallelFor</code> takes part in the work, as thread 0, so that a pool of
+N threads only creates N-1 additional threads.
+*/
+
+#include "atmosphere/cpu/thread_pool.h"
+
+#include <algorithm>
+
+namespace atmosphere {
+namespace cpu {
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+    : task_(nullptr),
+      job_(0),
+      num_finished_threads_(0),
+      quit_(false) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    queues_.emplace_back(new Queue());
+  }
+  for (unsigned int i = 1; i < num_threads; ++i) {
+    threads_.emplace_back(&ThreadPool::Run, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  start_condition_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::ParallelFor(int count,
+    const std::function<void(int)>& task) {
+  const long long num_threads = static_cast<long long>(queues_.size());
+  for (long long i = 0; i < num_threads; ++i) {
+    Queue& queue = *queues_[i];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.indices.clear();
+    for (long long index = count * i / num_threads;
+         index < count * (i + 1) / num_threads; ++index) {
+      queue.indices.push_back(static_cast<int>(index));
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    num_finished_threads_ = 0;
+    ++job_;
+  }
+  start_condition_.notify_all();
+
+  Work(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_condition_.wait(lock, [this]() {
+    return num_finished_threads_ == threads_.size();
+  });
+  task_ = nullptr;
+}
+
+void ThreadPool::Run(unsigned int thread_index) {
+  unsigned int job = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_condition_.wait(lock, [this, job]() {
+        return quit_ || job_ != job;
+      });
+      if (quit_) {
+        return;
+      }
+      job = job_;
+    }
+    Work(thread_index);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++num_finished_threads_;
+    }
+    done_condition_.notify_one();
+  }
+}
+
+void ThreadPool::Work(unsigned int thread_index) {
+  int index;
+  while (Pop(thread_index, &index) || Steal(thread_index, &index)) {
+    (*task_)(index);
+  }
+}
+
+/*
+<p>Each thread takes the indices of its own block from the back, and steals
+those of the other blocks from the front, in order to minimize the contention
+between the owner of a block and the thieves:
+*/
+
+bool ThreadPool::Pop(unsigned int thread_index, int* index) {
+  Queue& queue = *queues_[thread_index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.indices.empty()) {
+    return false;
+  }
+  *index = queue.indices.back();
+  queue.indices.pop_back();
+  return true;
+}
+
+bool ThreadPool::Steal(unsigned int thread_index, int* index) {
+  const unsigned int num_threads = static_cast<unsigned int>(queues_.size());
+  for (unsigned int i = 1; i < num_threads; ++i) {
+    Queue& queue = *queues_[(thread_index + i) % num_threads];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.indices.empty()) {
+      *index = queue.indices.front();
+      queue.indices.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace cpu
+}  // namespace atmosphere
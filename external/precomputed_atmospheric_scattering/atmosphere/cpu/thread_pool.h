@@ -0,0 +1,65 @@
+/*<h2>atmosphere/cpu/thread_pool.h</h2>
+
+<p>This file defines a simple work-stealing thread pool, used to precompute the
+atmosphere textures on CPU. Each call to <code>ParallelFor</code> splits its
+range of indices (e.g. texture rows) into one contiguous block per thread. Each
+thread processes its own block, and then steals indices from the blocks of the
+other threads, so that the threads which get cheap texels (e.g. rays hitting the
+ground) help the others instead of waiting for them.
+*/
+
+#ifndef ATMOSPHERE_CPU_THREAD_POOL_H_
+#define ATMOSPHERE_CPU_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace atmosphere {
+namespace cpu {
+
+class ThreadPool {
+ public:
+  // Creates a pool with 'num_threads' threads, including the calling one, or
+  // with one thread per hardware thread if 'num_threads' is 0.
+  explicit ThreadPool(unsigned int num_threads = 0);
+  ~ThreadPool();
+
+  unsigned int num_threads() const {
+    return static_cast<unsigned int>(queues_.size());
+  }
+
+  // Calls 'task' for each index in [0, count), in parallel, and returns when
+  // all the calls are done. Must not be called concurrently.
+  void ParallelFor(int count, const std::function<void(int)>& task);
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<int> indices;
+  };
+
+  void Run(unsigned int thread_index);
+  void Work(unsigned int thread_index);
+  bool Pop(unsigned int thread_index, int* index);
+  bool Steal(unsigned int thread_index, int* index);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_condition_;
+  std::condition_variable done_condition_;
+  const std::function<void(int)>* task_;
+  unsigned int job_;
+  unsigned int num_finished_threads_;
+  bool quit_;
+};
+
+}  // namespace cpu
+}  // namespace atmosphere
+
+#endif  // ATMOSPHERE_CPU_THREAD_POOL_H_
@@ -319,6 +319,106 @@ DimensionlessSpectrum ComputeTransmittanceToTopAtmosphereBoundary(
               atmosphere, atmosphere.absorption_density, r, mu)));
 }
 
+/*
+<p>The number of samples used above is chosen for the worst case, i.e. for long
+and nearly horizontal rays, while most rays need much less samples to reach the
+same precision. The precomputations can thus optionally use an adaptive
+quadrature instead (see <code>Model::Init</code>), based on the first step of
+<a href="https://en.wikipedia.org/wiki/Romberg%27s_method">Romberg's
+method</a>: the number of intervals of the trapezoidal rule is doubled until the
+Richardson extrapolation of two successive estimates (i.e. Simpson's rule)
+changes by less than <code>ADAPTIVE_QUADRATURE_TOLERANCE</code>, in relative
+terms. Each doubling reuses the samples of the previous estimates, so a ray
+which converges with $2^n$ intervals costs $2^n+1$ samples. A minimum number of
+doublings is done before testing the convergence, to avoid stopping on two
+coarse estimates which agree by chance.
+
+<p>The extrapolation assumes a smooth integrand, which is the case for the
+exponential density profiles of air molecules and aerosols, but not for the
+piecewise linear profile of ozone (whose kinks would make the convergence test
+unreliable). The adaptive quadrature is thus only used for density profiles
+made of a single exponential layer, the other ones being integrated with the
+above function:
+*/
+
+#if defined(ADAPTIVE_TRANSMITTANCE_QUADRATURE) || defined(ADAPTIVE_SINGLE_SCATTERING_QUADRATURE) || defined(ADAPTIVE_SCATTERING_DENSITY_QUADRATURE) || defined(ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE)
+const Number ADAPTIVE_QUADRATURE_TOLERANCE = 1e-3;
+#endif
+
+#ifdef ADAPTIVE_TRANSMITTANCE_QUADRATURE
+bool IsExponentialProfile(IN(DensityProfile) profile) {
+  return profile.layers[0].width <= 0.0 * m &&
+      profile.layers[1].linear_term == 0.0 / m &&
+      profile.layers[1].constant_term == 0.0;
+}
+
+Length ComputeExponentialOpticalLengthToTopAtmosphereBoundary(
+    IN(AtmosphereParameters) atmosphere, IN(DensityProfile) profile,
+    Length r, Number mu) {
+  assert(r >= atmosphere.bottom_radius && r <= atmosphere.top_radius);
+  assert(mu >= -1.0 && mu <= 1.0);
+  // Minimum and maximum number of doublings of the number of intervals. At most
+  // 2^8+1=257 samples, i.e. about half of the fixed quadrature above.
+  const int MIN_LEVEL = 6;
+  const int MAX_LEVEL = 8;
+  Length d_max = DistanceToTopAtmosphereBoundary(atmosphere, r, mu);
+  Length r_max = sqrt(d_max * d_max + 2.0 * r * mu * d_max + r * r);
+  // Trapezoidal rule with a single interval.
+  Length trapezoid = 0.5 * d_max * (
+      GetProfileDensity(profile, r - atmosphere.bottom_radius) +
+      GetProfileDensity(profile, r_max - atmosphere.bottom_radius));
+  Length simpson = trapezoid;
+  int num_intervals = 1;
+  for (int level = 1; level <= MAX_LEVEL; ++level) {
+    // The new samples are at the middle of the current intervals.
+    Length dx = d_max / Number(2 * num_intervals);
+    Number sum = 0.0;
+    for (int i = 0; i < num_intervals; ++i) {
+      Length d_i = Number(2 * i + 1) * dx;
+      Length r_i = sqrt(d_i * d_i + 2.0 * r * mu * d_i + r * r);
+      sum += GetProfileDensity(profile, r_i - atmosphere.bottom_radius);
+    }
+    Length next_trapezoid = 0.5 * trapezoid + sum * dx;
+    Length next_simpson = (4.0 * next_trapezoid - trapezoid) / 3.0;
+    Length error = next_simpson - simpson;
+    trapezoid = next_trapezoid;
+    simpson = next_simpson;
+    num_intervals *= 2;
+    if (level >= MIN_LEVEL && error * error <=
+        ADAPTIVE_QUADRATURE_TOLERANCE * ADAPTIVE_QUADRATURE_TOLERANCE *
+            simpson * simpson) {
+      break;
+    }
+  }
+  return simpson;
+}
+
+Length ComputeOpticalLengthToTopAtmosphereBoundaryAdaptive(
+    IN(AtmosphereParameters) atmosphere, IN(DensityProfile) profile,
+    Length r, Number mu) {
+  return IsExponentialProfile(profile) ?
+      ComputeExponentialOpticalLengthToTopAtmosphereBoundary(
+          atmosphere, profile, r, mu) :
+      ComputeOpticalLengthToTopAtmosphereBoundary(atmosphere, profile, r, mu);
+}
+
+DimensionlessSpectrum ComputeTransmittanceToTopAtmosphereBoundaryAdaptive(
+    IN(AtmosphereParameters) atmosphere, Length r, Number mu) {
+  assert(r >= atmosphere.bottom_radius && r <= atmosphere.top_radius);
+  assert(mu >= -1.0 && mu <= 1.0);
+  return exp(-(
+      atmosphere.rayleigh_scattering *
+          ComputeOpticalLengthToTopAtmosphereBoundaryAdaptive(
+              atmosphere, atmosphere.rayleigh_density, r, mu) +
+      atmosphere.mie_extinction *
+          ComputeOpticalLengthToTopAtmosphereBoundaryAdaptive(
+              atmosphere, atmosphere.mie_density, r, mu) +
+      atmosphere.absorption_extinction *
+          ComputeOpticalLengthToTopAtmosphereBoundaryAdaptive(
+              atmosphere, atmosphere.absorption_density, r, mu)));
+}
+#endif
+
 /*
 <h4 id="transmittance_precomputation">Precomputation</h4>
 
@@ -459,7 +559,11 @@ DimensionlessSpectrum ComputeTransmittanceToTopAtmosphereBoundaryTexture(
   Number mu;
   GetRMuFromTransmittanceTextureUv(
       atmosphere, frag_coord / TRANSMITTANCE_TEXTURE_SIZE, r, mu);
+#ifdef ADAPTIVE_TRANSMITTANCE_QUADRATURE
+  return ComputeTransmittanceToTopAtmosphereBoundaryAdaptive(atmosphere, r, mu);
+#else
   return ComputeTransmittanceToTopAtmosphereBoundary(atmosphere, r, mu);
+#endif
 }
 
 /*
@@ -729,6 +833,99 @@ void ComputeSingleScattering(
   mie = mie_sum * dx * source_irradiance * atmosphere.mie_scattering;
 }
 
+/*
+<p>As for the transmittance, this integral can optionally be computed with an
+adaptive quadrature. Here the integrand is a spectrum, and the convergence test
+uses the Euclidean norm of the Rayleigh and Mie estimates, separately (a few
+samples are usually enough for short rays or rays in the Earth shadow, while
+grazing rays near the terminator need more of them):
+*/
+
+#if defined(ADAPTIVE_SINGLE_SCATTERING_QUADRATURE) || defined(ADAPTIVE_SCATTERING_DENSITY_QUADRATURE) || defined(ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE)
+bool IsConverged(IN(vec3) error, IN(vec3) value) {
+  return dot(error, error) <= ADAPTIVE_QUADRATURE_TOLERANCE *
+      ADAPTIVE_QUADRATURE_TOLERANCE * dot(value, value);
+}
+#endif
+
+#ifdef ADAPTIVE_SINGLE_SCATTERING_QUADRATURE
+void ComputeSingleScatteringAdaptive(
+    IN(AtmosphereParameters) atmosphere,
+    IN(TransmittanceTexture) transmittance_texture,
+    Length r, Number mu, Number mu_s, Number nu,
+    bool ray_r_mu_intersects_ground, Angle source_angular_radius,
+    IrradianceSpectrum source_irradiance,
+    OUT(IrradianceSpectrum) rayleigh, OUT(IrradianceSpectrum) mie) {
+  assert(r >= atmosphere.bottom_radius && r <= atmosphere.top_radius);
+  assert(mu >= -1.0 && mu <= 1.0);
+  assert(mu_s >= -1.0 && mu_s <= 1.0);
+  assert(nu >= -1.0 && nu <= 1.0);
+
+  // Minimum and maximum number of doublings of the number of intervals.
+  const int MIN_LEVEL = 3;
+  const int MAX_LEVEL = 5;
+  Length d_max = DistanceToNearestAtmosphereBoundary(atmosphere, r, mu,
+      ray_r_mu_intersects_ground);
+  // Trapezoidal rule with a single interval (divided by the interval length, so
+  // that all the estimates below are dimensionless).
+  DimensionlessSpectrum rayleigh_0;
+  DimensionlessSpectrum mie_0;
+  DimensionlessSpectrum rayleigh_1;
+  DimensionlessSpectrum mie_1;
+  ComputeSingleScatteringIntegrand(atmosphere, transmittance_texture,
+      r, mu, mu_s, nu, 0.0 * m, ray_r_mu_intersects_ground,
+      source_angular_radius, rayleigh_0, mie_0);
+  ComputeSingleScatteringIntegrand(atmosphere, transmittance_texture,
+      r, mu, mu_s, nu, d_max, ray_r_mu_intersects_ground,
+      source_angular_radius, rayleigh_1, mie_1);
+  DimensionlessSpectrum rayleigh_trapezoid = 0.5 * (rayleigh_0 + rayleigh_1);
+  DimensionlessSpectrum mie_trapezoid = 0.5 * (mie_0 + mie_1);
+  DimensionlessSpectrum rayleigh_simpson = rayleigh_trapezoid;
+  DimensionlessSpectrum mie_simpson = mie_trapezoid;
+  int num_intervals = 1;
+  for (int level = 1; level <= MAX_LEVEL; ++level) {
+    // The new samples are at the middle of the current intervals.
+    Length dx = d_max / Number(2 * num_intervals);
+    Number weight = 1.0 / Number(2 * num_intervals);
+    DimensionlessSpectrum rayleigh_sum = DimensionlessSpectrum(0.0);
+    DimensionlessSpectrum mie_sum = DimensionlessSpectrum(0.0);
+    for (int i = 0; i < num_intervals; ++i) {
+      DimensionlessSpectrum rayleigh_i;
+      DimensionlessSpectrum mie_i;
+      ComputeSingleScatteringIntegrand(atmosphere, transmittance_texture,
+          r, mu, mu_s, nu, Number(2 * i + 1) * dx, ray_r_mu_intersects_ground,
+          source_angular_radius, rayleigh_i, mie_i);
+      rayleigh_sum += rayleigh_i;
+      mie_sum += mie_i;
+    }
+    DimensionlessSpectrum next_rayleigh_trapezoid =
+        0.5 * rayleigh_trapezoid + rayleigh_sum * weight;
+    DimensionlessSpectrum next_mie_trapezoid =
+        0.5 * mie_trapezoid + mie_sum * weight;
+    DimensionlessSpectrum next_rayleigh_simpson =
+        (4.0 * next_rayleigh_trapezoid - rayleigh_trapezoid) / 3.0;
+    DimensionlessSpectrum next_mie_simpson =
+        (4.0 * next_mie_trapezoid - mie_trapezoid) / 3.0;
+    DimensionlessSpectrum rayleigh_error =
+        next_rayleigh_simpson - rayleigh_simpson;
+    DimensionlessSpectrum mie_error = next_mie_simpson - mie_simpson;
+    rayleigh_trapezoid = next_rayleigh_trapezoid;
+    mie_trapezoid = next_mie_trapezoid;
+    rayleigh_simpson = next_rayleigh_simpson;
+    mie_simpson = next_mie_simpson;
+    num_intervals *= 2;
+    if (level >= MIN_LEVEL &&
+        IsConverged(rayleigh_error, rayleigh_simpson) &&
+        IsConverged(mie_error, mie_simpson)) {
+      break;
+    }
+  }
+  rayleigh = rayleigh_simpson * d_max * source_irradiance *
+      atmosphere.rayleigh_scattering;
+  mie = mie_simpson * d_max * source_irradiance * atmosphere.mie_scattering;
+}
+#endif
+
 /*
 <p>Note that we added the solar irradiance and the scattering coefficient terms
 that we omitted in <code>ComputeSingleScatteringIntegrand</code>, but not the
@@ -940,8 +1137,14 @@ void ComputeSingleScatteringTexture(IN(AtmosphereParameters) atmosphere,
   bool ray_r_mu_intersects_ground;
   GetRMuMuSNuFromScatteringTextureFragCoord(atmosphere, frag_coord,
       r, mu, mu_s, nu, ray_r_mu_intersects_ground);
+#ifdef ADAPTIVE_SINGLE_SCATTERING_QUADRATURE
+  ComputeSingleScatteringAdaptive(atmosphere, transmittance_texture,
+      r, mu, mu_s, nu, ray_r_mu_intersects_ground, source_angular_radius,
+      source_irradiance, rayleigh, mie);
+#else
   ComputeSingleScattering(atmosphere, transmittance_texture,
       r, mu, mu_s, nu, ray_r_mu_intersects_ground, source_angular_radius, source_irradiance, rayleigh, mie);
+#endif
 }
 
 /*
@@ -1160,6 +1363,55 @@ received on the ground after $n-2$ bounces, and <code>scattering_order</code> is
 equal to $n$):</li>
 */
 
+RadianceDensitySpectrum ComputeScatteringDensityIntegrand(
+    IN(AtmosphereParameters) atmosphere,
+    IN(ReducedScatteringTexture) single_rayleigh_scattering_texture,
+    IN(ReducedScatteringTexture) single_mie_scattering_texture,
+    IN(ScatteringTexture) multiple_scattering_texture,
+    IN(IrradianceTexture) irradiance_texture,
+    Length r, Number mu_s, IN(vec3) omega, IN(vec3) omega_s, IN(vec3) omega_i,
+    bool ray_r_theta_intersects_ground, Length distance_to_ground,
+    IN(DimensionlessSpectrum) transmittance_to_ground,
+    IN(DimensionlessSpectrum) ground_albedo, int scattering_order) {
+  vec3 zenith_direction = vec3(0.0, 0.0, 1.0);
+
+  // The radiance L_i arriving from direction omega_i after n-1 bounces is
+  // the sum of a term given by the precomputed scattering texture for the
+  // (n-1)-th order:
+  Number nu1 = dot(omega_s, omega_i);
+  RadianceSpectrum incident_radiance = GetScattering(atmosphere,
+      single_rayleigh_scattering_texture, single_mie_scattering_texture,
+      multiple_scattering_texture, r, omega_i.z, mu_s, nu1,
+      ray_r_theta_intersects_ground, scattering_order - 1);
+
+  // and of the contribution from the light paths with n-1 bounces and whose
+  // last bounce is on the ground. This contribution is the product of the
+  // transmittance to the ground, the ground albedo, the ground BRDF, and
+  // the irradiance received on the ground after n-2 bounces.
+  vec3 ground_normal =
+      normalize(zenith_direction * r + omega_i * distance_to_ground);
+  IrradianceSpectrum ground_irradiance = GetIrradiance(
+      atmosphere, irradiance_texture, atmosphere.bottom_radius,
+      dot(ground_normal, omega_s));
+  incident_radiance += transmittance_to_ground *
+      ground_albedo * (1.0 / (PI * sr)) * ground_irradiance;
+
+  // The radiance finally scattered from direction omega_i towards direction
+  // -omega is the product of the incident radiance, the scattering
+  // coefficient, and the phase function for directions omega and omega_i
+  // (all this summed over all particle types, i.e. Rayleigh and Mie).
+  Number nu2 = dot(omega, omega_i);
+  Number rayleigh_density = GetProfileDensity(
+      atmosphere.rayleigh_density, r - atmosphere.bottom_radius);
+  Number mie_density = GetProfileDensity(
+      atmosphere.mie_density, r - atmosphere.bottom_radius);
+  return incident_radiance * (
+      atmosphere.rayleigh_scattering * rayleigh_density *
+          RayleighPhaseFunction(nu2) +
+      atmosphere.mie_scattering * mie_density *
+          MiePhaseFunction(atmosphere.mie_phase_function_g, nu2));
+}
+
 RadianceDensitySpectrum ComputeScatteringDensity(
     IN(AtmosphereParameters) atmosphere,
     IN(TransmittanceTexture) transmittance_texture,
@@ -1178,7 +1430,6 @@ RadianceDensitySpectrum ComputeScatteringDensity(
   // and the sun direction omega_s, such that the cosine of the view-zenith
   // angle is mu, the cosine of the sun-zenith angle is mu_s, and the cosine of
   // the view-sun angle is nu. The goal is to simplify computations below.
-  vec3 zenith_direction = vec3(0.0, 0.0, 1.0);
   vec3 omega = vec3(sqrt(1.0 - mu * mu), 0.0, mu);
   Number sun_dir_x = omega.x == 0.0 ? 0.0 : (nu - mu * mu_s) / omega.x;
   Number sun_dir_y = sqrt(max(1.0 - sun_dir_x * sun_dir_x - mu_s * mu_s, 0.0));
@@ -1217,48 +1468,118 @@ RadianceDensitySpectrum ComputeScatteringDensity(
       vec3 omega_i =
           vec3(cos(phi) * sin_theta, sin(phi) * sin_theta, cos_theta);
       SolidAngle domega_i = (dtheta / rad) * (dphi / rad) * sin(theta) * sr;
-
-      // The radiance L_i arriving from direction omega_i after n-1 bounces is
-      // the sum of a term given by the precomputed scattering texture for the
-      // (n-1)-th order:
-      Number nu1 = dot(omega_s, omega_i);
-      RadianceSpectrum incident_radiance = GetScattering(atmosphere,
+      rayleigh_mie += ComputeScatteringDensityIntegrand(atmosphere,
           single_rayleigh_scattering_texture, single_mie_scattering_texture,
-          multiple_scattering_texture, r, omega_i.z, mu_s, nu1,
-          ray_r_theta_intersects_ground, scattering_order - 1);
-
-      // and of the contribution from the light paths with n-1 bounces and whose
-      // last bounce is on the ground. This contribution is the product of the
-      // transmittance to the ground, the ground albedo, the ground BRDF, and
-      // the irradiance received on the ground after n-2 bounces.
-      vec3 ground_normal =
-          normalize(zenith_direction * r + omega_i * distance_to_ground);
-      IrradianceSpectrum ground_irradiance = GetIrradiance(
-          atmosphere, irradiance_texture, atmosphere.bottom_radius,
-          dot(ground_normal, omega_s));
-      incident_radiance += transmittance_to_ground *
-          ground_albedo * (1.0 / (PI * sr)) * ground_irradiance;
-
-      // The radiance finally scattered from direction omega_i towards direction
-      // -omega is the product of the incident radiance, the scattering
-      // coefficient, and the phase function for directions omega and omega_i
-      // (all this summed over all particle types, i.e. Rayleigh and Mie).
-      Number nu2 = dot(omega, omega_i);
-      Number rayleigh_density = GetProfileDensity(
-          atmosphere.rayleigh_density, r - atmosphere.bottom_radius);
-      Number mie_density = GetProfileDensity(
-          atmosphere.mie_density, r - atmosphere.bottom_radius);
-      rayleigh_mie += incident_radiance * (
-          atmosphere.rayleigh_scattering * rayleigh_density *
-              RayleighPhaseFunction(nu2) +
-          atmosphere.mie_scattering * mie_density *
-              MiePhaseFunction(atmosphere.mie_phase_function_g, nu2)) *
+          multiple_scattering_texture, irradiance_texture, r, mu_s, omega,
+          omega_s, omega_i,
+          ray_r_theta_intersects_ground, distance_to_ground,
+          transmittance_to_ground, ground_albedo, scattering_order) *
           domega_i;
     }
   }
   return rayleigh_mie;
 }
 
+/*
+<p>Most of the cost of the precomputations is in this function, which is
+evaluated for each texel of each scattering order with 512 samples, each one
+requiring several texture lookups. Its adaptive version keeps the same samples
+for $\theta$, but integrates over $\phi$ with the trapezoidal rule for periodic
+functions (which converges much faster than for non-periodic ones, and whose
+samples are nested when their number is doubled). It starts with 4 samples per
+$\theta$ value, and doubles this number until the estimate changes by less than
+<code>ADAPTIVE_QUADRATURE_TOLERANCE</code>, in relative terms, or until it
+reaches the 32 samples used above (the samples being then the same as above):
+*/
+
+#ifdef ADAPTIVE_SCATTERING_DENSITY_QUADRATURE
+RadianceDensitySpectrum ComputeScatteringDensityAdaptive(
+    IN(AtmosphereParameters) atmosphere,
+    IN(TransmittanceTexture) transmittance_texture,
+    IN(ReducedScatteringTexture) single_rayleigh_scattering_texture,
+    IN(ReducedScatteringTexture) single_mie_scattering_texture,
+    IN(ScatteringTexture) multiple_scattering_texture,
+    IN(IrradianceTexture) irradiance_texture,
+    Length r, Number mu, Number mu_s, Number nu, int scattering_order) {
+  assert(r >= atmosphere.bottom_radius && r <= atmosphere.top_radius);
+  assert(mu >= -1.0 && mu <= 1.0);
+  assert(mu_s >= -1.0 && mu_s <= 1.0);
+  assert(nu >= -1.0 && nu <= 1.0);
+  assert(scattering_order >= 2);
+
+  vec3 omega = vec3(sqrt(1.0 - mu * mu), 0.0, mu);
+  Number sun_dir_x = omega.x == 0.0 ? 0.0 : (nu - mu * mu_s) / omega.x;
+  Number sun_dir_y = sqrt(max(1.0 - sun_dir_x * sun_dir_x - mu_s * mu_s, 0.0));
+  vec3 omega_s = vec3(sun_dir_x, sun_dir_y, mu_s);
+
+  const int SAMPLE_COUNT = 16;
+  const int MIN_PHI_SAMPLE_COUNT = 4;
+  const int MAX_PHI_SAMPLE_COUNT = 2 * SAMPLE_COUNT;
+  const Angle dtheta = pi / Number(SAMPLE_COUNT);
+  // Offset of the phi samples, such that they are the same as in the fixed
+  // sample count version with MAX_PHI_SAMPLE_COUNT samples.
+  const Angle phi_0 = pi / Number(MAX_PHI_SAMPLE_COUNT);
+  RadianceDensitySpectrum rayleigh_mie =
+      RadianceDensitySpectrum(0.0 * watt_per_cubic_meter_per_sr_per_nm);
+
+  for (int l = 0; l < SAMPLE_COUNT; ++l) {
+    Angle theta = (Number(l) + 0.5) * dtheta;
+    Number cos_theta = cos(theta);
+    Number sin_theta = sin(theta);
+    bool ray_r_theta_intersects_ground =
+        RayIntersectsGround(atmosphere, r, cos_theta);
+
+    Length distance_to_ground = 0.0 * m;
+    DimensionlessSpectrum transmittance_to_ground = DimensionlessSpectrum(0.0);
+    DimensionlessSpectrum ground_albedo = DimensionlessSpectrum(0.0);
+    if (ray_r_theta_intersects_ground) {
+      distance_to_ground =
+          DistanceToBottomAtmosphereBoundary(atmosphere, r, cos_theta);
+      transmittance_to_ground =
+          GetTransmittance(atmosphere, transmittance_texture, r, cos_theta,
+              distance_to_ground, true /* ray_intersects_ground */);
+      ground_albedo = atmosphere.ground_albedo;
+    }
+
+    // Integration loop over phi, with sample indices k in units of 2 phi_0. The
+    // first MIN_PHI_SAMPLE_COUNT samples are evenly spaced, and each following
+    // iteration adds one sample in the middle of each pair of adjacent ones.
+    RadianceDensitySpectrum sum =
+        RadianceDensitySpectrum(0.0 * watt_per_cubic_meter_per_sr_per_nm);
+    RadianceDensitySpectrum mean = sum;
+    int first = 0;
+    int stride = MAX_PHI_SAMPLE_COUNT / MIN_PHI_SAMPLE_COUNT;
+    int num_samples = MIN_PHI_SAMPLE_COUNT;
+    while (num_samples <= MAX_PHI_SAMPLE_COUNT) {
+      for (int k = first; k < MAX_PHI_SAMPLE_COUNT; k += stride) {
+        Angle phi = Number(2 * k + 1) * phi_0;
+        vec3 omega_i =
+            vec3(cos(phi) * sin_theta, sin(phi) * sin_theta, cos_theta);
+        sum += ComputeScatteringDensityIntegrand(atmosphere,
+            single_rayleigh_scattering_texture, single_mie_scattering_texture,
+            multiple_scattering_texture, irradiance_texture, r, mu_s, omega,
+          omega_s, omega_i,
+            ray_r_theta_intersects_ground, distance_to_ground,
+            transmittance_to_ground, ground_albedo, scattering_order);
+      }
+      RadianceDensitySpectrum next_mean = sum / Number(num_samples);
+      bool converged = num_samples > MIN_PHI_SAMPLE_COUNT &&
+          IsConverged(next_mean - mean, next_mean);
+      mean = next_mean;
+      if (converged) {
+        break;
+      }
+      first = (first == 0 ? stride : first) / 2;
+      stride = 2 * first;
+      num_samples *= 2;
+    }
+    SolidAngle domega = (dtheta / rad) * (2.0 * pi / rad) * sin_theta * sr;
+    rayleigh_mie += mean * domega;
+  }
+  return rayleigh_mie;
+}
+#endif
+
 /*
 <h5 id="multiple_scattering_second_step">Second step</h5>
 
@@ -1282,6 +1603,29 @@ instead, using the actual ground albedo.
 <p>The implementation for this second step is straightforward:
 */
 
+RadianceDensitySpectrum ComputeMultipleScatteringIntegrand(
+    IN(AtmosphereParameters) atmosphere,
+    IN(TransmittanceTexture) transmittance_texture,
+    IN(ScatteringDensityTexture) scattering_density_texture,
+    Length r, Number mu, Number mu_s, Number nu, Length d,
+    bool ray_r_mu_intersects_ground) {
+  // The r, mu and mu_s parameters at the current integration point (see the
+  // single scattering section for a detailed explanation).
+  Length r_d =
+      ClampRadius(atmosphere, sqrt(d * d + 2.0 * r * mu * d + r * r));
+  Number mu_d = ClampCosine((r * mu + d) / r_d);
+  Number mu_s_d = ClampCosine((r * mu_s + d * nu) / r_d);
+
+  // The Rayleigh and Mie multiple scattering at the current sample point.
+  return
+      GetScattering(
+          atmosphere, scattering_density_texture, r_d, mu_d, mu_s_d, nu,
+          ray_r_mu_intersects_ground) *
+      GetTransmittance(
+          atmosphere, transmittance_texture, r, mu, d,
+          ray_r_mu_intersects_ground);
+}
+
 RadianceSpectrum ComputeMultipleScattering(
     IN(AtmosphereParameters) atmosphere,
     IN(TransmittanceTexture) transmittance_texture,
@@ -1305,23 +1649,10 @@ RadianceSpectrum ComputeMultipleScattering(
       RadianceSpectrum(0.0 * watt_per_square_meter_per_sr_per_nm);
   for (int i = 0; i <= SAMPLE_COUNT; ++i) {
     Length d_i = Number(i) * dx;
-
-    // The r, mu and mu_s parameters at the current integration point (see the
-    // single scattering section for a detailed explanation).
-    Length r_i =
-        ClampRadius(atmosphere, sqrt(d_i * d_i + 2.0 * r * mu * d_i + r * r));
-    Number mu_i = ClampCosine((r * mu + d_i) / r_i);
-    Number mu_s_i = ClampCosine((r * mu_s + d_i * nu) / r_i);
-
-    // The Rayleigh and Mie multiple scattering at the current sample point.
     RadianceSpectrum rayleigh_mie_i =
-        GetScattering(
-            atmosphere, scattering_density_texture, r_i, mu_i, mu_s_i, nu,
-            ray_r_mu_intersects_ground) *
-        GetTransmittance(
-            atmosphere, transmittance_texture, r, mu, d_i,
-            ray_r_mu_intersects_ground) *
-        dx;
+        ComputeMultipleScatteringIntegrand(atmosphere, transmittance_texture,
+            scattering_density_texture, r, mu, mu_s, nu, d_i,
+            ray_r_mu_intersects_ground) * dx;
     // Sample weight (from the trapezoidal rule).
     Number weight_i = (i == 0 || i == SAMPLE_COUNT) ? 0.5 : 1.0;
     rayleigh_mie_sum += rayleigh_mie_i * weight_i;
@@ -1329,6 +1660,65 @@ RadianceSpectrum ComputeMultipleScattering(
   return rayleigh_mie_sum;
 }
 
+/*
+<p>This integral can also be computed with the adaptive quadrature used for
+single scattering:
+*/
+
+#ifdef ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE
+RadianceSpectrum ComputeMultipleScatteringAdaptive(
+    IN(AtmosphereParameters) atmosphere,
+    IN(TransmittanceTexture) transmittance_texture,
+    IN(ScatteringDensityTexture) scattering_density_texture,
+    Length r, Number mu, Number mu_s, Number nu,
+    bool ray_r_mu_intersects_ground) {
+  assert(r >= atmosphere.bottom_radius && r <= atmosphere.top_radius);
+  assert(mu >= -1.0 && mu <= 1.0);
+  assert(mu_s >= -1.0 && mu_s <= 1.0);
+  assert(nu >= -1.0 && nu <= 1.0);
+
+  // Minimum and maximum number of doublings of the number of intervals.
+  const int MIN_LEVEL = 3;
+  const int MAX_LEVEL = 5;
+  Length d_max = DistanceToNearestAtmosphereBoundary(
+      atmosphere, r, mu, ray_r_mu_intersects_ground);
+  // Trapezoidal rule with a single interval (divided by the interval length).
+  RadianceDensitySpectrum trapezoid = 0.5 * (
+      ComputeMultipleScatteringIntegrand(atmosphere, transmittance_texture,
+          scattering_density_texture, r, mu, mu_s, nu, 0.0 * m,
+          ray_r_mu_intersects_ground) +
+      ComputeMultipleScatteringIntegrand(atmosphere, transmittance_texture,
+          scattering_density_texture, r, mu, mu_s, nu, d_max,
+          ray_r_mu_intersects_ground));
+  RadianceDensitySpectrum simpson = trapezoid;
+  int num_intervals = 1;
+  for (int level = 1; level <= MAX_LEVEL; ++level) {
+    // The new samples are at the middle of the current intervals.
+    Length dx = d_max / Number(2 * num_intervals);
+    RadianceDensitySpectrum sum =
+        RadianceDensitySpectrum(0.0 * watt_per_cubic_meter_per_sr_per_nm);
+    for (int i = 0; i < num_intervals; ++i) {
+      sum += ComputeMultipleScatteringIntegrand(atmosphere,
+          transmittance_texture, scattering_density_texture,
+          r, mu, mu_s, nu, Number(2 * i + 1) * dx,
+          ray_r_mu_intersects_ground);
+    }
+    RadianceDensitySpectrum next_trapezoid =
+        0.5 * trapezoid + sum / Number(2 * num_intervals);
+    RadianceDensitySpectrum next_simpson =
+        (4.0 * next_trapezoid - trapezoid) / 3.0;
+    RadianceDensitySpectrum error = next_simpson - simpson;
+    trapezoid = next_trapezoid;
+    simpson = next_simpson;
+    num_intervals *= 2;
+    if (level >= MIN_LEVEL && IsConverged(error, simpson)) {
+      break;
+    }
+  }
+  return simpson * d_max;
+}
+#endif
+
 /*
 <h4 id="multiple_scattering_precomputation">Precomputation</h4>
 
@@ -1360,10 +1750,17 @@ RadianceDensitySpectrum ComputeScatteringDensityTexture(
   bool ray_r_mu_intersects_ground;
   GetRMuMuSNuFromScatteringTextureFragCoord(atmosphere, frag_coord,
       r, mu, mu_s, nu, ray_r_mu_intersects_ground);
+#ifdef ADAPTIVE_SCATTERING_DENSITY_QUADRATURE
+  return ComputeScatteringDensityAdaptive(atmosphere, transmittance_texture,
+      single_rayleigh_scattering_texture, single_mie_scattering_texture,
+      multiple_scattering_texture, irradiance_texture, r, mu, mu_s, nu,
+      scattering_order);
+#else
   return ComputeScatteringDensity(atmosphere, transmittance_texture,
       single_rayleigh_scattering_texture, single_mie_scattering_texture,
       multiple_scattering_texture, irradiance_texture, r, mu, mu_s, nu,
       scattering_order);
+#endif
 }
 
 RadianceSpectrum ComputeMultipleScatteringTexture(
@@ -1377,9 +1774,15 @@ RadianceSpectrum ComputeMultipleScatteringTexture(
   bool ray_r_mu_intersects_ground;
   GetRMuMuSNuFromScatteringTextureFragCoord(atmosphere, frag_coord,
       r, mu, mu_s, nu, ray_r_mu_intersects_ground);
+#ifdef ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE
+  return ComputeMultipleScatteringAdaptive(atmosphere, transmittance_texture,
+      scattering_density_texture, r, mu, mu_s, nu,
+      ray_r_mu_intersects_ground);
+#else
   return ComputeMultipleScattering(atmosphere, transmittance_texture,
       scattering_density_texture, r, mu, mu_s, nu,
       ray_r_mu_intersects_ground);
+#endif
 }
 
 /*
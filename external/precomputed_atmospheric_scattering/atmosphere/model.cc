@@ -45,13 +45,30 @@ of the following C++ code.
 
 #include <glad/glad.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 
 #include "atmosphere/constants.h"
 
+// OpenGL 4.3 constants used by the compute shader precomputations, which are
+// not provided by our OpenGL 3.3 loader.
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_UPDATE_BARRIER_BIT
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+#endif
+
 /*
 <p>The rest of this file is organized in 3 parts:
 <ul>
@@ -223,6 +240,181 @@ const char kComputeMultipleScatteringShader[] = R"(
           0.0);
     })";
 
+/*
+<p>The same precomputations can also be done with compute shaders, if OpenGL 4.3
+is available. Each compute shader invocation computes one texel, which it writes
+directly in the output textures with image stores (instead of rendering one full
+screen quad per layer of the 3D textures). The additive blending of the
+fragment shaders is replaced with explicit image loads (this works because each
+texel is read and written by only one invocation). Note that the image formats
+must be RGBA, because RGB formats are not supported for image load and store
+operations:
+*/
+
+const char kTransmittanceComputeShader[] = R"(
+    layout(local_size_x = 8, local_size_y = 8) in;
+    layout(binding = 0, rgba32f) uniform writeonly image2D transmittance;
+    void main() {
+      ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+      if (any(greaterThanEqual(texel, ivec2(TRANSMITTANCE_TEXTURE_WIDTH,
+          TRANSMITTANCE_TEXTURE_HEIGHT)))) {
+        return;
+      }
+      imageStore(transmittance, texel,
+          vec4(ComputeTransmittanceToTopAtmosphereBoundaryTexture(
+              ATMOSPHERE, vec2(texel) + vec2(0.5)), 1.0));
+    })";
+
+const char kDirectIrradianceComputeShader[] = R"(
+    layout(local_size_x = 8, local_size_y = 8) in;
+    layout(binding = 0, rgba32f) uniform writeonly image2D delta_irradiance;
+    layout(binding = 1, rgba32f) uniform image2D irradiance;
+    uniform sampler2D transmittance_texture;
+    uniform int source;
+    uniform bool blend;
+    void main() {
+      ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+      if (any(greaterThanEqual(texel, ivec2(IRRADIANCE_TEXTURE_WIDTH,
+          IRRADIANCE_TEXTURE_HEIGHT)))) {
+        return;
+      }
+      Angle source_angular_radius = ATMOSPHERE.sun_angular_radius;
+      IrradianceSpectrum source_irradiance = ATMOSPHERE.sun_irradiance;
+      if (source != 0)
+      {
+          source_angular_radius = ATMOSPHERE.moon_angular_radius;
+          source_irradiance = ATMOSPHERE.moon_irradiance;
+      }
+      imageStore(delta_irradiance, texel, vec4(ComputeDirectIrradianceTexture(
+          ATMOSPHERE, transmittance_texture, source_angular_radius,
+          source_irradiance, vec2(texel) + vec2(0.5)), 1.0));
+      if (!blend) {
+        imageStore(irradiance, texel, vec4(0.0, 0.0, 0.0, 1.0));
+      }
+    })";
+
+const char kSingleScatteringComputeShader[] = R"(
+    layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+    layout(binding = 0, rgba32f) uniform writeonly image3D delta_rayleigh;
+    layout(binding = 1, rgba32f) uniform writeonly image3D delta_mie;
+    layout(binding = 2, rgba32f) uniform image3D scattering;
+    #ifndef COMBINED_SCATTERING_TEXTURES
+    layout(binding = 3, rgba32f) uniform image3D single_mie_scattering;
+    #endif
+    uniform mat3 luminance_from_radiance;
+    uniform sampler2D transmittance_texture;
+    uniform int source;
+    uniform bool blend;
+    void main() {
+      ivec3 texel = ivec3(gl_GlobalInvocationID);
+      if (any(greaterThanEqual(texel, ivec3(SCATTERING_TEXTURE_WIDTH,
+          SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH)))) {
+        return;
+      }
+      Angle source_angular_radius = ATMOSPHERE.sun_angular_radius;
+      IrradianceSpectrum source_irradiance = ATMOSPHERE.sun_irradiance;
+      if (source != 0)
+      {
+          source_angular_radius = ATMOSPHERE.moon_angular_radius;
+          source_irradiance = ATMOSPHERE.moon_irradiance;
+      }
+      IrradianceSpectrum rayleigh;
+      IrradianceSpectrum mie;
+      ComputeSingleScatteringTexture(
+          ATMOSPHERE, transmittance_texture, source_angular_radius,
+          source_irradiance, vec3(texel) + vec3(0.5), rayleigh, mie);
+      imageStore(delta_rayleigh, texel, vec4(rayleigh, 1.0));
+      imageStore(delta_mie, texel, vec4(mie, 1.0));
+      vec4 scattering_value = vec4(luminance_from_radiance * rayleigh,
+          (luminance_from_radiance * mie).r);
+      if (blend) {
+        scattering_value += imageLoad(scattering, texel);
+      }
+      imageStore(scattering, texel, scattering_value);
+      #ifndef COMBINED_SCATTERING_TEXTURES
+      vec4 single_mie_scattering_value =
+          vec4(luminance_from_radiance * mie, 1.0);
+      if (blend) {
+        single_mie_scattering_value.rgb +=
+            imageLoad(single_mie_scattering, texel).rgb;
+      }
+      imageStore(single_mie_scattering, texel, single_mie_scattering_value);
+      #endif
+    })";
+
+const char kScatteringDensityComputeShader[] = R"(
+    layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+    layout(binding = 0, rgba32f) uniform writeonly image3D scattering_density;
+    uniform sampler2D transmittance_texture;
+    uniform sampler3D single_rayleigh_scattering_texture;
+    uniform sampler3D single_mie_scattering_texture;
+    uniform sampler3D multiple_scattering_texture;
+    uniform sampler2D irradiance_texture;
+    uniform int scattering_order;
+    void main() {
+      ivec3 texel = ivec3(gl_GlobalInvocationID);
+      if (any(greaterThanEqual(texel, ivec3(SCATTERING_TEXTURE_WIDTH,
+          SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH)))) {
+        return;
+      }
+      imageStore(scattering_density, texel, vec4(
+          ComputeScatteringDensityTexture(
+              ATMOSPHERE, transmittance_texture,
+              single_rayleigh_scattering_texture,
+              single_mie_scattering_texture, multiple_scattering_texture,
+              irradiance_texture, vec3(texel) + vec3(0.5), scattering_order),
+          1.0));
+    })";
+
+const char kIndirectIrradianceComputeShader[] = R"(
+    layout(local_size_x = 8, local_size_y = 8) in;
+    layout(binding = 0, rgba32f) uniform writeonly image2D delta_irradiance;
+    layout(binding = 1, rgba32f) uniform image2D irradiance;
+    uniform mat3 luminance_from_radiance;
+    uniform sampler3D single_rayleigh_scattering_texture;
+    uniform sampler3D single_mie_scattering_texture;
+    uniform sampler3D multiple_scattering_texture;
+    uniform int scattering_order;
+    void main() {
+      ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+      if (any(greaterThanEqual(texel, ivec2(IRRADIANCE_TEXTURE_WIDTH,
+          IRRADIANCE_TEXTURE_HEIGHT)))) {
+        return;
+      }
+      IrradianceSpectrum value = ComputeIndirectIrradianceTexture(
+          ATMOSPHERE, single_rayleigh_scattering_texture,
+          single_mie_scattering_texture, multiple_scattering_texture,
+          vec2(texel) + vec2(0.5), scattering_order);
+      imageStore(delta_irradiance, texel, vec4(value, 1.0));
+      imageStore(irradiance, texel, vec4(imageLoad(irradiance, texel).rgb +
+          luminance_from_radiance * value, 1.0));
+    })";
+
+const char kMultipleScatteringComputeShader[] = R"(
+    layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+    layout(binding = 0, rgba32f) uniform writeonly image3D
+        delta_multiple_scattering;
+    layout(binding = 1, rgba32f) uniform image3D scattering;
+    uniform mat3 luminance_from_radiance;
+    uniform sampler2D transmittance_texture;
+    uniform sampler3D scattering_density_texture;
+    void main() {
+      ivec3 texel = ivec3(gl_GlobalInvocationID);
+      if (any(greaterThanEqual(texel, ivec3(SCATTERING_TEXTURE_WIDTH,
+          SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH)))) {
+        return;
+      }
+      float nu;
+      RadianceSpectrum value = ComputeMultipleScatteringTexture(
+          ATMOSPHERE, transmittance_texture, scattering_density_texture,
+          vec3(texel) + vec3(0.5), nu);
+      imageStore(delta_multiple_scattering, texel, vec4(value, 1.0));
+      vec4 accumulated = imageLoad(scattering, texel);
+      accumulated.rgb +=
+          luminance_from_radiance * value / RayleighPhaseFunction(nu);
+      imageStore(scattering, texel, accumulated);
+    })";
+
 /*
 <p>We finally need a shader implementing the GLSL functions exposed in our API,
 which can be done by calling the corresponding functions in
@@ -245,54 +437,71 @@ const char kAtmosphereShader[] = R"(
     uniform sampler3D moon_single_mie_scattering_texture;
     uniform sampler2D moon_irradiance_texture;
 
+    uniform vec3 sun_radiance_scale;
+    uniform vec3 moon_radiance_scale;
+
+    // Set at rendering time, see Model::SetSource.
+    uniform vec3 sun_source_irradiance;
+    uniform float sun_source_angular_radius;
+    uniform vec3 moon_source_irradiance;
+    uniform float moon_source_angular_radius;
+
     RadianceSpectrum GetSunRadiance() {
-      return ATMOSPHERE.sun_irradiance /
-          (PI * ATMOSPHERE.sun_angular_radius * ATMOSPHERE.sun_angular_radius);
+      return sun_source_irradiance /
+          (PI * sun_source_angular_radius * sun_source_angular_radius);
     }
     RadianceSpectrum GetSolarSkyRadiance(
         Position camera, Direction view_ray, Length shadow_length,
         Direction sun_direction, out DimensionlessSpectrum transmittance) {
-      return GetSkyRadiance(ATMOSPHERE, sun_transmittance_texture,
-          sun_scattering_texture, sun_single_mie_scattering_texture,
-          camera, view_ray, shadow_length, sun_direction, transmittance);
+      return sun_radiance_scale * GetSkyRadiance(ATMOSPHERE,
+          sun_transmittance_texture, sun_scattering_texture,
+          sun_single_mie_scattering_texture, camera, view_ray, shadow_length,
+          sun_direction, transmittance);
     }
     RadianceSpectrum GetSolarSkyRadianceToPoint(
         Position camera, Position point, Length shadow_length,
         Direction sun_direction, out DimensionlessSpectrum transmittance) {
-      return GetSkyRadianceToPoint(ATMOSPHERE, sun_transmittance_texture,
-          sun_scattering_texture, sun_single_mie_scattering_texture,
-          camera, point, shadow_length, sun_direction, transmittance);
+      return sun_radiance_scale * GetSkyRadianceToPoint(ATMOSPHERE,
+          sun_transmittance_texture, sun_scattering_texture,
+          sun_single_mie_scattering_texture, camera, point, shadow_length,
+          sun_direction, transmittance);
     }
     IrradianceSpectrum GetSunAndSolarSkyIrradiance(
        Position p, Direction normal, Direction sun_direction,
        out IrradianceSpectrum sky_irradiance) {
-      return GetSourceAndSkyIrradiance(ATMOSPHERE, sun_transmittance_texture,
-          sun_irradiance_texture, p, normal, sun_direction, ATMOSPHERE.sun_angular_radius, ATMOSPHERE.sun_irradiance, sky_irradiance);
+      IrradianceSpectrum sun_irradiance = GetSourceAndSkyIrradiance(ATMOSPHERE, sun_transmittance_texture,
+          sun_irradiance_texture, p, normal, sun_direction, sun_source_angular_radius, sun_source_irradiance, sky_irradiance);
+      sky_irradiance *= sun_radiance_scale;
+      return sun_irradiance;
     }
 
     RadianceSpectrum GetMoonRadiance() {
-      return ATMOSPHERE.moon_irradiance /
-          (PI * ATMOSPHERE.moon_angular_radius * ATMOSPHERE.moon_angular_radius);
+      return moon_source_irradiance /
+          (PI * moon_source_angular_radius * moon_source_angular_radius);
     }
     RadianceSpectrum GetLunarSkyRadiance(
         Position camera, Direction view_ray, Length shadow_length,
         Direction moon_direction, out DimensionlessSpectrum transmittance) {
-      return GetSkyRadiance(ATMOSPHERE, moon_transmittance_texture,
-          moon_scattering_texture, moon_single_mie_scattering_texture,
-          camera, view_ray, shadow_length, moon_direction, transmittance);
+      return moon_radiance_scale * GetSkyRadiance(ATMOSPHERE,
+          moon_transmittance_texture, moon_scattering_texture,
+          moon_single_mie_scattering_texture, camera, view_ray, shadow_length,
+          moon_direction, transmittance);
     }
     RadianceSpectrum GetLunarSkyRadianceToPoint(
         Position camera, Position point, Length shadow_length,
         Direction moon_direction, out DimensionlessSpectrum transmittance) {
-      return GetSkyRadianceToPoint(ATMOSPHERE, moon_transmittance_texture,
-          moon_scattering_texture, moon_single_mie_scattering_texture,
-          camera, point, shadow_length, moon_direction, transmittance);
+      return moon_radiance_scale * GetSkyRadianceToPoint(ATMOSPHERE,
+          moon_transmittance_texture, moon_scattering_texture,
+          moon_single_mie_scattering_texture, camera, point, shadow_length,
+          moon_direction, transmittance);
     }
     IrradianceSpectrum GetMoonAndLunarSkyIrradiance(
        Position p, Direction normal, Direction moon_direction,
        out IrradianceSpectrum sky_irradiance) {
-      return GetSourceAndSkyIrradiance(ATMOSPHERE, moon_transmittance_texture,
-          moon_irradiance_texture, p, normal, moon_direction, ATMOSPHERE.moon_angular_radius, ATMOSPHERE.moon_irradiance, sky_irradiance);
+      IrradianceSpectrum moon_irradiance = GetSourceAndSkyIrradiance(ATMOSPHERE, moon_transmittance_texture,
+          moon_irradiance_texture, p, normal, moon_direction, moon_source_angular_radius, moon_source_irradiance, sky_irradiance);
+      sky_irradiance *= moon_radiance_scale;
+      return moon_irradiance;
     }
 )";
 
@@ -354,6 +563,23 @@ class Program {
     glDeleteShader(fragment_shader);
   }
 
+  explicit Program(const std::string& compute_shader_source) {
+    program_ = glCreateProgram();
+
+    const char* source = compute_shader_source.c_str();
+    GLuint compute_shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute_shader, 1, &source, NULL);
+    glCompileShader(compute_shader);
+    CheckShader(compute_shader);
+    glAttachShader(program_, compute_shader);
+
+    glLinkProgram(program_);
+    CheckProgram(program_);
+
+    glDetachShader(program_, compute_shader);
+    glDeleteShader(compute_shader);
+  }
+
   ~Program() {
     glDeleteProgram(program_);
   }
@@ -432,6 +658,23 @@ class Program {
   GLuint program_;
 };
 
+/*
+<p>The compute shaders need a few OpenGL 4.3 functions, which are not provided
+by our OpenGL 3.3 loader (their constants are defined at the top of this file).
+They are loaded at runtime by <code>Model::LoadComputeShaderFunctions</code>:
+*/
+
+struct ComputeShaderFunctions {
+  void (APIENTRYP dispatch_compute)(GLuint num_groups_x, GLuint num_groups_y,
+      GLuint num_groups_z);
+  void (APIENTRYP bind_image_texture)(GLuint unit, GLuint texture, GLint level,
+      GLboolean layered, GLint layer, GLenum access, GLenum format);
+  void (APIENTRYP memory_barrier)(GLbitfield barriers);
+  bool supported;
+};
+
+ComputeShaderFunctions compute_shader_functions = {};
+
 /*
 <p>We also need functions to allocate the precomputed textures on GPU:
 */
@@ -452,7 +695,8 @@ GLuint NewTexture2d(int width, int height) {
   return texture;
 }
 
-GLuint NewTexture3d(int width, int height, int depth, GLenum format) {
+GLuint NewTexture3d(int width, int height, int depth, GLenum format,
+    ScatteringTextureFormat storage_format = FULL_PRECISION) {
   GLuint texture;
   glGenTextures(1, &texture);
   glActiveTexture(GL_TEXTURE0);
@@ -463,12 +707,54 @@ GLuint NewTexture3d(int width, int height, int depth, GLenum format) {
   glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-  GLenum internal_format = (format == GL_RGBA ? GL_RGBA32F : GL_RGB32F);
+  GLenum internal_format;
+  switch (storage_format) {
+    case HALF_PRECISION:
+      internal_format = format == GL_RGBA ? GL_RGBA16F : GL_RGB16F;
+      break;
+    case SHARED_EXPONENT:
+      internal_format = format == GL_RGBA ? GL_RGBA16F : GL_RGB9_E5;
+      break;
+    default:
+      internal_format = format == GL_RGBA ? GL_RGBA32F : GL_RGB32F;
+      break;
+  }
   glTexImage3D(GL_TEXTURE_3D, 0, internal_format, width, height, depth, 0,
       format, GL_FLOAT, NULL);
   return texture;
 }
 
+/*
+<p>a function to copy a 3D texture into another one with a different storage
+format, through a pixel buffer object (the conversion is done by the driver, as
+when uploading float values from client memory):
+*/
+
+void CopyTexture3d(GLuint source, GLuint destination,
+    const TextureResolution& resolution, GLenum format) {
+  const std::size_t num_components = format == GL_RGBA ? 4 : 3;
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+  glBufferData(GL_PIXEL_PACK_BUFFER,
+      num_components * resolution.scattering_size() * sizeof(GLfloat), NULL,
+      GL_STREAM_COPY);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_3D, source);
+  glGetTexImage(GL_TEXTURE_3D, 0, format, GL_FLOAT, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_3D, destination);
+  glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, resolution.scattering_width(),
+      resolution.scattering_height(), resolution.scattering_depth(), format,
+      GL_FLOAT, NULL);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glDeleteBuffers(1, &buffer);
+}
+
 /*
 <p>a function to test whether the RGB format is a supported renderbuffer color
 format (the OpenGL 3.3 Core Profile specification requires support for the RGBA
@@ -514,8 +800,169 @@ void DrawQuad(const std::vector<bool>& enable_blend, GLuint quad_vao) {
   }
 }
 
+/*
+<p>and, for the compute shaders, functions to bind a texture to an image unit,
+and to dispatch one invocation per texel of a 2D or 3D texture (with 8x8 texels
+work groups):
+*/
+
+void BindImage(GLuint unit, GLuint texture, GLenum access) {
+  compute_shader_functions.bind_image_texture(unit, texture, 0, GL_TRUE, 0,
+      access, GL_RGBA32F);
+}
+
+void Dispatch(int width, int height, int depth = 1) {
+  constexpr int kGroupSize = 8;
+  compute_shader_functions.dispatch_compute(
+      (width + kGroupSize - 1) / kGroupSize,
+      (height + kGroupSize - 1) / kGroupSize,
+      depth);
+}
+
+// Makes the image stores done so far visible to the following image loads and
+// texture fetches.
+void ImageBarrier() {
+  compute_shader_functions.memory_barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+      GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+/*
+<p>Finally, we need a function to compute the average value of a scattering
+texture, in order to measure the energy added by each scattering order (see
+<code>Init</code>). The average is computed on GPU, by generating the mipmaps
+of the texture: the last level contains a single texel, which is the average of
+all the texels (this is only used with temporary textures, which are sampled
+without mipmaps anyway):
+*/
+
+double GetAverageValue3d(GLuint texture) {
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_3D, texture);
+  GLint width, height, depth;
+  glGetTexLevelParameteriv(GL_TEXTURE_3D, 0, GL_TEXTURE_WIDTH, &width);
+  glGetTexLevelParameteriv(GL_TEXTURE_3D, 0, GL_TEXTURE_HEIGHT, &height);
+  glGetTexLevelParameteriv(GL_TEXTURE_3D, 0, GL_TEXTURE_DEPTH, &depth);
+  const int max_size = std::max(width, std::max(height, depth));
+  int last_level = 0;
+  while ((max_size >> last_level) > 1) {
+    ++last_level;
+  }
+  glGenerateMipmap(GL_TEXTURE_3D);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  GLfloat average[3];
+  glGetTexImage(GL_TEXTURE_3D, last_level, GL_RGB, GL_FLOAT, average);
+  return (average[0] + average[1] + average[2]) / 3.0;
+}
+
+// The single scattering textures do not include the phase functions, whose
+// average over all directions is 1 / (4 pi). Their average energy is thus
+// approximately the average of their values divided by 4 pi.
+double GetSingleScatteringEnergy(GLuint delta_rayleigh_scattering_texture,
+    GLuint delta_mie_scattering_texture) {
+  constexpr double kPi = 3.1415926;
+  return (GetAverageValue3d(delta_rayleigh_scattering_texture) +
+      GetAverageValue3d(delta_mie_scattering_texture)) / (4.0 * kPi);
+}
+
+/*
+<p>We also need a hash function to identify the parameters of a model, in order
+to reuse textures precomputed with the same parameters. We use the 64 bits
+FNV-1a hash, which is simple and stable across compilers and runs (unlike
+<code>std::hash</code>):
+*/
+
+constexpr std::uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+
+std::uint64_t HashBytes(const void* data, std::size_t size,
+    std::uint64_t hash = kFnvOffsetBasis) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+std::uint64_t HashString(const std::string& value,
+    std::uint64_t hash = kFnvOffsetBasis) {
+  return HashBytes(value.data(), value.size(), hash);
+}
+
+std::uint64_t HashInitArguments(std::uint64_t parameters_hash,
+    unsigned int num_scattering_orders, double convergence_tolerance,
+    unsigned int adaptive_quadrature_passes) {
+  std::uint64_t key = HashBytes(&num_scattering_orders,
+      sizeof(num_scattering_orders), parameters_hash);
+  if (convergence_tolerance > 0.0) {
+    key = HashBytes(&convergence_tolerance, sizeof(convergence_tolerance), key);
+  }
+  if (adaptive_quadrature_passes != 0) {
+    key = HashBytes(&adaptive_quadrature_passes,
+        sizeof(adaptive_quadrature_passes), key);
+  }
+  return key;
+}
+
+/*
+<p>Finally, the adaptive quadratures of the precomputation passes are selected
+in the GLSL code with preprocessor symbols (the functions.glsl code which uses
+them being also compiled as C++ by the CPU model, without any of these symbols,
+i.e. with the fixed sample counts):
+*/
+
+std::string AdaptiveQuadratureDefines(unsigned int adaptive_quadrature_passes) {
+  std::string defines;
+  if (adaptive_quadrature_passes & ADAPTIVE_TRANSMITTANCE_QUADRATURE) {
+    defines += "#define ADAPTIVE_TRANSMITTANCE_QUADRATURE\n";
+  }
+  if (adaptive_quadrature_passes & ADAPTIVE_SINGLE_SCATTERING_QUADRATURE) {
+    defines += "#define ADAPTIVE_SINGLE_SCATTERING_QUADRATURE\n";
+  }
+  if (adaptive_quadrature_passes & ADAPTIVE_SCATTERING_DENSITY_QUADRATURE) {
+    defines += "#define ADAPTIVE_SCATTERING_DENSITY_QUADRATURE\n";
+  }
+  if (adaptive_quadrature_passes & ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE) {
+    defines += "#define ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE\n";
+  }
+  return defines;
+}
+
 }  // anonymous namespace
 
+/*
+<p>The predefined texture resolutions are the following (the nu size of the low
+resolution tier is not reduced, because this dimension is already very coarse,
+and the scattering texture is interpolated along it without hardware support):
+*/
+
+TextureResolution GetTextureResolution(TextureResolutionTier tier) {
+  TextureResolution resolution;
+  switch (tier) {
+    case LOW_RESOLUTION:
+      resolution.transmittance_width = 128;
+      resolution.transmittance_height = 32;
+      resolution.scattering_r_size = 16;
+      resolution.scattering_mu_size = 64;
+      resolution.scattering_mu_s_size = 16;
+      resolution.irradiance_width = 32;
+      resolution.irradiance_height = 8;
+      break;
+    case DEFAULT_RESOLUTION:
+      break;
+    case REFERENCE_RESOLUTION:
+      resolution.transmittance_width = 512;
+      resolution.transmittance_height = 128;
+      resolution.scattering_r_size = 64;
+      resolution.scattering_mu_size = 256;
+      resolution.scattering_nu_size = 16;
+      resolution.irradiance_width = 128;
+      resolution.irradiance_height = 32;
+      break;
+  }
+  return resolution;
+}
+
 /*<h3 id="implementation">Model implementation</h3>
 
 <p>Using the above utility functions and classes, we can now implement the
@@ -526,8 +973,10 @@ folding and propagation optimizations in the GLSL compiler), concatenated with
 <a href="functions.glsl.html">functions.glsl</a>, and with
 <code>kAtmosphereShader</code>, to get the shader exposed by our API in
 <code>GetShader</code>. It also allocates the precomputed textures (but does not
-initialize them), as well as a vertex buffer object to render a full screen quad
-(used to render into the precomputed textures).
+initialize them). The vertex buffer object used to render a full screen quad
+into the precomputed textures is only created in <code>Init</code>, because
+vertex arrays are not shared between OpenGL contexts, and a model can be
+precomputed in a different context than the one it is rendered with.
 */
 
 Model::Model(
@@ -548,9 +997,103 @@ Model::Model(
     const glm::dvec3& ground_albedo,
     double max_sun_zenith_angle,
     double length_unit_in_meters,
-    int light_source) :
+    int light_source,
+    const TextureResolution& resolution,
+    bool combine_scattering_textures,
+    ScatteringTextureFormat scattering_texture_format) :
+        resolution_(resolution),
+        combine_scattering_textures_(combine_scattering_textures),
+        scattering_texture_format_(scattering_texture_format),
         rgb_format_supported_(IsFramebufferRgbFormatSupported()),
-        light_source_(light_source) {
+        owns_textures_(true),
+        source_irradiance_(
+            light_source == SOURCE_SUN ? sun_irradiance : moon_irradiance),
+        source_angular_radius_(light_source == SOURCE_SUN ?
+            sun_angular_radius : moon_angular_radius),
+        precomputed_irradiance_(source_irradiance_),
+        full_screen_quad_vao_(0),
+        full_screen_quad_vbo_(0),
+        light_source_(light_source),
+        precomputation_time_(0.0),
+        precomputation_backend_(FRAGMENT_SHADER),
+        num_precomputed_scattering_orders_(0) {
+  glsl_header_factory_ = NewGlslHeaderFactory(
+      sun_irradiance, sun_angular_radius, moon_irradiance, moon_angular_radius,
+      bottom_radius, top_radius, rayleigh_density, rayleigh_scattering,
+      mie_density, mie_scattering, mie_extinction, mie_phase_function_g,
+      absorption_density, absorption_extinction, ground_albedo,
+      max_sun_zenith_angle, length_unit_in_meters, resolution,
+      combine_scattering_textures);
+
+  // Allocate the precomputed textures, but don't precompute them yet. The
+  // combined scattering texture needs an alpha channel for the single Mie
+  // scattering, and the full precision scattering textures are also rendered
+  // to (see Init), which may require an alpha channel.
+  transmittance_texture_ = NewTexture2d(
+      resolution.transmittance_width, resolution.transmittance_height);
+  GLenum scattering_format = combine_scattering_textures ||
+      (scattering_texture_format == FULL_PRECISION && !rgb_format_supported_) ?
+          GL_RGBA : GL_RGB;
+  scattering_texture_ = NewTexture3d(
+      resolution.scattering_width(),
+      resolution.scattering_height(),
+      resolution.scattering_depth(),
+      scattering_format, scattering_texture_format);
+  if (combine_scattering_textures) {
+    optional_single_mie_scattering_texture_ = 0;
+  } else {
+    optional_single_mie_scattering_texture_ = NewTexture3d(
+        resolution.scattering_width(),
+        resolution.scattering_height(),
+        resolution.scattering_depth(),
+        scattering_format, scattering_texture_format);
+  }
+  irradiance_texture_ = NewTexture2d(
+      resolution.irradiance_width, resolution.irradiance_height);
+
+  // Create and compile the shader providing our API.
+  std::string shader =
+      glsl_header_factory_({kLambdaR, kLambdaG, kLambdaB}, 0) +
+      // (precompute_illuminance ? "" : "#define RADIANCE_API_ENABLED\n") +
+      "#define RADIANCE_API_ENABLED" +
+      kAtmosphereShader;
+  const char* source = shader.c_str();
+  atmosphere_shader_ = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(atmosphere_shader_, 1, &source, NULL);
+  glCompileShader(atmosphere_shader_);
+  atmosphere_shader_hash_ = HashString(shader);
+
+  parameters_hash_ = HashParameters(glsl_header_factory_, light_source_,
+      scattering_texture_format_);
+}
+
+/*
+<p>The GLSL header and the hash of the parameters only depend on the constructor
+arguments, and are computed without any OpenGL call, so that the key of the
+precomputed textures of a model can also be computed without constructing it
+(see <code>ComputePrecomputedTexturesKey</code>):
+*/
+
+Model::GlslHeaderFactory Model::NewGlslHeaderFactory(
+    const glm::dvec3& sun_irradiance,
+    const double sun_angular_radius,
+    const glm::dvec3& moon_irradiance,
+    const double moon_angular_radius,
+    double bottom_radius,
+    double top_radius,
+    const std::vector<DensityProfileLayer>& rayleigh_density,
+    const glm::dvec3& rayleigh_scattering,
+    const std::vector<DensityProfileLayer>& mie_density,
+    const glm::dvec3& mie_scattering,
+    const glm::dvec3& mie_extinction,
+    double mie_phase_function_g,
+    const std::vector<DensityProfileLayer>& absorption_density,
+    const glm::dvec3& absorption_extinction,
+    const glm::dvec3& ground_albedo,
+    double max_sun_zenith_angle,
+    double length_unit_in_meters,
+    const TextureResolution& resolution,
+    bool combine_scattering_textures) {
     auto to_string = [](const glm::dvec3& v, double scale)
     {
         double r = v.r * scale;
@@ -608,32 +1151,37 @@ Model::Model(
   //    0 /* lambda_power */, &sun_k_r, &sun_k_g, &sun_k_b);
 
   // A lambda that creates a GLSL header containing our atmosphere computation
-  // functions, specialized for the given atmosphere parameters and for the 3
-  // wavelengths in 'lambdas'.
-  glsl_header_factory_ = [=](const vec3& lambdas) {
+  // functions, specialized for the given atmosphere parameters, for the 3
+  // wavelengths in 'lambdas', and for the AdaptiveQuadraturePass flags in
+  // 'adaptive_quadrature_passes'.
+  return [=](const vec3& /*lambdas*/,
+      unsigned int adaptive_quadrature_passes) {
     return
       "#version 330\n"
       "#define IN(x) const in x\n"
       "#define OUT(x) out x\n"
       "#define TEMPLATE(x)\n"
       "#define TEMPLATE_ARGUMENT(x)\n"
-      "#define assert(x)\n"
+      "#define assert(x)\n" +
+      std::string(combine_scattering_textures ?
+          "#define COMBINED_SCATTERING_TEXTURES\n" : "") +
+      AdaptiveQuadratureDefines(adaptive_quadrature_passes) +
       "const int TRANSMITTANCE_TEXTURE_WIDTH = " +
-          std::to_string(TRANSMITTANCE_TEXTURE_WIDTH) + ";\n" +
+          std::to_string(resolution.transmittance_width) + ";\n" +
       "const int TRANSMITTANCE_TEXTURE_HEIGHT = " +
-          std::to_string(TRANSMITTANCE_TEXTURE_HEIGHT) + ";\n" +
+          std::to_string(resolution.transmittance_height) + ";\n" +
       "const int SCATTERING_TEXTURE_R_SIZE = " +
-          std::to_string(SCATTERING_TEXTURE_R_SIZE) + ";\n" +
+          std::to_string(resolution.scattering_r_size) + ";\n" +
       "const int SCATTERING_TEXTURE_MU_SIZE = " +
-          std::to_string(SCATTERING_TEXTURE_MU_SIZE) + ";\n" +
+          std::to_string(resolution.scattering_mu_size) + ";\n" +
       "const int SCATTERING_TEXTURE_MU_S_SIZE = " +
-          std::to_string(SCATTERING_TEXTURE_MU_S_SIZE) + ";\n" +
+          std::to_string(resolution.scattering_mu_s_size) + ";\n" +
       "const int SCATTERING_TEXTURE_NU_SIZE = " +
-          std::to_string(SCATTERING_TEXTURE_NU_SIZE) + ";\n" +
+          std::to_string(resolution.scattering_nu_size) + ";\n" +
       "const int IRRADIANCE_TEXTURE_WIDTH = " +
-          std::to_string(IRRADIANCE_TEXTURE_WIDTH) + ";\n" +
+          std::to_string(resolution.irradiance_width) + ";\n" +
       "const int IRRADIANCE_TEXTURE_HEIGHT = " +
-          std::to_string(IRRADIANCE_TEXTURE_HEIGHT) + ";\n" +
+          std::to_string(resolution.irradiance_height) + ";\n" +
       definitions_glsl +
       "const AtmosphereParameters ATMOSPHERE = AtmosphereParameters(\n" +
           to_string(sun_irradiance, 1.0) + ",\n" +
@@ -662,64 +1210,81 @@ Model::Model(
           std::to_string(sun_k_b) + ");\n" +
       functions_glsl0 + functions_glsl1 + functions_glsl2 + functions_glsl3;
   };
+}
 
-  // Allocate the precomputed textures, but don't precompute them yet.
-  transmittance_texture_ = NewTexture2d(
-      TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT);
-  scattering_texture_ = NewTexture3d(
-      SCATTERING_TEXTURE_WIDTH,
-      SCATTERING_TEXTURE_HEIGHT,
-      SCATTERING_TEXTURE_DEPTH,
-      rgb_format_supported_ ? GL_RGB : GL_RGBA);
-  optional_single_mie_scattering_texture_ = NewTexture3d(
-      SCATTERING_TEXTURE_WIDTH,
-      SCATTERING_TEXTURE_HEIGHT,
-      SCATTERING_TEXTURE_DEPTH,
-      rgb_format_supported_ ? GL_RGB : GL_RGBA);
-  irradiance_texture_ = NewTexture2d(
-      IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT);
-
-  // Create and compile the shader providing our API.
-  std::string shader =
-      glsl_header_factory_({kLambdaR, kLambdaG, kLambdaB}) +
-      // (precompute_illuminance ? "" : "#define RADIANCE_API_ENABLED\n") +
-      "#define RADIANCE_API_ENABLED" +
-      kAtmosphereShader;
-  const char* source = shader.c_str();
-  atmosphere_shader_ = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(atmosphere_shader_, 1, &source, NULL);
-  glCompileShader(atmosphere_shader_);
+// Hashes everything which determines the content of the precomputed textures.
+// The GLSL header contains the atmosphere parameters, the texture sizes and the
+// GLSL functions, so that any change in these invalidates the hash.
+std::uint64_t Model::HashParameters(
+    const GlslHeaderFactory& glsl_header_factory, int light_source,
+    ScatteringTextureFormat scattering_texture_format) {
+  std::uint64_t hash =
+      HashString(glsl_header_factory({kLambdaR, kLambdaG, kLambdaB}, 0));
+  for (const char* source : {kComputeTransmittanceShader,
+      kComputeDirectIrradianceShader, kComputeSingleScatteringShader,
+      kComputeScatteringDensityShader, kComputeIndirectIrradianceShader,
+      kComputeMultipleScatteringShader, kTransmittanceComputeShader,
+      kDirectIrradianceComputeShader, kSingleScatteringComputeShader,
+      kScatteringDensityComputeShader, kIndirectIrradianceComputeShader,
+      kMultipleScatteringComputeShader}) {
+    hash = HashString(source, hash);
+  }
+  hash = HashBytes(&light_source, sizeof(light_source), hash);
+  return HashBytes(&scattering_texture_format,
+      sizeof(scattering_texture_format), hash);
+}
 
-  // Create a full screen quad vertex array and vertex buffer objects.
-  glGenVertexArrays(1, &full_screen_quad_vao_);
-  glBindVertexArray(full_screen_quad_vao_);
-  glGenBuffers(1, &full_screen_quad_vbo_);
-  glBindBuffer(GL_ARRAY_BUFFER, full_screen_quad_vbo_);
-  const GLfloat vertices[] = {
-    -1.0, -1.0,
-    +1.0, -1.0,
-    -1.0, +1.0,
-    +1.0, +1.0,
-  };
-  constexpr int kCoordsPerVertex = 2;
-  glBufferData(GL_ARRAY_BUFFER, sizeof vertices, vertices, GL_STATIC_DRAW);
-  constexpr GLuint kAttribIndex = 0;
-  glVertexAttribPointer(kAttribIndex, kCoordsPerVertex, GL_FLOAT, false, 0, 0);
-  glEnableVertexAttribArray(kAttribIndex);
-  glBindVertexArray(0);
+std::uint64_t Model::ComputePrecomputedTexturesKey(
+    const glm::dvec3& sun_irradiance,
+    const double sun_angular_radius,
+    const glm::dvec3& moon_irradiance,
+    const double moon_angular_radius,
+    double bottom_radius,
+    double top_radius,
+    const std::vector<DensityProfileLayer>& rayleigh_density,
+    const glm::dvec3& rayleigh_scattering,
+    const std::vector<DensityProfileLayer>& mie_density,
+    const glm::dvec3& mie_scattering,
+    const glm::dvec3& mie_extinction,
+    double mie_phase_function_g,
+    const std::vector<DensityProfileLayer>& absorption_density,
+    const glm::dvec3& absorption_extinction,
+    const glm::dvec3& ground_albedo,
+    double max_sun_zenith_angle,
+    double length_unit_in_meters,
+    int light_source,
+    const TextureResolution& resolution,
+    bool combine_scattering_textures,
+    ScatteringTextureFormat scattering_texture_format,
+    unsigned int num_scattering_orders,
+    double convergence_tolerance,
+    unsigned int adaptive_quadrature_passes) {
+  GlslHeaderFactory glsl_header_factory = NewGlslHeaderFactory(
+      sun_irradiance, sun_angular_radius, moon_irradiance, moon_angular_radius,
+      bottom_radius, top_radius, rayleigh_density, rayleigh_scattering,
+      mie_density, mie_scattering, mie_extinction, mie_phase_function_g,
+      absorption_density, absorption_extinction, ground_albedo,
+      max_sun_zenith_angle, length_unit_in_meters, resolution,
+      combine_scattering_textures);
+  return HashInitArguments(
+      HashParameters(glsl_header_factory, light_source,
+          scattering_texture_format),
+      num_scattering_orders, convergence_tolerance,
+      adaptive_quadrature_passes);
 }
 
 /*
-<p>The destructor is trivial:
+<p>The destructor is trivial (the precomputed textures are only deleted if
+they are not borrowed from another model):
 */
 
 Model::~Model() {
-  glDeleteBuffers(1, &full_screen_quad_vbo_);
-  glDeleteVertexArrays(1, &full_screen_quad_vao_);
-  glDeleteTextures(1, &transmittance_texture_);
-  glDeleteTextures(1, &scattering_texture_);
-  glDeleteTextures(1, &optional_single_mie_scattering_texture_);
-  glDeleteTextures(1, &irradiance_texture_);
+  if (owns_textures_) {
+    glDeleteTextures(1, &transmittance_texture_);
+    glDeleteTextures(1, &scattering_texture_);
+    glDeleteTextures(1, &optional_single_mie_scattering_texture_);
+    glDeleteTextures(1, &irradiance_texture_);
+  }
   glDeleteShader(atmosphere_shader_);
 }
 
@@ -776,29 +1341,68 @@ want to store precomputed irradiance or illuminance values:
 <p>This yields the following implementation:
 */
 
-void Model::Init(unsigned int num_scattering_orders) {
+bool Model::Init(unsigned int num_scattering_orders,
+    const ProgressCallback& progress, PrecomputationBackend backend,
+    double convergence_tolerance, unsigned int adaptive_quadrature_passes) {
+  if (backend == COMPUTE_SHADER && !IsComputeShaderBackendSupported()) {
+    backend = FRAGMENT_SHADER;
+  }
+  bool rgb_format = rgb_format_supported_ && backend == FRAGMENT_SHADER;
+  // The precomputations accumulate the scattering orders in 32 bits float
+  // textures. With another storage format, these are temporary textures whose
+  // content is converted to the final ones at the end of this method (RGB9E5
+  // textures are not renderable, and accumulating the orders in half precision
+  // would add rounding errors at each order).
+  GLuint final_scattering_texture = scattering_texture_;
+  GLuint final_single_mie_scattering_texture =
+      optional_single_mie_scattering_texture_;
+  if (scattering_texture_format_ != FULL_PRECISION) {
+    GLenum scattering_format =
+        rgb_format && !combine_scattering_textures_ ? GL_RGB : GL_RGBA;
+    scattering_texture_ = NewTexture3d(
+        resolution_.scattering_width(), resolution_.scattering_height(),
+        resolution_.scattering_depth(), scattering_format);
+    if (final_single_mie_scattering_texture != 0) {
+      optional_single_mie_scattering_texture_ = NewTexture3d(
+          resolution_.scattering_width(), resolution_.scattering_height(),
+          resolution_.scattering_depth(), scattering_format);
+    }
+  } else if (backend == COMPUTE_SHADER && rgb_format_supported_ &&
+      !combine_scattering_textures_) {
+    // The compute shaders can only write RGBA textures, so the 3D textures
+    // allocated in the constructor must be reallocated if they are RGB.
+    glDeleteTextures(1, &scattering_texture_);
+    glDeleteTextures(1, &optional_single_mie_scattering_texture_);
+    scattering_texture_ = NewTexture3d(
+        resolution_.scattering_width(), resolution_.scattering_height(),
+        resolution_.scattering_depth(), GL_RGBA);
+    optional_single_mie_scattering_texture_ = NewTexture3d(
+        resolution_.scattering_width(), resolution_.scattering_height(),
+        resolution_.scattering_depth(), GL_RGBA);
+  }
+
   // The precomputations require temporary textures, in particular to store the
   // contribution of one scattering order, which is needed to compute the next
   // order of scattering (the final precomputed textures store the sum of all
   // the scattering orders). We allocate them here, and destroy them at the end
   // of this method.
   GLuint delta_irradiance_texture = NewTexture2d(
-      IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT);
+      resolution_.irradiance_width, resolution_.irradiance_height);
   GLuint delta_rayleigh_scattering_texture = NewTexture3d(
-      SCATTERING_TEXTURE_WIDTH,
-      SCATTERING_TEXTURE_HEIGHT,
-      SCATTERING_TEXTURE_DEPTH,
-      rgb_format_supported_ ? GL_RGB : GL_RGBA);
+      resolution_.scattering_width(),
+      resolution_.scattering_height(),
+      resolution_.scattering_depth(),
+      rgb_format ? GL_RGB : GL_RGBA);
   GLuint delta_mie_scattering_texture = NewTexture3d(
-      SCATTERING_TEXTURE_WIDTH,
-      SCATTERING_TEXTURE_HEIGHT,
-      SCATTERING_TEXTURE_DEPTH,
-      rgb_format_supported_ ? GL_RGB : GL_RGBA);
+      resolution_.scattering_width(),
+      resolution_.scattering_height(),
+      resolution_.scattering_depth(),
+      rgb_format ? GL_RGB : GL_RGBA);
   GLuint delta_scattering_density_texture = NewTexture3d(
-      SCATTERING_TEXTURE_WIDTH,
-      SCATTERING_TEXTURE_HEIGHT,
-      SCATTERING_TEXTURE_DEPTH,
-      rgb_format_supported_ ? GL_RGB : GL_RGBA);
+      resolution_.scattering_width(),
+      resolution_.scattering_height(),
+      resolution_.scattering_depth(),
+      rgb_format ? GL_RGB : GL_RGBA);
   // delta_multiple_scattering_texture is only needed to compute scattering
   // order 3 or more, while delta_rayleigh_scattering_texture and
   // delta_mie_scattering_texture are only needed to compute double scattering.
@@ -806,95 +1410,188 @@ void Model::Init(unsigned int num_scattering_orders) {
   // and delta_multiple_scattering_texture in the same GPU texture.
   GLuint delta_multiple_scattering_texture = delta_rayleigh_scattering_texture;
 
-  // The precomputations also require a temporary framebuffer object, created
-  // here (and destroyed at the end of this method).
-  GLuint fbo;
-  glGenFramebuffers(1, &fbo);
-  GLint previous_fbo;
-  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_fbo);
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
-  {
-      // The actual precomputations depend on whether we want to store precomputed
-      // irradiance or illuminance values.
-      //if (num_precomputed_wavelengths_ <= 3) {
-      vec3 lambdas{kLambdaR, kLambdaG, kLambdaB};
-      mat3 luminance_from_radiance{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
-      Precompute(fbo, delta_irradiance_texture, delta_rayleigh_scattering_texture,
-          delta_mie_scattering_texture, delta_scattering_density_texture,
-          delta_multiple_scattering_texture, lambdas, luminance_from_radiance,
-          false /* blend */, num_scattering_orders);
-      //}
-      //else {
-      //  constexpr double kLambdaMin = 360.0;
-      //  constexpr double kLambdaMax = 830.0;
-      //  int num_iterations = (num_precomputed_wavelengths_ + 2) / 3;
-      //  double dlambda = (kLambdaMax - kLambdaMin) / (3 * num_iterations);
-      //  for (int i = 0; i < num_iterations; ++i) {
-      //    vec3 lambdas{
-      //      kLambdaMin + (3 * i + 0.5) * dlambda,
-      //      kLambdaMin + (3 * i + 1.5) * dlambda,
-      //      kLambdaMin + (3 * i + 2.5) * dlambda
-      //    };
-      //    auto coeff = [dlambda](double lambda, int component) {
-      //      // Note that we don't include MAX_LUMINOUS_EFFICACY here, to avoid
-      //      // artefacts due to too large values when using half precision on GPU.
-      //      // We add this term back in kAtmosphereShader, via
-      //      // SKY_SPECTRAL_RADIANCE_TO_LUMINANCE (see also the comments in the
-      //      // Model constructor).
-      //      double x = CieColorMatchingFunctionTableValue(lambda, 1);
-      //      double y = CieColorMatchingFunctionTableValue(lambda, 2);
-      //      double z = CieColorMatchingFunctionTableValue(lambda, 3);
-      //      return static_cast<float>((
-      //          XYZ_TO_SRGB[component * 3] * x +
-      //          XYZ_TO_SRGB[component * 3 + 1] * y +
-      //          XYZ_TO_SRGB[component * 3 + 2] * z) * dlambda);
-      //    };
-      //    mat3 luminance_from_radiance{
-      //      coeff(lambdas[0], 0), coeff(lambdas[1], 0), coeff(lambdas[2], 0),
-      //      coeff(lambdas[0], 1), coeff(lambdas[1], 1), coeff(lambdas[2], 1),
-      //      coeff(lambdas[0], 2), coeff(lambdas[1], 2), coeff(lambdas[2], 2)
-      //    };
-      //    Precompute(fbo, delta_irradiance_texture,
-      //        delta_rayleigh_scattering_texture, delta_mie_scattering_texture,
-      //        delta_scattering_density_texture, delta_multiple_scattering_texture,
-      //        lambdas, luminance_from_radiance, i > 0 /* blend */,
-      //        num_scattering_orders);
-      //  }
-
-      //  // After the above iterations, the transmittance texture contains the
-      //  // transmittance for the 3 wavelengths used at the last iteration. But we
-      //  // want the transmittance at kLambdaR, kLambdaG, kLambdaB instead, so we
-      //  // must recompute it here for these 3 wavelengths:
-      //  std::string header = glsl_header_factory_({kLambdaR, kLambdaG, kLambdaB});
-      //  Program compute_transmittance(
-      //      kVertexShader, header + kComputeTransmittanceShader);
-      //  glFramebufferTexture(
-      //      GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, transmittance_texture_, 0);
-      //  glDrawBuffer(GL_COLOR_ATTACHMENT0);
-      //  glViewport(0, 0, TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT);
-      //  compute_transmittance.Use();
-      //  DrawQuad({}, full_screen_quad_vao_);
-      //}
-      glUseProgram(0);
+  // The actual precomputations depend on whether we want to store precomputed
+  // irradiance or illuminance values.
+  vec3 lambdas{kLambdaR, kLambdaG, kLambdaB};
+  mat3 luminance_from_radiance{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+
+  // Measure the GPU time of the precomputations (getting the query result
+  // below waits until they are complete).
+  GLuint time_query;
+  glGenQueries(1, &time_query);
+  glBeginQuery(GL_TIME_ELAPSED, time_query);
+
+  bool completed;
+  if (backend == COMPUTE_SHADER) {
+    completed = PrecomputeWithComputeShaders(delta_irradiance_texture,
+        delta_rayleigh_scattering_texture, delta_mie_scattering_texture,
+        delta_scattering_density_texture, delta_multiple_scattering_texture,
+        lambdas, luminance_from_radiance, false /* blend */,
+        num_scattering_orders, convergence_tolerance,
+        adaptive_quadrature_passes, progress);
+  } else {
+    // Create a full screen quad vertex array and vertex buffer objects (also
+    // destroyed at the end of this method).
+    glGenVertexArrays(1, &full_screen_quad_vao_);
+    glBindVertexArray(full_screen_quad_vao_);
+    glGenBuffers(1, &full_screen_quad_vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, full_screen_quad_vbo_);
+    const GLfloat vertices[] = {
+      -1.0, -1.0,
+      +1.0, -1.0,
+      -1.0, +1.0,
+      +1.0, +1.0,
+    };
+    constexpr int kCoordsPerVertex = 2;
+    glBufferData(GL_ARRAY_BUFFER, sizeof vertices, vertices, GL_STATIC_DRAW);
+    constexpr GLuint kAttribIndex = 0;
+    glVertexAttribPointer(
+        kAttribIndex, kCoordsPerVertex, GL_FLOAT, false, 0, 0);
+    glEnableVertexAttribArray(kAttribIndex);
+    glBindVertexArray(0);
+
+    // The precomputations also require a temporary framebuffer object, created
+    // here (and destroyed at the end of this method).
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    GLint previous_fbo;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    {
+        //if (num_precomputed_wavelengths_ <= 3) {
+        completed = Precompute(fbo, delta_irradiance_texture,
+            delta_rayleigh_scattering_texture, delta_mie_scattering_texture,
+            delta_scattering_density_texture, delta_multiple_scattering_texture,
+            lambdas, luminance_from_radiance, false /* blend */,
+            num_scattering_orders, convergence_tolerance,
+            adaptive_quadrature_passes, progress);
+        //}
+        //else {
+        //  constexpr double kLambdaMin = 360.0;
+        //  constexpr double kLambdaMax = 830.0;
+        //  int num_iterations = (num_precomputed_wavelengths_ + 2) / 3;
+        //  double dlambda = (kLambdaMax - kLambdaMin) / (3 * num_iterations);
+        //  for (int i = 0; i < num_iterations; ++i) {
+        //    vec3 lambdas{
+        //      kLambdaMin + (3 * i + 0.5) * dlambda,
+        //      kLambdaMin + (3 * i + 1.5) * dlambda,
+        //      kLambdaMin + (3 * i + 2.5) * dlambda
+        //    };
+        //    auto coeff = [dlambda](double lambda, int component) {
+        //      // Note that we don't include MAX_LUMINOUS_EFFICACY here, to avoid
+        //      // artefacts due to too large values when using half precision on GPU.
+        //      // We add this term back in kAtmosphereShader, via
+        //      // SKY_SPECTRAL_RADIANCE_TO_LUMINANCE (see also the comments in the
+        //      // Model constructor).
+        //      double x = CieColorMatchingFunctionTableValue(lambda, 1);
+        //      double y = CieColorMatchingFunctionTableValue(lambda, 2);
+        //      double z = CieColorMatchingFunctionTableValue(lambda, 3);
+        //      return static_cast<float>((
+        //          XYZ_TO_SRGB[component * 3] * x +
+        //          XYZ_TO_SRGB[component * 3 + 1] * y +
+        //          XYZ_TO_SRGB[component * 3 + 2] * z) * dlambda);
+        //    };
+        //    mat3 luminance_from_radiance{
+        //      coeff(lambdas[0], 0), coeff(lambdas[1], 0), coeff(lambdas[2], 0),
+        //      coeff(lambdas[0], 1), coeff(lambdas[1], 1), coeff(lambdas[2], 1),
+        //      coeff(lambdas[0], 2), coeff(lambdas[1], 2), coeff(lambdas[2], 2)
+        //    };
+        //    Precompute(fbo, delta_irradiance_texture,
+        //        delta_rayleigh_scattering_texture, delta_mie_scattering_texture,
+        //        delta_scattering_density_texture, delta_multiple_scattering_texture,
+        //        lambdas, luminance_from_radiance, i > 0 /* blend */,
+        //        num_scattering_orders);
+        //  }
+
+        //  // After the above iterations, the transmittance texture contains the
+        //  // transmittance for the 3 wavelengths used at the last iteration. But we
+        //  // want the transmittance at kLambdaR, kLambdaG, kLambdaB instead, so we
+        //  // must recompute it here for these 3 wavelengths:
+        //  std::string header = glsl_header_factory_({kLambdaR, kLambdaG, kLambdaB});
+        //  Program compute_transmittance(
+        //      kVertexShader, header + kComputeTransmittanceShader);
+        //  glFramebufferTexture(
+        //      GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, transmittance_texture_, 0);
+        //  glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        //  glViewport(0, 0, TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT);
+        //  compute_transmittance.Use();
+        //  DrawQuad({}, full_screen_quad_vao_);
+        //}
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_fbo);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteBuffers(1, &full_screen_quad_vbo_);
+    glDeleteVertexArrays(1, &full_screen_quad_vao_);
+    full_screen_quad_vbo_ = 0;
+    full_screen_quad_vao_ = 0;
+  }
+  glUseProgram(0);
+
+  // Convert the precomputed scattering textures to their storage format.
+  if (scattering_texture_format_ != FULL_PRECISION) {
+    GLenum format = combine_scattering_textures_ ? GL_RGBA : GL_RGB;
+    CopyTexture3d(scattering_texture_, final_scattering_texture, resolution_,
+        format);
+    glDeleteTextures(1, &scattering_texture_);
+    scattering_texture_ = final_scattering_texture;
+    if (final_single_mie_scattering_texture != 0) {
+      CopyTexture3d(optional_single_mie_scattering_texture_,
+          final_single_mie_scattering_texture, resolution_, format);
+      glDeleteTextures(1, &optional_single_mie_scattering_texture_);
+      optional_single_mie_scattering_texture_ =
+          final_single_mie_scattering_texture;
+    }
   }
+
+  glEndQuery(GL_TIME_ELAPSED);
+  GLuint64 elapsed_time;
+  glGetQueryObjectui64v(time_query, GL_QUERY_RESULT, &elapsed_time);
+  glDeleteQueries(1, &time_query);
+  precomputation_time_ = elapsed_time * 1e-9;
+  precomputation_backend_ = backend;
+
   // Delete the temporary resources allocated at the begining of this method.
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_fbo);
-  glDeleteFramebuffers(1, &fbo);
   glDeleteTextures(1, &delta_scattering_density_texture);
   glDeleteTextures(1, &delta_mie_scattering_texture);
   glDeleteTextures(1, &delta_rayleigh_scattering_texture);
   glDeleteTextures(1, &delta_irradiance_texture);
   assert(glGetError() == 0);
+  return completed;
 }
 
 /*
-<p>The <code>SetProgramUniforms</code> method is straightforward: it simply
-binds the precomputed textures to the specified texture units, and then sets
-the corresponding uniforms in the user provided program to the index of these
-texture units.
+<p>The <code>BindTextures</code> method simply binds the precomputed textures to
+the specified texture units, and the <code>SetProgramSamplers</code> method
+sets the corresponding uniforms in the user provided program to the index of
+these texture units (and the radiance scale of the light source). Since the
+texture units are not changed by the rendering of the atmosphere, the textures
+can stay bound and the samplers only need to be set once per program (after it
+is linked) and model, instead of at each frame. <code>SetProgramUniforms</code>
+does both:
 */
 
-void Model::SetProgramUniforms(
+void Model::BindTextures(
+    GLuint transmittance_texture_unit,
+    GLuint scattering_texture_unit,
+    GLuint irradiance_texture_unit,
+    GLuint single_mie_scattering_texture_unit) const {
+    glActiveTexture(GL_TEXTURE0 + transmittance_texture_unit);
+    glBindTexture(GL_TEXTURE_2D, transmittance_texture_);
+
+    glActiveTexture(GL_TEXTURE0 + scattering_texture_unit);
+    glBindTexture(GL_TEXTURE_3D, scattering_texture_);
+
+    glActiveTexture(GL_TEXTURE0 + irradiance_texture_unit);
+    glBindTexture(GL_TEXTURE_2D, irradiance_texture_);
+
+    // There is no single Mie scattering texture with combined scattering textures.
+    if (optional_single_mie_scattering_texture_ != 0) {
+        glActiveTexture(GL_TEXTURE0 + single_mie_scattering_texture_unit);
+        glBindTexture(GL_TEXTURE_3D, optional_single_mie_scattering_texture_);
+    }
+}
+
+void Model::SetProgramSamplers(
     GLuint program,
     GLuint transmittance_texture_unit,
     GLuint scattering_texture_unit,
@@ -905,24 +1602,218 @@ void Model::SetProgramUniforms(
     if (light_source_ != SOURCE_SUN) source_prefix = "moon_";
 
     std::string transmittance_texture_name = source_prefix + "transmittance_texture";
-    glActiveTexture(GL_TEXTURE0 + transmittance_texture_unit);
-    glBindTexture(GL_TEXTURE_2D, transmittance_texture_);
     glUniform1i(glGetUniformLocation(program, transmittance_texture_name.c_str()), transmittance_texture_unit);
 
     std::string scattering_texture_name = source_prefix + "scattering_texture";
-    glActiveTexture(GL_TEXTURE0 + scattering_texture_unit);
-    glBindTexture(GL_TEXTURE_3D, scattering_texture_);
     glUniform1i(glGetUniformLocation(program, scattering_texture_name.c_str()), scattering_texture_unit);
 
     std::string irradiance_texture_name = source_prefix + "irradiance_texture";
-    glActiveTexture(GL_TEXTURE0 + irradiance_texture_unit);
-    glBindTexture(GL_TEXTURE_2D, irradiance_texture_);
     glUniform1i(glGetUniformLocation(program, irradiance_texture_name.c_str()), irradiance_texture_unit);
 
-    std::string single_mie_scattering_texture_name = source_prefix + "single_mie_scattering_texture";
-    glActiveTexture(GL_TEXTURE0 + single_mie_scattering_texture_unit);
+    if (optional_single_mie_scattering_texture_ != 0) {
+        std::string single_mie_scattering_texture_name = source_prefix + "single_mie_scattering_texture";
+        glUniform1i(glGetUniformLocation(program, single_mie_scattering_texture_name.c_str()), single_mie_scattering_texture_unit);
+    }
+
+    SetProgramSourceUniforms(program);
+}
+
+void Model::SetProgramSourceUniforms(GLuint program) const {
+    std::string source_prefix = "sun_";
+    if (light_source_ != SOURCE_SUN) source_prefix = "moon_";
+
+    // A component is set to 0 if the corresponding component of the
+    // precomputed irradiance is 0.
+    glm::dvec3 radiance_scale;
+    for (int i = 0; i < 3; ++i) {
+      radiance_scale[i] = precomputed_irradiance_[i] > 0.0 ?
+          source_irradiance_[i] / precomputed_irradiance_[i] : 0.0;
+    }
+
+    std::string radiance_scale_name = source_prefix + "radiance_scale";
+    glUniform3f(glGetUniformLocation(program, radiance_scale_name.c_str()),
+        static_cast<float>(radiance_scale.r),
+        static_cast<float>(radiance_scale.g),
+        static_cast<float>(radiance_scale.b));
+
+    std::string source_irradiance_name = source_prefix + "source_irradiance";
+    glUniform3f(glGetUniformLocation(program, source_irradiance_name.c_str()),
+        static_cast<float>(source_irradiance_.r),
+        static_cast<float>(source_irradiance_.g),
+        static_cast<float>(source_irradiance_.b));
+
+    std::string source_angular_radius_name =
+        source_prefix + "source_angular_radius";
+    glUniform1f(glGetUniformLocation(program,
+        source_angular_radius_name.c_str()),
+        static_cast<float>(source_angular_radius_));
+}
+
+void Model::SetProgramUniforms(
+    GLuint program,
+    GLuint transmittance_texture_unit,
+    GLuint scattering_texture_unit,
+    GLuint irradiance_texture_unit,
+    GLuint single_mie_scattering_texture_unit) const {
+    BindTextures(transmittance_texture_unit, scattering_texture_unit,
+        irradiance_texture_unit, single_mie_scattering_texture_unit);
+    SetProgramSamplers(program, transmittance_texture_unit,
+        scattering_texture_unit, irradiance_texture_unit,
+        single_mie_scattering_texture_unit);
+}
+
+/*
+<p>The precomputed textures can be read back and uploaded again, to avoid
+recomputing them when the model parameters did not change (e.g. by storing them
+in a cache on disk). The key identifying the content of these textures is the
+hash of the model parameters, combined with the number of scattering orders,
+the convergence tolerance and the adaptive quadrature passes (if any):
+*/
+
+std::uint64_t Model::GetPrecomputedTexturesKey(
+    unsigned int num_scattering_orders, double convergence_tolerance,
+    unsigned int adaptive_quadrature_passes) const {
+  return HashInitArguments(parameters_hash_, num_scattering_orders,
+      convergence_tolerance, adaptive_quadrature_passes);
+}
+
+std::size_t Model::GetPrecomputedTexturesSize() const {
+  return 3 * (resolution_.transmittance_size() +
+      resolution_.irradiance_size()) +
+      (combine_scattering_textures_ ? 4 : 6) * resolution_.scattering_size();
+}
+
+std::size_t Model::GetPrecomputedTexturesMemorySize() const {
+  // The 2D textures are always RGBA32F, while the format of the 3D ones depends
+  // on the storage format, on the RGB format support and on the precomputation
+  // backend (see Init).
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_3D, scattering_texture_);
+  GLint internal_format;
+  glGetTexLevelParameteriv(GL_TEXTURE_3D, 0, GL_TEXTURE_INTERNAL_FORMAT,
+      &internal_format);
+  std::size_t scattering_texel_size;
+  switch (internal_format) {
+    case GL_RGB9_E5:
+      scattering_texel_size = 4;
+      break;
+    case GL_RGB16F:
+      scattering_texel_size = 6;
+      break;
+    case GL_RGBA16F:
+      scattering_texel_size = 8;
+      break;
+    case GL_RGB32F:
+      scattering_texel_size = 12;
+      break;
+    default:
+      scattering_texel_size = 16;
+      break;
+  }
+  const std::size_t num_scattering_textures =
+      combine_scattering_textures_ ? 1 : 2;
+  return 4 * sizeof(float) *
+      (resolution_.transmittance_size() + resolution_.irradiance_size()) +
+      num_scattering_textures * scattering_texel_size *
+          resolution_.scattering_size();
+}
+
+void Model::GetPrecomputedTextures(float* data) const {
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glActiveTexture(GL_TEXTURE0);
+
+  glBindTexture(GL_TEXTURE_2D, transmittance_texture_);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_FLOAT, data);
+  data += 3 * resolution_.transmittance_size();
+
+  glBindTexture(GL_TEXTURE_3D, scattering_texture_);
+  if (combine_scattering_textures_) {
+    glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_FLOAT, data);
+    data += 4 * resolution_.scattering_size();
+  } else {
+    glGetTexImage(GL_TEXTURE_3D, 0, GL_RGB, GL_FLOAT, data);
+    data += 3 * resolution_.scattering_size();
+
+    glBindTexture(GL_TEXTURE_3D, optional_single_mie_scattering_texture_);
+    glGetTexImage(GL_TEXTURE_3D, 0, GL_RGB, GL_FLOAT, data);
+    data += 3 * resolution_.scattering_size();
+  }
+
+  glBindTexture(GL_TEXTURE_2D, irradiance_texture_);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_FLOAT, data);
+}
+
+void Model::SetPrecomputedTextures(const float* data,
+    unsigned int num_precomputed_scattering_orders) {
+  num_precomputed_scattering_orders_ = num_precomputed_scattering_orders;
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glActiveTexture(GL_TEXTURE0);
+
+  glBindTexture(GL_TEXTURE_2D, transmittance_texture_);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+      resolution_.transmittance_width, resolution_.transmittance_height,
+      GL_RGB, GL_FLOAT, data);
+  data += 3 * resolution_.transmittance_size();
+
+  glBindTexture(GL_TEXTURE_3D, scattering_texture_);
+  if (combine_scattering_textures_) {
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, resolution_.scattering_width(),
+        resolution_.scattering_height(), resolution_.scattering_depth(),
+        GL_RGBA, GL_FLOAT, data);
+    data += 4 * resolution_.scattering_size();
+  } else {
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, resolution_.scattering_width(),
+        resolution_.scattering_height(), resolution_.scattering_depth(),
+        GL_RGB, GL_FLOAT, data);
+    data += 3 * resolution_.scattering_size();
+
     glBindTexture(GL_TEXTURE_3D, optional_single_mie_scattering_texture_);
-    glUniform1i(glGetUniformLocation(program, single_mie_scattering_texture_name.c_str()), single_mie_scattering_texture_unit);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, resolution_.scattering_width(),
+        resolution_.scattering_height(), resolution_.scattering_depth(),
+        GL_RGB, GL_FLOAT, data);
+    data += 3 * resolution_.scattering_size();
+  }
+
+  glBindTexture(GL_TEXTURE_2D, irradiance_texture_);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+      resolution_.irradiance_width, resolution_.irradiance_height,
+      GL_RGB, GL_FLOAT, data);
+}
+
+/*
+<p>Since all the precomputed textures are linear in the irradiance of the light
+source, two models differing only in their light source can share the same
+textures, the second one simply scaling the values read from them by the ratio
+of the two source irradiances (see SetProgramSourceUniforms). The same applies
+to a source irradiance set at rendering time with SetSource:
+*/
+
+void Model::ShareTexturesFrom(const Model& model) {
+  assert(&model != this);
+  assert(model.combine_scattering_textures_ == combine_scattering_textures_);
+  if (owns_textures_) {
+    glDeleteTextures(1, &transmittance_texture_);
+    glDeleteTextures(1, &scattering_texture_);
+    glDeleteTextures(1, &optional_single_mie_scattering_texture_);
+    glDeleteTextures(1, &irradiance_texture_);
+  }
+  transmittance_texture_ = model.transmittance_texture_;
+  scattering_texture_ = model.scattering_texture_;
+  optional_single_mie_scattering_texture_ =
+      model.optional_single_mie_scattering_texture_;
+  irradiance_texture_ = model.irradiance_texture_;
+  owns_textures_ = false;
+  num_precomputed_scattering_orders_ =
+      model.num_precomputed_scattering_orders_;
+
+  precomputed_irradiance_ = model.precomputed_irradiance_;
+}
+
+void Model::SetSource(const glm::dvec3& irradiance, double angular_radius) {
+  source_irradiance_ = irradiance;
+  source_angular_radius_ = angular_radius;
 }
 
 /*
@@ -931,8 +1822,8 @@ described in Algorithm 4.1 of
 <a href="https://hal.inria.fr/inria-00288758/en">our paper</a>. Each step is
 explained by the inline comments below.
 */
-void Model::Precompute(
-    GLuint fbo,
+bool Model::Precompute(
+    GLuint /*fbo*/,
     GLuint delta_irradiance_texture,
     GLuint delta_rayleigh_scattering_texture,
     GLuint delta_mie_scattering_texture,
@@ -941,11 +1832,15 @@ void Model::Precompute(
     const vec3& lambdas,
     const mat3& luminance_from_radiance,
     bool blend,
-    unsigned int num_scattering_orders) {
+    unsigned int num_scattering_orders,
+    double convergence_tolerance,
+    unsigned int adaptive_quadrature_passes,
+    const ProgressCallback& progress) {
   // The precomputations require specific GLSL programs, for each precomputation
   // step. We create and compile them here (they are automatically destroyed
   // when this method returns, via the Program destructor).
-  std::string header = glsl_header_factory_(lambdas);
+  std::string header =
+      glsl_header_factory_(lambdas, adaptive_quadrature_passes);
   Program compute_transmittance(
       kVertexShader, header + kComputeTransmittanceShader);
   Program compute_direct_irradiance(
@@ -972,7 +1867,8 @@ void Model::Precompute(
   glFramebufferTexture(
       GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, transmittance_texture_, 0);
   glDrawBuffer(GL_COLOR_ATTACHMENT0);
-  glViewport(0, 0, TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT);
+  glViewport(0, 0, resolution_.transmittance_width,
+      resolution_.transmittance_height);
   compute_transmittance.Use();
   DrawQuad({}, full_screen_quad_vao_);
 
@@ -985,7 +1881,7 @@ void Model::Precompute(
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
       irradiance_texture_, 0);
   glDrawBuffers(2, kDrawBuffers);
-  glViewport(0, 0, IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT);
+  glViewport(0, 0, resolution_.irradiance_width, resolution_.irradiance_height);
   compute_direct_irradiance.Use();
   compute_direct_irradiance.BindTexture2d(
       "transmittance_texture", transmittance_texture_, 0);
@@ -995,31 +1891,43 @@ void Model::Precompute(
   // Compute the rayleigh and mie single scattering, store them in
   // delta_rayleigh_scattering_texture and delta_mie_scattering_texture, and
   // either store them or accumulate them in scattering_texture_ and
-  // optional_single_mie_scattering_texture_.
+  // optional_single_mie_scattering_texture_ (if any).
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
       delta_rayleigh_scattering_texture, 0);
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
       delta_mie_scattering_texture, 0);
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2,
       scattering_texture_, 0);
-  glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3,
+  if (optional_single_mie_scattering_texture_ == 0) {
+    glDrawBuffers(3, kDrawBuffers);
+  } else {
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3,
         optional_single_mie_scattering_texture_, 0);
-  glDrawBuffers(4, kDrawBuffers);
-  glViewport(0, 0, SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT);
+    glDrawBuffers(4, kDrawBuffers);
+  }
+  glViewport(0, 0, resolution_.scattering_width(),
+      resolution_.scattering_height());
   compute_single_scattering.Use();
   compute_single_scattering.BindMat3(
       "luminance_from_radiance", luminance_from_radiance);
   compute_single_scattering.BindTexture2d(
       "transmittance_texture", transmittance_texture_, 0);
   compute_single_scattering.BindInt("source", light_source_);
-  for (unsigned int layer = 0; layer < SCATTERING_TEXTURE_DEPTH; ++layer) {
+  for (int layer = 0; layer < resolution_.scattering_depth(); ++layer) {
     compute_single_scattering.BindInt("layer", layer);
     DrawQuad({false, false, blend, blend}, full_screen_quad_vao_);
   }
-
-  // Compute the 2nd, 3rd and 4th order of scattering, in sequence.
+  bool completed = !progress || progress(1);
+  num_precomputed_scattering_orders_ = 1;
+  double total_energy = convergence_tolerance > 0.0 ?
+      GetSingleScatteringEnergy(delta_rayleigh_scattering_texture,
+          delta_mie_scattering_texture) : 0.0;
+  bool converged = false;
+
+  // Compute the 2nd, 3rd and 4th order of scattering, in sequence (unless the
+  // precomputation is cancelled by the progress callback, or has converged).
   for (unsigned int scattering_order = 2;
-       scattering_order <= num_scattering_orders;
+       completed && !converged && scattering_order <= num_scattering_orders;
        ++scattering_order) {
     // Compute the scattering density, and store it in
     // delta_scattering_density_texture.
@@ -1029,7 +1937,8 @@ void Model::Precompute(
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, 0, 0);
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, 0, 0);
     glDrawBuffer(GL_COLOR_ATTACHMENT0);
-    glViewport(0, 0, SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT);
+    glViewport(0, 0, resolution_.scattering_width(),
+        resolution_.scattering_height());
     compute_scattering_density.Use();
     compute_scattering_density.BindTexture2d(
         "transmittance_texture", transmittance_texture_, 0);
@@ -1044,7 +1953,7 @@ void Model::Precompute(
     compute_scattering_density.BindTexture2d(
         "irradiance_texture", delta_irradiance_texture, 4);
     compute_scattering_density.BindInt("scattering_order", scattering_order);
-    for (unsigned int layer = 0; layer < SCATTERING_TEXTURE_DEPTH; ++layer) {
+    for (int layer = 0; layer < resolution_.scattering_depth(); ++layer) {
       compute_scattering_density.BindInt("layer", layer);
       DrawQuad({}, full_screen_quad_vao_);
     }
@@ -1056,7 +1965,8 @@ void Model::Precompute(
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
         irradiance_texture_, 0);
     glDrawBuffers(2, kDrawBuffers);
-    glViewport(0, 0, IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT);
+    glViewport(0, 0, resolution_.irradiance_width,
+        resolution_.irradiance_height);
     compute_indirect_irradiance.Use();
     compute_indirect_irradiance.BindMat3(
         "luminance_from_radiance", luminance_from_radiance);
@@ -1080,7 +1990,8 @@ void Model::Precompute(
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
         scattering_texture_, 0);
     glDrawBuffers(2, kDrawBuffers);
-    glViewport(0, 0, SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT);
+    glViewport(0, 0, resolution_.scattering_width(),
+        resolution_.scattering_height());
     compute_multiple_scattering.Use();
     compute_multiple_scattering.BindMat3(
         "luminance_from_radiance", luminance_from_radiance);
@@ -1088,14 +1999,247 @@ void Model::Precompute(
         "transmittance_texture", transmittance_texture_, 0);
     compute_multiple_scattering.BindTexture3d(
         "scattering_density_texture", delta_scattering_density_texture, 1);
-    for (unsigned int layer = 0; layer < SCATTERING_TEXTURE_DEPTH; ++layer) {
+    for (int layer = 0; layer < resolution_.scattering_depth(); ++layer) {
       compute_multiple_scattering.BindInt("layer", layer);
       DrawQuad({false, true}, full_screen_quad_vao_);
     }
+    num_precomputed_scattering_orders_ = scattering_order;
+    completed = !progress || progress(scattering_order);
+    if (convergence_tolerance > 0.0) {
+      double energy = GetAverageValue3d(delta_multiple_scattering_texture);
+      total_energy += energy;
+      converged = energy < convergence_tolerance * total_energy;
+    }
   }
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, 0, 0);
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, 0, 0);
   glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, 0, 0);
+  return completed;
+}
+
+/*
+<p>The compute shader backend requires OpenGL 4.3, which is not guaranteed by
+the OpenGL 3.3 context requested by the application, but which is often
+provided anyway (most drivers return the highest version they support for a
+core profile context). It is thus selected at runtime, depending on the actual
+version of the current context:
+*/
+
+bool Model::LoadComputeShaderFunctions(GLADloadproc load) {
+  GLint major_version = 0;
+  GLint minor_version = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+  glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+  compute_shader_functions = {};
+  if (major_version < 4 || (major_version == 4 && minor_version < 3)) {
+    return false;
+  }
+  compute_shader_functions.dispatch_compute =
+      reinterpret_cast<decltype(compute_shader_functions.dispatch_compute)>(
+          load("glDispatchCompute"));
+  compute_shader_functions.bind_image_texture =
+      reinterpret_cast<decltype(compute_shader_functions.bind_image_texture)>(
+          load("glBindImageTexture"));
+  compute_shader_functions.memory_barrier =
+      reinterpret_cast<decltype(compute_shader_functions.memory_barrier)>(
+          load("glMemoryBarrier"));
+  compute_shader_functions.supported =
+      compute_shader_functions.dispatch_compute != nullptr &&
+      compute_shader_functions.bind_image_texture != nullptr &&
+      compute_shader_functions.memory_barrier != nullptr;
+  return compute_shader_functions.supported;
+}
+
+bool Model::IsComputeShaderBackendSupported() {
+  return compute_shader_functions.supported;
+}
+
+/*
+<p>The compute shader version of the precomputations follows the same steps as
+<code>Precompute</code>, but with fewer synchronization points and a smaller
+memory footprint:
+<ul>
+<li>each step is a single dispatch over the whole output texture(s), instead of
+one draw call per layer of the 3D textures, and there is no framebuffer
+attachment and blending state to change between the steps,</li>
+<li>the direct irradiance and single scattering steps only depend on the
+transmittance, and are dispatched one after the other with no barrier between
+them. Likewise, the scattering density and indirect irradiance steps of each
+scattering order only depend on the previous order, provided the new delta
+irradiance is not written in the texture read by the scattering density step.
+We thus use two delta irradiance textures alternately,</li>
+<li><code>delta_mie_scattering_texture</code> is only needed to compute double
+scattering, and is thus deleted just after this (the delta textures of the
+fragment shader version stay allocated until the end of the
+precomputations).</li>
+</ul>
+*/
+
+bool Model::PrecomputeWithComputeShaders(
+    GLuint delta_irradiance_texture,
+    GLuint delta_rayleigh_scattering_texture,
+    GLuint& delta_mie_scattering_texture,
+    GLuint delta_scattering_density_texture,
+    GLuint delta_multiple_scattering_texture,
+    const vec3& lambdas,
+    const mat3& luminance_from_radiance,
+    bool blend,
+    unsigned int num_scattering_orders,
+    double convergence_tolerance,
+    unsigned int adaptive_quadrature_passes,
+    const ProgressCallback& progress) {
+  // The GLSL header starts with a "#version 330" line, which must be replaced
+  // to enable compute shaders.
+  std::string header =
+      glsl_header_factory_(lambdas, adaptive_quadrature_passes);
+  header = "#version 430\n" + header.substr(header.find('\n') + 1);
+  Program compute_transmittance(header + kTransmittanceComputeShader);
+  Program compute_direct_irradiance(header + kDirectIrradianceComputeShader);
+  Program compute_single_scattering(header + kSingleScatteringComputeShader);
+  Program compute_scattering_density(
+      header + kScatteringDensityComputeShader);
+  Program compute_indirect_irradiance(
+      header + kIndirectIrradianceComputeShader);
+  Program compute_multiple_scattering(
+      header + kMultipleScatteringComputeShader);
+
+  // The second delta irradiance texture (see above).
+  GLuint delta_irradiance_textures[2] = {
+    delta_irradiance_texture,
+    NewTexture2d(resolution_.irradiance_width, resolution_.irradiance_height)
+  };
+
+  // Compute the transmittance, and store it in transmittance_texture_.
+  compute_transmittance.Use();
+  BindImage(0, transmittance_texture_, GL_WRITE_ONLY);
+  Dispatch(resolution_.transmittance_width, resolution_.transmittance_height);
+  ImageBarrier();
+
+  // Compute the direct irradiance, store it in delta_irradiance_textures[0]
+  // and, depending on 'blend', either initialize irradiance_texture_ with zeros
+  // or leave it unchanged.
+  compute_direct_irradiance.Use();
+  compute_direct_irradiance.BindTexture2d(
+      "transmittance_texture", transmittance_texture_, 0);
+  compute_direct_irradiance.BindInt("source", light_source_);
+  compute_direct_irradiance.BindInt("blend", blend);
+  BindImage(0, delta_irradiance_textures[0], GL_WRITE_ONLY);
+  BindImage(1, irradiance_texture_, GL_READ_WRITE);
+  Dispatch(resolution_.irradiance_width, resolution_.irradiance_height);
+
+  // Compute the rayleigh and mie single scattering, store them in
+  // delta_rayleigh_scattering_texture and delta_mie_scattering_texture, and
+  // either store them or accumulate them in scattering_texture_ and
+  // optional_single_mie_scattering_texture_ (if any).
+  compute_single_scattering.Use();
+  compute_single_scattering.BindMat3(
+      "luminance_from_radiance", luminance_from_radiance);
+  compute_single_scattering.BindTexture2d(
+      "transmittance_texture", transmittance_texture_, 0);
+  compute_single_scattering.BindInt("source", light_source_);
+  compute_single_scattering.BindInt("blend", blend);
+  BindImage(0, delta_rayleigh_scattering_texture, GL_WRITE_ONLY);
+  BindImage(1, delta_mie_scattering_texture, GL_WRITE_ONLY);
+  BindImage(2, scattering_texture_, GL_READ_WRITE);
+  if (optional_single_mie_scattering_texture_ != 0) {
+    BindImage(3, optional_single_mie_scattering_texture_, GL_READ_WRITE);
+  }
+  Dispatch(resolution_.scattering_width(), resolution_.scattering_height(),
+      resolution_.scattering_depth());
+  ImageBarrier();
+  bool completed = !progress || progress(1);
+  num_precomputed_scattering_orders_ = 1;
+  double total_energy = convergence_tolerance > 0.0 ?
+      GetSingleScatteringEnergy(delta_rayleigh_scattering_texture,
+          delta_mie_scattering_texture) : 0.0;
+  bool converged = false;
+
+  // Compute the 2nd, 3rd and 4th order of scattering, in sequence (unless the
+  // precomputation is cancelled by the progress callback, or has converged).
+  for (unsigned int scattering_order = 2;
+       completed && !converged && scattering_order <= num_scattering_orders;
+       ++scattering_order) {
+    GLuint previous_delta_irradiance_texture =
+        delta_irradiance_textures[scattering_order % 2];
+    GLuint next_delta_irradiance_texture =
+        delta_irradiance_textures[(scattering_order + 1) % 2];
+
+    // Compute the scattering density, and store it in
+    // delta_scattering_density_texture.
+    compute_scattering_density.Use();
+    compute_scattering_density.BindTexture2d(
+        "transmittance_texture", transmittance_texture_, 0);
+    compute_scattering_density.BindTexture3d(
+        "single_rayleigh_scattering_texture",
+        delta_rayleigh_scattering_texture,
+        1);
+    compute_scattering_density.BindTexture3d(
+        "single_mie_scattering_texture", delta_mie_scattering_texture, 2);
+    compute_scattering_density.BindTexture3d(
+        "multiple_scattering_texture", delta_multiple_scattering_texture, 3);
+    compute_scattering_density.BindTexture2d(
+        "irradiance_texture", previous_delta_irradiance_texture, 4);
+    compute_scattering_density.BindInt("scattering_order", scattering_order);
+    BindImage(0, delta_scattering_density_texture, GL_WRITE_ONLY);
+    Dispatch(resolution_.scattering_width(), resolution_.scattering_height(),
+        resolution_.scattering_depth());
+
+    // Compute the indirect irradiance, store it in the other delta irradiance
+    // texture, and accumulate it in irradiance_texture_.
+    compute_indirect_irradiance.Use();
+    compute_indirect_irradiance.BindMat3(
+        "luminance_from_radiance", luminance_from_radiance);
+    compute_indirect_irradiance.BindTexture3d(
+        "single_rayleigh_scattering_texture",
+        delta_rayleigh_scattering_texture,
+        0);
+    compute_indirect_irradiance.BindTexture3d(
+        "single_mie_scattering_texture", delta_mie_scattering_texture, 1);
+    compute_indirect_irradiance.BindTexture3d(
+        "multiple_scattering_texture", delta_multiple_scattering_texture, 2);
+    compute_indirect_irradiance.BindInt("scattering_order",
+        scattering_order - 1);
+    BindImage(0, next_delta_irradiance_texture, GL_WRITE_ONLY);
+    BindImage(1, irradiance_texture_, GL_READ_WRITE);
+    Dispatch(resolution_.irradiance_width, resolution_.irradiance_height);
+    ImageBarrier();
+
+    // The single scattering is not needed anymore for the next orders.
+    if (scattering_order == 2) {
+      glDeleteTextures(1, &delta_mie_scattering_texture);
+      delta_mie_scattering_texture = 0;
+    }
+
+    // Compute the multiple scattering, store it in
+    // delta_multiple_scattering_texture, and accumulate it in
+    // scattering_texture_.
+    compute_multiple_scattering.Use();
+    compute_multiple_scattering.BindMat3(
+        "luminance_from_radiance", luminance_from_radiance);
+    compute_multiple_scattering.BindTexture2d(
+        "transmittance_texture", transmittance_texture_, 0);
+    compute_multiple_scattering.BindTexture3d(
+        "scattering_density_texture", delta_scattering_density_texture, 1);
+    BindImage(0, delta_multiple_scattering_texture, GL_WRITE_ONLY);
+    BindImage(1, scattering_texture_, GL_READ_WRITE);
+    Dispatch(resolution_.scattering_width(), resolution_.scattering_height(),
+        resolution_.scattering_depth());
+    ImageBarrier();
+    num_precomputed_scattering_orders_ = scattering_order;
+    completed = !progress || progress(scattering_order);
+    if (convergence_tolerance > 0.0) {
+      double energy = GetAverageValue3d(delta_multiple_scattering_texture);
+      total_energy += energy;
+      converged = energy < convergence_tolerance * total_energy;
+    }
+  }
+
+  // Make the results visible to the texture fetches and read backs done after
+  // this method.
+  compute_shader_functions.memory_barrier(
+      GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+  glDeleteTextures(1, &delta_irradiance_textures[1]);
+  return completed;
 }
 
 }  // namespace atmosphere
@@ -39,7 +39,9 @@ parameters.</li>
 atmosphere shading functions.</li>
 <li>for each GLSL program linked with <code>GetShader</code>, call
 <code>SetProgramUniforms</code> to bind the precomputed textures to this
-program (usually at each frame).</li>
+program (usually at each frame), or call <code>BindTextures</code> once to
+keep the precomputed textures bound to dedicated texture units, and
+<code>SetProgramSamplers</code> once per program after it is linked.</li>
 <li>delete your <code>Model</code> when you no longer need its shader and
 precomputed textures (the destructor deletes these resources).</li>
 </ul>
@@ -151,12 +153,16 @@ parameter):
 
 #include <glad/glad.h>
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "atmosphere/constants.h"
+
 #define SOURCE_SUN 0
 #define SOURCE_MOON 1
 
@@ -182,6 +188,90 @@ class DensityProfileLayer {
   double constant_term;
 };
 
+// The method used to precompute the textures in Model::Init.
+enum PrecomputationBackend {
+  // Full screen quads rendered in framebuffers, with a geometry shader to
+  // select the layer of the 3D textures (requires OpenGL 3.3).
+  FRAGMENT_SHADER,
+  // Compute shaders dispatched directly over the textures, which they write
+  // with image stores (requires OpenGL 4.3, see LoadComputeShaderFunctions).
+  COMPUTE_SHADER
+};
+
+// The precomputation passes whose integrals can be computed with an adaptive
+// quadrature in Model::Init, instead of with a fixed number of samples (see
+// functions.glsl), as bit flags. The adaptive quadratures stop refining an
+// estimate once its relative change is less than 1e-3.
+enum AdaptiveQuadraturePass {
+  ADAPTIVE_TRANSMITTANCE_QUADRATURE = 1,
+  ADAPTIVE_SINGLE_SCATTERING_QUADRATURE = 2,
+  ADAPTIVE_SCATTERING_DENSITY_QUADRATURE = 4,
+  ADAPTIVE_MULTIPLE_SCATTERING_QUADRATURE = 8,
+  ALL_ADAPTIVE_QUADRATURES = 15
+};
+
+// The dimensions of the precomputed textures (see functions.glsl for their
+// meaning). The default values, from constants.h, are those of the
+// DEFAULT_RESOLUTION tier. Higher resolutions reduce the interpolation errors,
+// at the cost of longer precomputations and more GPU memory.
+struct TextureResolution {
+  int transmittance_width = TRANSMITTANCE_TEXTURE_WIDTH;
+  int transmittance_height = TRANSMITTANCE_TEXTURE_HEIGHT;
+  int scattering_r_size = SCATTERING_TEXTURE_R_SIZE;
+  int scattering_mu_size = SCATTERING_TEXTURE_MU_SIZE;
+  int scattering_mu_s_size = SCATTERING_TEXTURE_MU_S_SIZE;
+  int scattering_nu_size = SCATTERING_TEXTURE_NU_SIZE;
+  int irradiance_width = IRRADIANCE_TEXTURE_WIDTH;
+  int irradiance_height = IRRADIANCE_TEXTURE_HEIGHT;
+
+  int scattering_width() const {
+    return scattering_nu_size * scattering_mu_s_size;
+  }
+  int scattering_height() const { return scattering_mu_size; }
+  int scattering_depth() const { return scattering_r_size; }
+
+  // The number of texels of each texture.
+  std::size_t transmittance_size() const {
+    return static_cast<std::size_t>(transmittance_width) * transmittance_height;
+  }
+  std::size_t scattering_size() const {
+    return static_cast<std::size_t>(scattering_width()) * scattering_height() *
+        scattering_depth();
+  }
+  std::size_t irradiance_size() const {
+    return static_cast<std::size_t>(irradiance_width) * irradiance_height;
+  }
+};
+
+// Predefined texture resolutions.
+enum TextureResolutionTier {
+  // Half the default resolution in each dimension (except nu), for low end
+  // GPUs (about 8 times less memory and precomputation time).
+  LOW_RESOLUTION,
+  // The resolution of the original implementation.
+  DEFAULT_RESOLUTION,
+  // Twice the default resolution in each dimension, except mu_s (to limit the
+  // scattering textures to 128 MB each), used as ground truth to measure
+  // the errors of the other tiers.
+  REFERENCE_RESOLUTION
+};
+
+TextureResolution GetTextureResolution(TextureResolutionTier tier);
+
+// The storage format of the precomputed 3D scattering textures. The
+// precomputations are always done with 32 bits floats, and the results are
+// converted to this format at the end of Model::Init.
+enum ScatteringTextureFormat {
+  // 32 bits floats per channel.
+  FULL_PRECISION,
+  // 16 bits floats per channel.
+  HALF_PRECISION,
+  // 9 bits mantissas per channel, with a shared 5 bits exponent (RGB9E5, i.e.
+  // 32 bits per texel). This format has no alpha channel, so combined
+  // scattering textures use HALF_PRECISION instead.
+  SHARED_EXPONENT
+};
+
 class Model {
  public:
   Model(
@@ -258,14 +348,178 @@ class Model {
     // The length unit used in your shaders and meshes. This is the length unit
     // which must be used when calling the atmosphere model shader functions.
     double length_unit_in_meters,
-    int light_source);
+    int light_source,
+    // The dimensions of the precomputed textures.
+    const TextureResolution& resolution = TextureResolution(),
+    // Whether to pack the (red component of the) single Mie scattering with the
+    // Rayleigh and multiple scattering in a single texture, or to store the (3
+    // components of the) single Mie scattering in a separate texture. The
+    // combined mode halves the memory of the 3D textures and the number of
+    // texture lookups of the atmosphere shader, but extrapolates the green and
+    // blue components of the single Mie scattering (which is exact only if the
+    // Mie and Rayleigh scattering coefficients are proportional).
+    bool combine_scattering_textures = false,
+    // The storage format of the precomputed scattering textures (the
+    // transmittance and irradiance textures always use 32 bits floats).
+    ScatteringTextureFormat scattering_texture_format = FULL_PRECISION);
 
   ~Model();
 
-  void Init(unsigned int num_scattering_orders = 4);
+  // Called after each scattering order has been precomputed, with the number
+  // of scattering orders done so far. Returning false cancels the
+  // precomputation.
+  typedef std::function<bool(unsigned int)> ProgressCallback;
+
+  // Returns false if the precomputation was cancelled by 'progress', in which
+  // case the precomputed textures are incomplete. The COMPUTE_SHADER backend
+  // falls back to the FRAGMENT_SHADER one if it is not supported. If
+  // 'convergence_tolerance' is positive, 'num_scattering_orders' is only a
+  // maximum: the precomputation stops after the first scattering order whose
+  // average energy is less than 'convergence_tolerance' times the total energy
+  // of all the orders computed so far (see num_precomputed_scattering_orders).
+  // 'adaptive_quadrature_passes' is a combination of AdaptiveQuadraturePass
+  // flags.
+  bool Init(unsigned int num_scattering_orders = 4,
+      const ProgressCallback& progress = ProgressCallback(),
+      PrecomputationBackend backend = FRAGMENT_SHADER,
+      double convergence_tolerance = 0.0,
+      unsigned int adaptive_quadrature_passes = 0);
+
+  // Loads the OpenGL 4.3 functions needed by the COMPUTE_SHADER backend, which
+  // are not provided by the OpenGL 3.3 loader, with 'load'. Must be called
+  // with a current OpenGL context, before any Init call. Returns whether the
+  // COMPUTE_SHADER backend is supported by this context.
+  static bool LoadComputeShaderFunctions(GLADloadproc load);
+  static bool IsComputeShaderBackendSupported();
+
+  // The GPU time spent in the last Init call, in seconds (0 if Init has not
+  // been called), and the backend which was actually used for it.
+  double precomputation_time() const { return precomputation_time_; }
+  PrecomputationBackend precomputation_backend() const {
+    return precomputation_backend_;
+  }
+
+  // The number of scattering orders contained in the precomputed textures.
+  unsigned int num_precomputed_scattering_orders() const {
+    return num_precomputed_scattering_orders_;
+  }
 
   GLuint shader() const { return atmosphere_shader_; }
+  // A hash of the source of shader(). Programs linked with the shader of
+  // another model with the same hash do not need to be linked again to use
+  // this model (after binding its textures and setting its uniforms).
+  std::uint64_t shader_hash() const { return atmosphere_shader_hash_; }
+  const TextureResolution& resolution() const { return resolution_; }
+  bool combine_scattering_textures() const {
+    return combine_scattering_textures_;
+  }
+  ScatteringTextureFormat scattering_texture_format() const {
+    return scattering_texture_format_;
+  }
 
+  // Returns a hash of everything which determines the content of the
+  // precomputed textures: the constructor parameters, the texture sizes, the
+  // GLSL functions used to compute them, and the Init arguments which change
+  // their content. This can be used as the key of a persistent cache of
+  // precomputed textures.
+  std::uint64_t GetPrecomputedTexturesKey(unsigned int num_scattering_orders,
+      double convergence_tolerance = 0.0,
+      unsigned int adaptive_quadrature_passes = 0) const;
+
+  // Returns the GetPrecomputedTexturesKey value of a model constructed with
+  // the same arguments, without constructing it. Unlike the constructor, this
+  // does not need an OpenGL context, so that textures precomputed offline (e.g.
+  // by the CPU model of atmosphere/cpu) can be stored with the key of the model
+  // which will use them.
+  static std::uint64_t ComputePrecomputedTexturesKey(
+      const glm::dvec3& sun_irradiance,
+      double sun_angular_radius,
+      const glm::dvec3& moon_irradiance,
+      double moon_angular_radius,
+      double bottom_radius,
+      double top_radius,
+      const std::vector<DensityProfileLayer>& rayleigh_density,
+      const glm::dvec3& rayleigh_scattering,
+      const std::vector<DensityProfileLayer>& mie_density,
+      const glm::dvec3& mie_scattering,
+      const glm::dvec3& mie_extinction,
+      double mie_phase_function_g,
+      const std::vector<DensityProfileLayer>& absorption_density,
+      const glm::dvec3& absorption_extinction,
+      const glm::dvec3& ground_albedo,
+      double max_sun_zenith_angle,
+      double length_unit_in_meters,
+      int light_source,
+      const TextureResolution& resolution,
+      bool combine_scattering_textures,
+      ScatteringTextureFormat scattering_texture_format,
+      unsigned int num_scattering_orders,
+      double convergence_tolerance = 0.0,
+      unsigned int adaptive_quadrature_passes = 0);
+
+  // The number of floats needed to store all the precomputed textures, as RGB
+  // values, in the order transmittance, scattering, single Mie scattering and
+  // irradiance (this depends on the texture resolution). With combined
+  // scattering textures, the scattering values are RGBA (the alpha channel
+  // containing the red component of the single Mie scattering), and there are
+  // no single Mie scattering values.
+  std::size_t GetPrecomputedTexturesSize() const;
+
+  // The GPU memory used by the precomputed textures, in bytes (excluding the
+  // temporary textures which only exist during Init).
+  std::size_t GetPrecomputedTexturesMemorySize() const;
+
+  // Reads back the precomputed textures in 'data', which must contain at least
+  // GetPrecomputedTexturesSize() floats.
+  void GetPrecomputedTextures(float* data) const;
+
+  // Uploads textures previously read with GetPrecomputedTextures (possibly by
+  // another Model instance with the same key). This can be used instead of
+  // Init. 'num_precomputed_scattering_orders' is the value returned by
+  // num_precomputed_scattering_orders() for the textures in 'data'.
+  void SetPrecomputedTextures(const float* data,
+      unsigned int num_precomputed_scattering_orders);
+
+  // Uses the precomputed textures of 'model' instead of precomputing them
+  // again, which can be used instead of Init. 'model' must have the same
+  // parameters, except for its light source (in particular the same
+  // combine_scattering_textures value), and must outlive this model. The
+  // precomputed values being linear in the source irradiance, they are scaled
+  // in the atmosphere shader by the ratio between the irradiance of the light
+  // source of this model and that of 'model'. This ignores the difference in
+  // angular radius between the two light sources, whose effect is negligible.
+  void ShareTexturesFrom(const Model& model);
+
+  // Sets the irradiance and angular radius of the light source of this model
+  // at rendering time, which are otherwise those given to the constructor. The
+  // precomputed values being linear in the source irradiance, they are scaled
+  // by the ratio between this irradiance and the one they were precomputed
+  // for, so that they can be precomputed once (e.g. for a unit irradiance) for
+  // any date. The programs must then be updated with SetProgramSourceUniforms.
+  void SetSource(const glm::dvec3& irradiance, double angular_radius);
+
+  // 'optional_single_mie_scattering_texture_unit' is unused with combined
+  // scattering textures. Leaves the last of these units active.
+  void BindTextures(
+      GLuint transmittance_texture_unit,
+      GLuint scattering_texture_unit,
+      GLuint irradiance_texture_unit,
+      GLuint optional_single_mie_scattering_texture_unit = 0) const;
+
+  // Sets the samplers (and the source uniforms) of 'program', which must be in
+  // use, to the texture units given to BindTextures.
+  void SetProgramSamplers(
+      GLuint program,
+      GLuint transmittance_texture_unit,
+      GLuint scattering_texture_unit,
+      GLuint irradiance_texture_unit,
+      GLuint optional_single_mie_scattering_texture_unit = 0) const;
+
+  // Sets the radiance scale and the source irradiance and angular radius of
+  // 'program', which must be in use. Also done by SetProgramSamplers.
+  void SetProgramSourceUniforms(GLuint program) const;
+
+  // BindTextures followed by SetProgramSamplers.
   void SetProgramUniforms(
       GLuint program,
       GLuint transmittance_texture_unit,
@@ -280,8 +534,35 @@ class Model {
  private:
   typedef std::array<double, 3> vec3;
   typedef std::array<float, 9> mat3;
-
-  void Precompute(
+  typedef std::function<std::string(const vec3&, unsigned int)>
+      GlslHeaderFactory;
+
+  static GlslHeaderFactory NewGlslHeaderFactory(
+      const glm::dvec3& sun_irradiance,
+      double sun_angular_radius,
+      const glm::dvec3& moon_irradiance,
+      double moon_angular_radius,
+      double bottom_radius,
+      double top_radius,
+      const std::vector<DensityProfileLayer>& rayleigh_density,
+      const glm::dvec3& rayleigh_scattering,
+      const std::vector<DensityProfileLayer>& mie_density,
+      const glm::dvec3& mie_scattering,
+      const glm::dvec3& mie_extinction,
+      double mie_phase_function_g,
+      const std::vector<DensityProfileLayer>& absorption_density,
+      const glm::dvec3& absorption_extinction,
+      const glm::dvec3& ground_albedo,
+      double max_sun_zenith_angle,
+      double length_unit_in_meters,
+      const TextureResolution& resolution,
+      bool combine_scattering_textures);
+
+  static std::uint64_t HashParameters(
+      const GlslHeaderFactory& glsl_header_factory, int light_source,
+      ScatteringTextureFormat scattering_texture_format);
+
+  bool Precompute(
       GLuint fbo,
       GLuint delta_irradiance_texture,
       GLuint delta_rayleigh_scattering_texture,
@@ -291,18 +572,49 @@ class Model {
       const vec3& lambdas,
       const mat3& luminance_from_radiance,
       bool blend,
-      unsigned int num_scattering_orders);
+      unsigned int num_scattering_orders,
+      double convergence_tolerance,
+      unsigned int adaptive_quadrature_passes,
+      const ProgressCallback& progress);
 
+  bool PrecomputeWithComputeShaders(
+      GLuint delta_irradiance_texture,
+      GLuint delta_rayleigh_scattering_texture,
+      GLuint& delta_mie_scattering_texture,
+      GLuint delta_scattering_density_texture,
+      GLuint delta_multiple_scattering_texture,
+      const vec3& lambdas,
+      const mat3& luminance_from_radiance,
+      bool blend,
+      unsigned int num_scattering_orders,
+      double convergence_tolerance,
+      unsigned int adaptive_quadrature_passes,
+      const ProgressCallback& progress);
+
+  TextureResolution resolution_;
+  bool combine_scattering_textures_;
+  ScatteringTextureFormat scattering_texture_format_;
   bool rgb_format_supported_;
-  std::function<std::string(const vec3&)> glsl_header_factory_;
+  GlslHeaderFactory glsl_header_factory_;
+  std::uint64_t parameters_hash_;
+  std::uint64_t atmosphere_shader_hash_;
   GLuint transmittance_texture_;
   GLuint scattering_texture_;
   GLuint optional_single_mie_scattering_texture_;
   GLuint irradiance_texture_;
+  bool owns_textures_;
+  glm::dvec3 source_irradiance_;
+  double source_angular_radius_;
+  // The source irradiance of the precomputed textures (those of another model
+  // with ShareTexturesFrom).
+  glm::dvec3 precomputed_irradiance_;
   GLuint atmosphere_shader_;
   GLuint full_screen_quad_vao_;
   GLuint full_screen_quad_vbo_;
   int light_source_;
+  double precomputation_time_;
+  PrecomputationBackend precomputation_backend_;
+  unsigned int num_precomputed_scattering_orders_;
 };
 
 }  // namespace atmosphere
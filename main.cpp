@@ -1,12 +1,66 @@
 #include "Window.h"
+#include "SkyBenchmark.h"
+#include "EphemerisBatch.h"
+#include "Ephemeris.h"
+#include "CpuReference.h"
+#include "PhysicalSky.h"
 
 #include <nfd.hpp>
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
-int main()
+namespace
 {
+    // miri-tfm --benchmark <script> [--output <file>]
+    int RunBenchmark(const std::string& scriptPath, const std::string& outputPath)
+    {
+        SkyBenchmark benchmark = SkyBenchmark();
+        if (!benchmark.Load(scriptPath)) return EXIT_FAILURE;
+        benchmark.SetOutputPath(outputPath);
+
+        Window window = Window(benchmark.GetWidth(), benchmark.GetHeight());
+        window.Init();
+        return window.RunBenchmark(benchmark) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string benchmarkScriptPath;
+    std::string benchmarkOutputPath;
+    long long ephemerisBenchmarkCount = 0;
+    std::string cpuPrecomputeDirectory;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) benchmarkScriptPath = argv[++i];
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) benchmarkOutputPath = argv[++i];
+        else if (std::strcmp(argv[i], "--ephemeris-benchmark") == 0 && i + 1 < argc) ephemerisBenchmarkCount = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--cpu-precompute") == 0 && i + 1 < argc) cpuPrecomputeDirectory = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--benchmark <script> [--output <file>]] [--ephemeris-benchmark <instants>] [--cpu-precompute <directory>]" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    // Does not need a window
+    if (ephemerisBenchmarkCount > 0)
+    {
+        EphemerisBatch::RunBenchmark(static_cast<std::size_t>(ephemerisBenchmarkCount));
+        Ephemeris::RunBenchmark(static_cast<std::size_t>(ephemerisBenchmarkCount));
+        return EXIT_SUCCESS;
+    }
+
+    // Does not need a window either, the textures of the default parameters are stored in the LUT cache format
+    if (!cpuPrecomputeDirectory.empty())
+    {
+        LutCache lutCache(cpuPrecomputeDirectory);
+        return CpuReference::Precompute(PhysicalSky::GetDefaultModelParameters(), lutCache) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     glfwSetErrorCallback([](int error_code, const char* description)
     {
         std::cerr << "[glfw] E(" << error_code << "): " << description << std::endl;
@@ -18,6 +72,13 @@ int main()
         std::exit(EXIT_FAILURE);
     }
 
+    if (!benchmarkScriptPath.empty())
+    {
+        int status = RunBenchmark(benchmarkScriptPath, benchmarkOutputPath);
+        glfwTerminate();
+        return status;
+    }
+
     else if (NFD::Init() != NFD_OKAY)
     {
         std::cerr << "[NFD] E: Could not be initialized." << std::endl;
@@ -33,4 +94,4 @@ int main()
 
     NFD::Quit();
     glfwTerminate();
-}
+}
\ No newline at end of file
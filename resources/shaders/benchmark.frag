@@ -0,0 +1,24 @@
+#version 330 core
+#include "atmosphere.glsl"
+
+// e_ : Earth coordinate system (Earth centric, z up at the camera position)
+
+// Renders the solar sky radiance seen from e_CameraPos in all directions, with
+// an equirectangular projection (used to compare the texture resolution tiers)
+
+in vec2 TexCoord;
+
+uniform vec3 e_CameraPos;
+uniform vec3 e_SunDir;
+
+out vec4 Color;
+
+void main()
+{
+    float azimuth = 2.0 * PI * TexCoord.x;
+    float zenith = PI * (1.0 - TexCoord.y);
+    vec3 e_ViewDir = vec3(sin(zenith) * cos(azimuth), sin(zenith) * sin(azimuth), cos(zenith));
+    vec3 transmittance;
+    vec3 radiance = GetSolarSkyRadiance(e_CameraPos, e_ViewDir, 0.0, e_SunDir, transmittance);
+    Color = vec4(radiance, 1.0);
+}
\ No newline at end of file
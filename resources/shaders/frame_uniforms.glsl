@@ -0,0 +1,14 @@
+// Camera and celestial data of the frame, shared by all the programs and
+// written once per frame by PhysicalSky (see PhysicalSky::FrameUniforms)
+layout(std140) uniform FrameUniforms
+{
+    mat4 View;
+    mat4 Projection;
+    mat4 WorldFromView;
+    mat4 ViewFromClip;
+    vec3 w_CameraPos;
+    vec3 w_EarthCenterPos;
+    vec3 w_SunDir;
+    vec3 w_MoonDir;
+    mat4 EquatorialFromWorld; // Rotations computed in double precision (see AstronomicalPositioning::Transforms)
+};
\ No newline at end of file
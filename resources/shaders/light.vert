@@ -1,10 +1,9 @@
 #version 330 core
+#include "frame_uniforms.glsl"
 
 layout (location = 0) in vec3 Pos;
 
 uniform mat4 Model;
-uniform mat4 View;
-uniform mat4 Projection;
 
 void main()
 {
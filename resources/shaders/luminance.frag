@@ -0,0 +1,40 @@
+#version 330 core
+
+const mat3 XYZ_from_RGB = mat3(vec3(0.4124, 0.2126, 0.0193), vec3(0.3576, 0.7152, 0.1192), vec3(0.1805, 0.0722, 0.9505));
+
+uniform sampler2D hdrTexture;
+uniform int ReducedSize;
+
+layout (location = 0) out vec4 Photopic; // Sum of log luminances, minimum, maximum and number of texels
+layout (location = 1) out vec4 Scotopic;
+
+float scotopic_luminance_from_XYZ(vec3 XYZ)
+{
+    if (XYZ.x <= 0.0) return 0.0;
+    return max(XYZ.y * (1.33 * (1.0 + (XYZ.y + XYZ.z) / XYZ.x) - 1.68), 0.0);
+}
+
+// Each fragment reduces a block of texels of the HDR texture
+void main()
+{
+    ivec2 size = textureSize(hdrTexture, 0);
+    ivec2 blockSize = (size + ReducedSize - 1) / ReducedSize;
+    ivec2 blockStart = ivec2(gl_FragCoord.xy) * blockSize;
+    ivec2 blockEnd = min(blockStart + blockSize, size);
+
+    Photopic = vec4(0.0, 1e30, 0.0, 0.0);
+    Scotopic = vec4(0.0, 1e30, 0.0, 0.0);
+    for (int y = blockStart.y; y < blockEnd.y; ++y)
+    {
+        for (int x = blockStart.x; x < blockEnd.x; ++x)
+        {
+            vec3 XYZ = XYZ_from_RGB * texelFetch(hdrTexture, ivec2(x, y), 0).rgb;
+            float Y = max(XYZ.y, 0.0);
+            float V = scotopic_luminance_from_XYZ(XYZ);
+            Photopic += vec4(log(Y + 1e-12), 0.0, 0.0, 1.0);
+            Photopic.yz = vec2(min(Photopic.y, Y), max(Photopic.z, Y));
+            Scotopic += vec4(log(V + 1e-12), 0.0, 0.0, 1.0);
+            Scotopic.yz = vec2(min(Scotopic.y, V), max(Scotopic.z, V));
+        }
+    }
+}
\ No newline at end of file
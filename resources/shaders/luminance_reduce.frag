@@ -0,0 +1,29 @@
+#version 330 core
+
+uniform sampler2D PhotopicTexture;
+uniform sampler2D ScotopicTexture;
+
+layout (location = 0) out vec4 Photopic; // Sum of log luminances, minimum, maximum and number of texels
+layout (location = 1) out vec4 Scotopic;
+
+vec4 combine(vec4 a, vec4 b)
+{
+    return vec4(a.x + b.x, min(a.y, b.y), max(a.z, b.z), a.w + b.w);
+}
+
+// Each fragment reduces a block of 4x4 texels of the previous level
+void main()
+{
+    ivec2 blockStart = ivec2(gl_FragCoord.xy) * 4;
+
+    Photopic = vec4(0.0, 1e30, 0.0, 0.0);
+    Scotopic = vec4(0.0, 1e30, 0.0, 0.0);
+    for (int y = 0; y < 4; ++y)
+    {
+        for (int x = 0; x < 4; ++x)
+        {
+            Photopic = combine(Photopic, texelFetch(PhotopicTexture, blockStart + ivec2(x, y), 0));
+            Scotopic = combine(Scotopic, texelFetch(ScotopicTexture, blockStart + ivec2(x, y), 0));
+        }
+    }
+}
\ No newline at end of file
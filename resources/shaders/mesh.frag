@@ -1,10 +1,7 @@
 #version 330 core
 #include "atmosphere.glsl"
+#include "frame_uniforms.glsl"
 
-uniform vec3 w_CameraPos;
-uniform vec3 w_EarthCenterPos;
-uniform vec3 w_SunDir;
-uniform vec3 w_MoonDir;
 const vec3 Albedo = vec3(0.5);
 
 uniform vec3 w_LightPos;
@@ -1,4 +1,5 @@
 #version 330 core
+#include "frame_uniforms.glsl"
 
 // m_ : Model coordinate system
 // w_ : World coordinate system
@@ -10,8 +11,6 @@ layout (location = 0) in vec3 m_Pos;
 layout (location = 1) in vec3 m_Normal;
 
 uniform mat4 Model;
-uniform mat4 View;
-uniform mat4 Projection;
 
 out vec3 w_Pos;
 out vec3 w_Normal;
@@ -1,5 +1,6 @@
 #version 330 core
 #include "atmosphere.glsl"
+#include "frame_uniforms.glsl"
 
 // m_ : Model Space
 // w_ : World Space
@@ -15,11 +16,7 @@ const vec3 Albedo = 0.072 * vec3(1.2525, 1.04125, 0.8625);
 in vec2 TexCoord;
 
 uniform mat4 Model;
-uniform vec3 w_SunDir;
-uniform vec3 w_MoonDir;
 uniform vec3 w_EarthDir;
-uniform vec3 w_CameraPos;
-uniform vec3 w_PlanetPos;
 uniform float EarthIrradiance;
 uniform float SunIrradiance;
 
@@ -125,7 +122,7 @@ void main()
 
     vec3 p_SunDir = w_SunDir;
     vec3 p_MoonDir = w_MoonDir;
-    vec3 p_CameraPos = w_CameraPos - w_PlanetPos;
+    vec3 p_CameraPos = w_CameraPos - w_EarthCenterPos;
     vec3 p_ViewDir = -V;
 
     vec3 transmittance;
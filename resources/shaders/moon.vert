@@ -1,15 +1,15 @@
 #version 330 core
+#include "frame_uniforms.glsl"
 
 layout (location = 0) in vec3 m_Pos;
 
 uniform mat4 Model;
-uniform mat4 View;
-uniform mat4 Projection;
 
 out vec2 TexCoord;
 
 void main()
 {
     gl_Position = Projection * View * Model * vec4(m_Pos.xy, 0.0, 1.0);
+    gl_Position.z = gl_Position.w; // At the far plane, behind any geometry
     TexCoord = m_Pos.xy;
 }
\ No newline at end of file
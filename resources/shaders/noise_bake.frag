@@ -0,0 +1,23 @@
+#version 330 core
+#include "psrdnoise2.glsl"
+
+in vec2 TexCoord;
+
+uniform float Period; // Of the tile, in noise units
+uniform float Alpha; // Rotation of the gradients of this layer
+
+out vec4 FragColor;
+
+// Same octaves as the analytic noise of the postprocess, but scaled by 2 and offset instead of rotated, so that all of them tile with the volume
+void main()
+{
+    vec2 x = TexCoord * Period;
+    vec2 period = vec2(Period);
+    vec2 ignore;
+    float result = 0.0;
+    result  = 0.5000 * psrdnoise(x, period, Alpha, ignore);                            x *= 2.0; period *= 2.0;
+    result += 0.2500 * psrdnoise(x + vec2(17.0, 31.0), period, Alpha, ignore);        x *= 2.0; period *= 2.0;
+    result += 0.1250 * psrdnoise(x + vec2(47.0, 13.0), period, Alpha, ignore);        x *= 2.0; period *= 2.0;
+    result += 0.0625 * psrdnoise(x + vec2(71.0, 59.0), period, Alpha, ignore);
+    FragColor = vec4(result, 0.0, 0.0, 1.0);
+}
\ No newline at end of file
@@ -17,6 +17,9 @@ uniform vec3 C_blue;
 uniform float NoiseScale;
 uniform float NoiseStrength;
 uniform float NoiseSpeed;
+uniform bool UseNoiseVolume;
+uniform sampler3D NoiseVolume; // Tiling in x, y and the rotation of the gradients
+uniform float NoiseVolumePeriod; // In noise units
 uniform vec3 MesopicRange;
 
 uniform int Mode;
@@ -67,6 +70,13 @@ vec3 XYZ_from_linear(vec3 linear)
 float compute_noise(vec2 texCoord)
 {
     texCoord *= NoiseScale;
+    if (UseNoiseVolume)
+    {
+        const float TWO_PI = 6.28318530718;
+        vec3 uvw = vec3(texCoord / NoiseVolumePeriod, fract(Time * NoiseSpeed / TWO_PI));
+        return texture(NoiseVolume, uvw).r * NoiseStrength;
+    }
+
     const mat2 m = mat2(1.6,  1.2, -1.2,  1.6); // See: https://www.shadertoy.com/view/lsf3WH
     vec2 ignore;
     float result = 0.0;
@@ -79,10 +89,16 @@ float compute_noise(vec2 texCoord)
 
 vec3 mode_selection(vec3 C_d)
 {
+    if (Mode == MODE_DAY) return C_d;
+
     vec3 C_d_XYZ = XYZ_from_linear(C_d);
 
     float Y_d = photopic_luminance_from_XYZ(C_d_XYZ);
     float V_d = scotopic_luminance_from_XYZ(C_d_XYZ);
+    if (Mode == MODE_PHOTOPIC_LUMINANCE) return vec3(Y_d);
+    if (Mode == MODE_SCOTOPIC_LUMINANCE) return vec3(V_d);
+
+    // MODE_NIGHT, the only one paying for the noise
     float noise = compute_noise(TexCoord * vec2(AspectRatio, 1.0));
 
     vec3 C_n = (V_d + noise) * C_blue;
@@ -93,14 +109,7 @@ vec3 mode_selection(vec3 C_d)
     float n = 1.0 - (x - l) / (r - l); // Different from the smoothstep used in Jonas07
 
     vec3 C_f = mix(C_d, C_n, n);
-
-    switch (Mode)
-    {
-        case MODE_DAY:                  return C_d;
-        case MODE_NIGHT:                return C_f;
-        case MODE_PHOTOPIC_LUMINANCE:   return vec3(Y_d);
-        case MODE_SCOTOPIC_LUMINANCE:   return vec3(V_d);
-    }
+    return C_f;
 }
 
 void main()
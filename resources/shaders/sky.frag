@@ -1,5 +1,7 @@
 #version 330 core
 #include "atmosphere.glsl"
+#include "frame_uniforms.glsl"
+#include "sky_view.glsl"
 
 // m_ : Model coordinate system
 // w_ : World coordinate system
@@ -9,53 +11,17 @@
 
 in vec3 w_ViewDir;
 
-uniform vec3 w_CameraPos;
-uniform vec3 w_EarthCenterPos;
-uniform vec3 w_SunDir;
-uniform vec3 w_MoonDir;
-
 uniform sampler2D StarsMap;
 uniform float StarsMapMultiplier;
 
 uniform sampler2D MilkywayMap;
 uniform float MilkywayMapMultiplier;
 
-uniform float T;
-uniform float lon;
-uniform float lat;
+uniform bool UseSkyViewLut;
+uniform sampler2D SkyViewLut;
 
 out vec4 Color;
 
-mat3 Rx(float a)
-{
-    float sa = sin(a);
-    float ca = cos(a);
-    return mat3(vec3(1.0, 0.0, 0.0), vec3(0.0, ca, sa), vec3(0.0, -sa, ca));
-}
-
-mat3 Ry(float a)
-{
-    float sa = sin(a);
-    float ca = cos(a);
-    return mat3(vec3(ca, 0.0, -sa), vec3(0.0, 1.0, 0.0), vec3(sa, 0.0, ca));
-}
-
-mat3 Rz(float a)
-{
-    float sa = sin(a);
-    float ca = cos(a);
-    return mat3(vec3(ca, sa, 0.0), vec3(-sa, ca, 0.0), vec3(0.0, 0.0, 1.0));
-}
-
-vec3 RectangularHorizonToRectangularEquatorial(vec3 rectangularHorizon)
-{
-    float LMST = 4.894961 + 230121.675315 * T + lon;
-    mat3 P = Rz(-0.01118*T) * Ry(0.00972*T) * Rz(-0.01118*T);
-    mat3 M = P * Rz(LMST) * Ry(PI/2.0 - lat);
-    vec3 rectangularEquatorial = M * rectangularHorizon;
-    return rectangularEquatorial;
-}
-
 vec3 SphericalToRectangular(vec3 spherical)
 {
     float lon = spherical.x;
@@ -76,11 +42,6 @@ vec3 RectangularToSpherical(vec3 rectangular)
     return vec3(lon, lat, r);
 }
 
-vec3 WorldToHorizon(vec3 world)
-{
-    return vec3(world.z, world.x, world.y);
-}
-
 void main()
 {
     vec3 e_CameraPos = w_CameraPos - w_EarthCenterPos;
@@ -88,8 +49,7 @@ void main()
     vec3 e_SunDir = w_SunDir;
     vec3 e_MoonDir = w_MoonDir;
 
-    vec3 rh_ViewDir = WorldToHorizon(e_ViewDir);
-    vec3 re_ViewDir = RectangularHorizonToRectangularEquatorial(rh_ViewDir);
+    vec3 re_ViewDir = mat3(EquatorialFromWorld) * e_ViewDir;
     vec3 se_ViewDir = RectangularToSpherical(re_ViewDir);
     vec2 uv = vec2(0.5, 1.0) - se_ViewDir.xy / vec2(2.0 * PI, PI);
 
@@ -98,10 +58,15 @@ void main()
     radiance += texture(StarsMap, uv).rgb * StarsMapMultiplier;
     radiance += texture(MilkywayMap, uv).rgb * MilkywayMapMultiplier;
 
-    vec3 transmittance;
-    vec3 solarSkyInscatter = GetSolarSkyRadiance(e_CameraPos, e_ViewDir, 0.0, e_SunDir, transmittance);
-    vec3 lunarSkyInscatter = GetLunarSkyRadiance(e_CameraPos, e_ViewDir, 0.0, e_MoonDir, transmittance);
-    vec3 inscatter = solarSkyInscatter + lunarSkyInscatter;
+    vec3 inscatter;
+    if (UseSkyViewLut) inscatter = texture(SkyViewLut, SkyViewUvFromDirection(e_CameraPos, e_ViewDir)).rgb;
+    else
+    {
+        vec3 transmittance;
+        vec3 solarSkyInscatter = GetSolarSkyRadiance(e_CameraPos, e_ViewDir, 0.0, e_SunDir, transmittance);
+        vec3 lunarSkyInscatter = GetLunarSkyRadiance(e_CameraPos, e_ViewDir, 0.0, e_MoonDir, transmittance);
+        inscatter = solarSkyInscatter + lunarSkyInscatter;
+    }
     vec3 result = radiance + inscatter;
 
     Color = vec4(result, 1.0);
@@ -1,4 +1,5 @@
 #version 330 core
+#include "frame_uniforms.glsl"
 
 // m_ : Model coordinate system
 // w_ : World coordinate system
@@ -8,13 +9,10 @@
 
 layout(location = 0) in vec4 Pos;
 
-uniform mat4 WorldFromView;
-uniform mat4 ViewFromClip;
-
 out vec3 w_ViewDir;
 
 void main()
 {
     w_ViewDir = (WorldFromView * vec4((ViewFromClip * Pos).xyz, 0.0)).xyz;
-    gl_Position = Pos;
+    gl_Position = Pos.xyww; // At the far plane
 }
\ No newline at end of file
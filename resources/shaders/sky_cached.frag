@@ -0,0 +1,15 @@
+#version 330 core
+
+// w_ : World coordinate system
+
+in vec3 w_ViewDir;
+
+uniform samplerCube SkyCubemap;
+
+out vec4 Color;
+
+// Sky (atmosphere, stars and Milky Way) rendered by sky.frag into the cubemap
+void main()
+{
+    Color = vec4(texture(SkyCubemap, normalize(w_ViewDir)).rgb, 1.0);
+}
\ No newline at end of file
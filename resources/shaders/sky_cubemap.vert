@@ -0,0 +1,15 @@
+#version 330 core
+
+// w_ : World coordinate system
+
+layout(location = 0) in vec4 Pos;
+
+uniform mat3 WorldFromFace; // Maps (s, t, 1) to the direction of a texel of the cubemap face being rendered
+
+out vec3 w_ViewDir;
+
+void main()
+{
+    w_ViewDir = WorldFromFace * vec3(Pos.xy, 1.0);
+    gl_Position = Pos;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+// Parameterization of the sky-view LUT (Hillaire 2020, "A Scalable and
+// Production Ready Sky and Atmosphere Rendering Technique"): the horizontal
+// coordinate is the azimuth of the view direction and the vertical one its
+// zenith angle, distributed quadratically on both sides of the horizon, where
+// the radiance of the sky changes the fastest. Requires atmosphere.glsl.
+
+uniform float BottomRadius; // km
+
+// Tangent frame at the camera, matching the world axes for a camera above the earth center
+void SkyViewFrame(vec3 e_CameraPos, out vec3 up, out vec3 x, out vec3 z)
+{
+    up = normalize(e_CameraPos);
+    x = normalize(cross(up, vec3(0.0, 0.0, 1.0)));
+    z = cross(x, up);
+}
+
+float SkyViewHorizonZenithAngle(vec3 e_CameraPos)
+{
+    float r = max(length(e_CameraPos), BottomRadius);
+    return PI - asin(BottomRadius / r);
+}
+
+vec2 SkyViewUvFromDirection(vec3 e_CameraPos, vec3 e_ViewDir)
+{
+    vec3 up, x, z;
+    SkyViewFrame(e_CameraPos, up, x, z);
+    float horizonZenith = SkyViewHorizonZenithAngle(e_CameraPos);
+    float zenith = acos(clamp(dot(e_ViewDir, up), -1.0, 1.0));
+
+    float v;
+    if (zenith < horizonZenith) v = 0.5 - 0.5 * sqrt(max(1.0 - zenith / horizonZenith, 0.0));
+    else v = 0.5 + 0.5 * sqrt(max((zenith - horizonZenith) / (PI - horizonZenith), 0.0));
+    float u = atan(dot(e_ViewDir, z), dot(e_ViewDir, x)) / (2.0 * PI) + 0.5;
+    return vec2(u, v);
+}
+
+vec3 SkyViewDirectionFromUv(vec3 e_CameraPos, vec2 uv)
+{
+    vec3 up, x, z;
+    SkyViewFrame(e_CameraPos, up, x, z);
+    float horizonZenith = SkyViewHorizonZenithAngle(e_CameraPos);
+
+    float zenith;
+    if (uv.y < 0.5)
+    {
+        float coord = 1.0 - 2.0 * uv.y;
+        zenith = horizonZenith * (1.0 - coord * coord);
+    }
+    else
+    {
+        float coord = 2.0 * uv.y - 1.0;
+        zenith = horizonZenith + coord * coord * (PI - horizonZenith);
+    }
+    float azimuth = (uv.x - 0.5) * 2.0 * PI;
+    return up * cos(zenith) + sin(zenith) * (x * cos(azimuth) + z * sin(azimuth));
+}
\ No newline at end of file
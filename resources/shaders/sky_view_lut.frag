@@ -0,0 +1,23 @@
+#version 330 core
+#include "atmosphere.glsl"
+#include "frame_uniforms.glsl"
+#include "sky_view.glsl"
+
+// e_ : Earth coordinate system (Earth centric coordinate space, analogous to world space shifted so that the earth center is at the origin)
+
+in vec2 TexCoord;
+
+out vec4 Color;
+
+// Radiance of the atmosphere (without the stars) in the direction of each texel of the sky-view LUT
+void main()
+{
+    vec3 e_CameraPos = w_CameraPos - w_EarthCenterPos;
+    vec3 e_ViewDir = SkyViewDirectionFromUv(e_CameraPos, TexCoord);
+
+    vec3 transmittance;
+    vec3 solarSkyInscatter = GetSolarSkyRadiance(e_CameraPos, e_ViewDir, 0.0, w_SunDir, transmittance);
+    vec3 lunarSkyInscatter = GetLunarSkyRadiance(e_CameraPos, e_ViewDir, 0.0, w_MoonDir, transmittance);
+
+    Color = vec4(solarSkyInscatter + lunarSkyInscatter, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330 core
+
+layout(location = 0) in vec4 Pos;
+
+out vec2 TexCoord;
+
+void main()
+{
+    TexCoord = Pos.xy * 0.5 + 0.5;
+    gl_Position = Pos;
+}
\ No newline at end of file
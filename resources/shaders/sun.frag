@@ -1,5 +1,6 @@
 #version 330 core
 #include "atmosphere.glsl"
+#include "frame_uniforms.glsl"
 
 // m_ : Model coordinate system
 // w_ : World coordinate system
@@ -10,11 +11,6 @@
 in vec2 TexCoord;
 in vec3 w_Pos;
 
-uniform vec3 w_CameraPos;
-uniform vec3 w_EarthCenterPos;
-uniform vec3 w_SunDir;
-uniform vec3 w_MoonDir;
-
 #define LIMB_DARKENING_NONE 0
 #define LIMB_DARKENING_NEC96 1
 #define LIMB_DARKENING_HM98 2
@@ -1,10 +1,9 @@
 #version 330 core
+#include "frame_uniforms.glsl"
 
 layout (location = 0) in vec3 m_Pos;
 
 uniform mat4 Model;
-uniform mat4 View;
-uniform mat4 Projection;
 
 out vec2 TexCoord;
 out vec3 w_Pos;
@@ -14,4 +13,5 @@ void main()
     TexCoord = m_Pos.xy;
     w_Pos = (Model * vec4(m_Pos.xy, 0.0, 1.0)).xyz;
     gl_Position = Projection * View * vec4(w_Pos, 1.0);
+    gl_Position.z = gl_Position.w; // At the far plane, behind any geometry
 }
\ No newline at end of file